@@ -20,6 +20,9 @@
 #include <vector>
 #include <limits>
 #include <cmath>
+#include <cfloat>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -47,6 +50,74 @@ using namespace std;
 using namespace boost;
 namespace fs = boost::filesystem;
 
+static const char CALIB_CACHE_MAGIC[ 8 ] = { 'G', 'C', 'C', 'A', 'L', 'I', 'B', '\0' };
+// The cache is keyed on the size and checksum of the json it was made from, not on the code
+// that turned the json into the model. Bump CALIB_CACHE_VERSION whenever the header or record
+// layout changes or the json to model parsing in Load() changes what ends up in the cached
+// fields (the grid points, search lines or search regions), otherwise stale caches are used.
+static const uint32_t CALIB_CACHE_VERSION = 1;
+static const std::string CALIB_CACHE_EXTENSION = ".bin";
+
+// Fixed layout header of the binary calibration cache. It is followed by pointCount records of
+// four doubles (pixelX, pixelY, worldX, worldY) and searchLineCount records of four int32_t
+// (topX, topY, botX, botY). Every field is naturally aligned, so the file can be used in place
+// from a memory map or a single read. Values are in host byte order, which the magic and
+// version checks guard along with the checksums.
+struct CalibCacheHeader
+{
+    char magic[ 8 ];
+    uint32_t version;
+    uint32_t pointCount;
+    uint32_t searchLineCount;
+    int32_t imgWidth;
+    int32_t imgHeight;
+    int32_t gridCols;
+    int32_t gridRows;
+    int32_t moveSearchLft[ 4 ];
+    int32_t moveSearchRgt[ 4 ];
+    uint32_t reserved;
+    uint64_t jsonSize;
+    uint64_t jsonChecksum;
+    uint64_t payloadChecksum;
+    double homogPixToWorld[ 9 ];
+    double homogWorldToPix[ 9 ];
+};
+static_assert( sizeof( CalibCacheHeader ) == 240, "Calibration cache header layout changed" );
+
+// 64-bit FNV-1a hash used to tie the cache to the json it was created from
+static uint64_t CacheChecksum( const char *data, const size_t len, uint64_t hash = 14695981039346656037ULL )
+{
+    for ( size_t i = 0; i < len; ++i )
+    {
+        hash ^= static_cast< uint8_t >( data[ i ] );
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Applies a 3x3 CV_64F homography to a run of points with the arithmetic of cv::perspectiveTransform(),
+// but without the per call vector and InputArray setup. The input and output may be the same array.
+static inline void TransformPoints( const Mat &matHomog, const Point2d *ptsIn, Point2d *ptsOut, const size_t count )
+{
+    const double *m = matHomog.ptr< double >( 0 );
+    for ( size_t i = 0; i < count; ++i )
+    {
+        const double x = ptsIn[ i ].x;
+        const double y = ptsIn[ i ].y;
+        double w = x * m[ 6 ] + y * m[ 7 ] + m[ 8 ];
+        if ( fabs( w ) > FLT_EPSILON )
+        {
+            w = 1.0 / w;
+            ptsOut[ i ].x = ( x * m[ 0 ] + y * m[ 1 ] + m[ 2 ] ) * w;
+            ptsOut[ i ].y = ( x * m[ 3 ] + y * m[ 4 ] + m[ 5 ] ) * w;
+        }
+        else
+        {
+            ptsOut[ i ].x = ptsOut[ i ].y = 0.0;
+        }
+    }
+}
+
 namespace gc
 {
 
@@ -241,63 +312,53 @@ GC_STATUS Calib::Calibrate( const vector< Point2d > pixelPts, const vector< Poin
     }
     return retVal;
 }
-GC_STATUS Calib::PixelToWorld( const Point2d ptPixel, Point2d &ptWorld )
+GC_STATUS Calib::PixelToWorld( const Point2d ptPixel, Point2d &ptWorld ) const
+{
+    return PixelToWorld( &ptPixel, &ptWorld, 1 );
+}
+GC_STATUS Calib::WorldToPixel( const Point2d ptWorld, Point2d &ptPixel ) const
 {
-    if ( m_matHomogPixToWorld.empty() )
+    return WorldToPixel( &ptWorld, &ptPixel, 1 );
+}
+GC_STATUS Calib::PixelToWorld( const Point2d *ptsPixel, Point2d *ptsWorld, const size_t count ) const
+{
+    if ( m_matHomogPixToWorld.empty() || CV_64FC1 != m_matHomogPixToWorld.type() )
     {
         FILE_LOG( logERROR ) << "[" << __func__ << "][Calib::PixelToWorld] No calibration for pixel to world conversion";
         return GC_ERR;
     }
-
-    GC_STATUS retVal = GC_OK;
-
-    try
-    {
-        vector< Point2d > vecIn, vecOut;
-        vecIn.push_back( ptPixel );
-        perspectiveTransform( vecIn, vecOut, m_matHomogPixToWorld );
-        ptWorld = vecOut[ 0 ];
-    }
-    catch( Exception &e )
+    else if ( 0 < count && ( nullptr == ptsPixel || nullptr == ptsWorld ) )
     {
-        FILE_LOG( logERROR ) << "[" << __func__ << "][Calib::PixelToWorld] " << e.what();
-        return GC_EXCEPT;
+        FILE_LOG( logERROR ) << "[" << __func__ << "][Calib::PixelToWorld] Null point array for pixel to world conversion";
+        return GC_ERR;
     }
 
-    return retVal;
+    TransformPoints( m_matHomogPixToWorld, ptsPixel, ptsWorld, count );
+    return GC_OK;
 }
-GC_STATUS Calib::WorldToPixel( const Point2d ptWorld, Point2d &ptPixel )
+GC_STATUS Calib::WorldToPixel( const Point2d *ptsWorld, Point2d *ptsPixel, const size_t count ) const
 {
-    if ( m_matHomogWorldToPix.empty() )
+    if ( m_matHomogWorldToPix.empty() || CV_64FC1 != m_matHomogWorldToPix.type() )
     {
         FILE_LOG( logERROR ) << "[" << __func__ << "][Calib::WorldToPixel]"
                                 "No calibration for world to pixel conversion";
         return GC_ERR;
     }
-
-    GC_STATUS retVal = GC_OK;
-
-    try
-    {
-        vector< Point2d > vecIn, vecOut;
-        vecIn.push_back( ptWorld );
-        perspectiveTransform( vecIn, vecOut, m_matHomogWorldToPix );
-        ptPixel = vecOut[ 0 ];
-    }
-    catch( Exception &e )
+    else if ( 0 < count && ( nullptr == ptsWorld || nullptr == ptsPixel ) )
     {
-        FILE_LOG( logERROR ) << "[" << __func__ << "][Calib::WorldToPixel] " << e.what();
-        return GC_EXCEPT;
+        FILE_LOG( logERROR ) << "[" << __func__ << "][Calib::WorldToPixel] Null point array for world to pixel conversion";
+        return GC_ERR;
     }
 
-    return retVal;
+    TransformPoints( m_matHomogWorldToPix, ptsWorld, ptsPixel, count );
+    return GC_OK;
 }
-cv::Rect Calib::MoveSearchROI( const bool isLeft )
+cv::Rect Calib::MoveSearchROI( const bool isLeft ) const
 {
     return isLeft ? m_model.moveSearchRegionLft :
                     m_model.moveSearchRegionRgt;
 }
-cv::Point2d Calib::MoveRefPoint( const bool isLeft )
+cv::Point2d Calib::MoveRefPoint( const bool isLeft ) const
 {
     Point2d pt( numeric_limits< double >::min(), numeric_limits< double >::min() );
     if ( m_model.pixelPoints.empty() )
@@ -331,8 +392,23 @@ GC_STATUS Calib::Load( const string jsonCalFilepath )
 
     try
     {
+        // the json is read once to checksum it, a matching binary cache is used instead of parsing it
+        ifstream jsonStream( jsonCalFilepath, ios::in | ios::binary );
+        if ( !jsonStream.is_open() )
+        {
+            FILE_LOG( logERROR ) << "[Calib::Load] Could not open " << jsonCalFilepath;
+            return GC_ERR;
+        }
+        string jsonText( ( istreambuf_iterator< char >( jsonStream ) ), istreambuf_iterator< char >() );
+        jsonStream.close();
+        uint64_t jsonChecksum = CacheChecksum( jsonText.data(), jsonText.size() );
+        string cacheFilepath = jsonCalFilepath + CALIB_CACHE_EXTENSION;
+        if ( GC_OK == LoadCache( cacheFilepath, jsonText.size(), jsonChecksum ) )
+            return GC_OK;
+
         property_tree::ptree ptreeTop;
-        property_tree::json_parser::read_json( jsonCalFilepath, ptreeTop );
+        stringstream jsonTextStream( jsonText );
+        property_tree::json_parser::read_json( jsonTextStream, ptreeTop );
 
         m_imgSize.width = ptreeTop.get< int >( "imageWidth", 0 );
         m_imgSize.height = ptreeTop.get< int >( "imageHeight", 0 );
@@ -374,6 +450,8 @@ GC_STATUS Calib::Load( const string jsonCalFilepath )
             }
         }
 
+        // the search lines read here are stored in the calibration cache, bump CALIB_CACHE_VERSION
+        // if the way they are read or adjusted changes
         Point ptTop, ptBot;
         m_model.searchLines.clear();
         BOOST_FOREACH( property_tree::ptree::value_type &node, ptreeTop.get_child( "SearchLines" ) )
@@ -411,6 +489,11 @@ GC_STATUS Calib::Load( const string jsonCalFilepath )
 
             Mat matIn, matOut;
             retVal = Calibrate( m_model.pixelPoints, m_model.worldPoints, m_model.gridSize, m_imgSize, matIn, matOut, false, false );
+            if ( GC_OK == retVal )
+            {
+                // the folder of the json may be read-only or shared, a cache that cannot be written is skipped
+                SaveCache( cacheFilepath, jsonText.size(), jsonChecksum );
+            }
         }
 #ifdef LOG_CALIB_VALUES
         FILE_LOG( logINFO ) << "~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~" << endl;
@@ -432,6 +515,151 @@ GC_STATUS Calib::Load( const string jsonCalFilepath )
 
     return retVal;
 }
+GC_STATUS Calib::LoadCache( const string cacheFilepath, const uint64_t jsonSize, const uint64_t jsonChecksum )
+{
+    GC_STATUS retVal = GC_ERR;
+    try
+    {
+        ifstream cacheStream( cacheFilepath, ios::in | ios::binary );
+        if ( cacheStream.is_open() )
+        {
+            vector< char > buffer( ( istreambuf_iterator< char >( cacheStream ) ), istreambuf_iterator< char >() );
+            CalibCacheHeader header;
+            if ( sizeof( header ) <= buffer.size() )
+            {
+                memcpy( &header, buffer.data(), sizeof( header ) );
+                size_t pointBytes = static_cast< size_t >( header.pointCount ) * 4 * sizeof( double );
+                size_t lineBytes = static_cast< size_t >( header.searchLineCount ) * 4 * sizeof( int32_t );
+                const char *payload = buffer.data() + sizeof( header );
+                if ( 0 == memcmp( header.magic, CALIB_CACHE_MAGIC, sizeof( CALIB_CACHE_MAGIC ) ) &&
+                     CALIB_CACHE_VERSION == header.version && jsonSize == header.jsonSize && jsonChecksum == header.jsonChecksum &&
+                     buffer.size() == sizeof( header ) + pointBytes + lineBytes &&
+                     header.payloadChecksum == CacheChecksum( payload, pointBytes + lineBytes ) &&
+                     static_cast< uint64_t >( header.gridCols ) * static_cast< uint64_t >( header.gridRows ) == header.pointCount )
+                {
+                    m_model.clear();
+                    m_imgSize = Size( header.imgWidth, header.imgHeight );
+                    m_model.gridSize = Size( header.gridCols, header.gridRows );
+                    m_model.moveSearchRegionLft = Rect( header.moveSearchLft[ 0 ], header.moveSearchLft[ 1 ], header.moveSearchLft[ 2 ], header.moveSearchLft[ 3 ] );
+                    m_model.moveSearchRegionRgt = Rect( header.moveSearchRgt[ 0 ], header.moveSearchRgt[ 1 ], header.moveSearchRgt[ 2 ], header.moveSearchRgt[ 3 ] );
+                    m_matHomogPixToWorld = Mat( 3, 3, CV_64FC1, header.homogPixToWorld ).clone();
+                    m_matHomogWorldToPix = Mat( 3, 3, CV_64FC1, header.homogWorldToPix ).clone();
+
+                    double pt[ 4 ];
+                    for ( size_t i = 0; i < header.pointCount; ++i )
+                    {
+                        memcpy( pt, payload + i * sizeof( pt ), sizeof( pt ) );
+                        m_model.pixelPoints.push_back( Point2d( pt[ 0 ], pt[ 1 ] ) );
+                        m_model.worldPoints.push_back( Point2d( pt[ 2 ], pt[ 3 ] ) );
+                    }
+                    int32_t ends[ 4 ];
+                    for ( size_t i = 0; i < header.searchLineCount; ++i )
+                    {
+                        memcpy( ends, payload + pointBytes + i * sizeof( ends ), sizeof( ends ) );
+                        m_model.searchLines.push_back( LineEnds( Point( ends[ 0 ], ends[ 1 ] ), Point( ends[ 2 ], ends[ 3 ] ) ) );
+                    }
+                    // the swath table is not cached, it is rebuilt from the cached search lines
+                    retVal = CalcSwathTable();
+                }
+            }
+        }
+    }
+    catch( std::exception &e )
+    {
+        FILE_LOG( logWARNING ) << "[Calib::LoadCache] " << e.what();
+        retVal = GC_EXCEPT;
+    }
+
+    return retVal;
+}
+GC_STATUS Calib::SaveCache( const string cacheFilepath, const uint64_t jsonSize, const uint64_t jsonChecksum )
+{
+    GC_STATUS retVal = GC_OK;
+    if ( m_matHomogPixToWorld.empty() || m_matHomogWorldToPix.empty() ||
+         CV_64FC1 != m_matHomogPixToWorld.type() || CV_64FC1 != m_matHomogWorldToPix.type() ||
+         m_model.pixelPoints.size() != m_model.worldPoints.size() )
+    {
+        retVal = GC_ERR;
+    }
+    else
+    {
+        try
+        {
+            vector< char > payload;
+            double pt[ 4 ];
+            for ( size_t i = 0; i < m_model.pixelPoints.size(); ++i )
+            {
+                pt[ 0 ] = m_model.pixelPoints[ i ].x;
+                pt[ 1 ] = m_model.pixelPoints[ i ].y;
+                pt[ 2 ] = m_model.worldPoints[ i ].x;
+                pt[ 3 ] = m_model.worldPoints[ i ].y;
+                payload.insert( payload.end(), reinterpret_cast< char * >( pt ), reinterpret_cast< char * >( pt ) + sizeof( pt ) );
+            }
+            int32_t ends[ 4 ];
+            for ( size_t i = 0; i < m_model.searchLines.size(); ++i )
+            {
+                ends[ 0 ] = m_model.searchLines[ i ].top.x;
+                ends[ 1 ] = m_model.searchLines[ i ].top.y;
+                ends[ 2 ] = m_model.searchLines[ i ].bot.x;
+                ends[ 3 ] = m_model.searchLines[ i ].bot.y;
+                payload.insert( payload.end(), reinterpret_cast< char * >( ends ), reinterpret_cast< char * >( ends ) + sizeof( ends ) );
+            }
+
+            CalibCacheHeader header;
+            memset( &header, 0, sizeof( header ) );
+            memcpy( header.magic, CALIB_CACHE_MAGIC, sizeof( CALIB_CACHE_MAGIC ) );
+            header.version = CALIB_CACHE_VERSION;
+            header.pointCount = static_cast< uint32_t >( m_model.pixelPoints.size() );
+            header.searchLineCount = static_cast< uint32_t >( m_model.searchLines.size() );
+            header.imgWidth = m_imgSize.width;
+            header.imgHeight = m_imgSize.height;
+            header.gridCols = m_model.gridSize.width;
+            header.gridRows = m_model.gridSize.height;
+            const Rect &lft = m_model.moveSearchRegionLft;
+            const Rect &rgt = m_model.moveSearchRegionRgt;
+            int32_t moveLft[ 4 ] = { lft.x, lft.y, lft.width, lft.height };
+            int32_t moveRgt[ 4 ] = { rgt.x, rgt.y, rgt.width, rgt.height };
+            memcpy( header.moveSearchLft, moveLft, sizeof( moveLft ) );
+            memcpy( header.moveSearchRgt, moveRgt, sizeof( moveRgt ) );
+            header.jsonSize = jsonSize;
+            header.jsonChecksum = jsonChecksum;
+            header.payloadChecksum = CacheChecksum( payload.data(), payload.size() );
+            for ( int i = 0; i < 9; ++i )
+            {
+                header.homogPixToWorld[ i ] = m_matHomogPixToWorld.at< double >( i / 3, i % 3 );
+                header.homogWorldToPix[ i ] = m_matHomogWorldToPix.at< double >( i / 3, i % 3 );
+            }
+
+            // written beside the cache and renamed over it so a reader never sees a partial file
+            string tempFilepath = cacheFilepath + ".tmp";
+            ofstream cacheStream( tempFilepath, ios::out | ios::binary | ios::trunc );
+            if ( !cacheStream.is_open() )
+            {
+                retVal = GC_ERR;
+            }
+            else
+            {
+                cacheStream.write( reinterpret_cast< const char * >( &header ), sizeof( header ) );
+                cacheStream.write( payload.data(), static_cast< streamsize >( payload.size() ) );
+                cacheStream.close();
+                boost::system::error_code ec;
+                if ( !cacheStream.fail() )
+                    fs::rename( tempFilepath, cacheFilepath, ec );
+                if ( cacheStream.fail() || ec )
+                {
+                    fs::remove( tempFilepath, ec );
+                    retVal = GC_ERR;
+                }
+            }
+        }
+        catch( std::exception & )
+        {
+            retVal = GC_EXCEPT;
+        }
+    }
+
+    return retVal;
+}
 GC_STATUS Calib::Save( const string jsonCalFilepath )
 {
     GC_STATUS retVal = GC_OK;
@@ -519,6 +747,9 @@ GC_STATUS Calib::Save( const string jsonCalFilepath )
 
     return retVal;
 }
+// The search lines made here are written to the calibration json and from there to the
+// calibration cache. Bump CALIB_CACHE_VERSION if a change here alters what a cached search line
+// record holds, see LoadCache().
 GC_STATUS Calib::CalcSearchSwaths()
 {
     GC_STATUS retVal = GC_OK;
@@ -560,6 +791,8 @@ GC_STATUS Calib::CalcSearchSwaths()
                 ptBot.x += xIncBot;
                 ptBot.y += yInc;
             }
+
+            retVal = CalcSwathTable();
         }
         catch( boost::exception &e )
         {
@@ -570,7 +803,85 @@ GC_STATUS Calib::CalcSearchSwaths()
 
     return retVal;
 }
-string Calib::ModelJsonString()
+// Walks each search line with the same LineIterator FindLine::CalcRowSums used per frame, so
+// the gathered row sums are identical, and records the visited pixels as row-major offsets
+// into the search region
+GC_STATUS Calib::CalcSwathTable()
+{
+    GC_STATUS retVal = GC_OK;
+    try
+    {
+        m_swathTable.clear();
+        const vector< LineEnds > &lines = m_model.searchLines;
+        if ( !lines.empty() && 0 < m_imgSize.width && 0 < m_imgSize.height )
+        {
+            int lft = numeric_limits< int >::max();
+            int top = numeric_limits< int >::max();
+            int rgt = numeric_limits< int >::min();
+            int bot = numeric_limits< int >::min();
+            for ( size_t i = 0; i < lines.size(); ++i )
+            {
+                lft = std::min( lft, std::min( lines[ i ].top.x, lines[ i ].bot.x ) );
+                rgt = std::max( rgt, std::max( lines[ i ].top.x, lines[ i ].bot.x ) );
+                top = std::min( top, std::min( lines[ i ].top.y, lines[ i ].bot.y ) );
+                bot = std::max( bot, std::max( lines[ i ].top.y, lines[ i ].bot.y ) );
+            }
+
+            // the cleanup dilate and erode each reach half the kernel height per iteration up and down
+            int morphReach = ( GC_FINDLINE_MORPH_KERN_HEIGHT / 2 ) * GC_FINDLINE_MORPH_ITERATIONS * 2;
+            lft = std::max( 0, lft );
+            rgt = std::min( m_imgSize.width - 1, rgt );
+            top = std::max( 0, top - morphReach );
+            bot = std::min( m_imgSize.height - 1, bot + morphReach );
+            if ( lft <= rgt && top <= bot )
+            {
+                Rect roi( lft, top, rgt - lft + 1, bot - top + 1 );
+                Mat geometry( m_imgSize, CV_8UC1 );
+                size_t linesPerSwath = lines.size() / GC_SEARCH_SWATH_COUNT;
+
+                m_swathTable.sampleStart.push_back( 0 );
+                for ( size_t i = 0; i < GC_SEARCH_SWATH_COUNT; ++i )
+                {
+                    size_t start = i * linesPerSwath;
+                    size_t end = start + linesPerSwath;
+                    int height = lines[ start ].bot.y - lines[ start ].top.y;
+
+                    m_swathTable.lineStart.push_back( start );
+                    m_swathTable.lineEnd.push_back( end );
+                    m_swathTable.rowCount.push_back( static_cast< size_t >( std::max( 0, height ) ) );
+
+                    // swaths that run past the last search line are rejected by FindLine, so they get no samples
+                    if ( lines.size() > end )
+                    {
+                        for ( size_t j = start; j <= end; ++j )
+                        {
+                            LineIterator iter( geometry, lines[ j ].top, lines[ j ].bot );
+                            for ( int k = 0; k < std::min( height, iter.count ); ++k, ++iter )
+                            {
+                                Point pos = iter.pos();
+                                m_swathTable.offsets.push_back( static_cast< uint32_t >( ( pos.y - roi.y ) * roi.width + pos.x - roi.x ) );
+                                m_swathTable.bins.push_back( static_cast< uint32_t >( k ) );
+                            }
+                        }
+                    }
+                    m_swathTable.sampleStart.push_back( m_swathTable.offsets.size() );
+                }
+                m_swathTable.imgSize = m_imgSize;
+                m_swathTable.roi = roi;
+                m_swathTable.lines = lines;
+            }
+        }
+    }
+    catch( cv::Exception &e )
+    {
+        FILE_LOG( logERROR ) << "[" << __func__ << "][Calib::CalcSwathTable] " << e.what();
+        m_swathTable.clear();
+        retVal = GC_EXCEPT;
+    }
+
+    return retVal;
+}
+string Calib::ModelJsonString() const
 {
     stringstream ss;
 
@@ -120,6 +120,13 @@ public:
      *   ]
      * }
      * \endcode
+     *
+     * The parsed model is cached in a binary file beside the json file (the json filepath with
+     * .bin appended). The cache is used instead of the json when it exists and was created from
+     * json of the same size and checksum, otherwise it is recreated after the json is parsed.
+     * Writing the cache is best effort: when the folder of the json cannot be written, as with
+     * read-only config or install folders, the json is parsed on every load and nothing is logged.
+     *
      * @param jsonCalFilepath File to load
      * @see Load()
      * @return GC_OK=Success, GC_FAIL=Failure, GC_EXCEPT=Exception thrown
@@ -145,7 +152,7 @@ public:
      * @see PixelToWorld()
      * @return GC_OK=Success, GC_FAIL=Failure, GC_EXCEPT=Exception thrown
      */
-    GC_STATUS PixelToWorld( const cv::Point2d ptPixel, cv::Point2d &ptWorld );
+    GC_STATUS PixelToWorld( const cv::Point2d ptPixel, cv::Point2d &ptWorld ) const;
 
     /**
      * @brief WorldToPixel
@@ -154,39 +161,65 @@ public:
      * @see WorldToPixel()
      * @return GC_OK=Success, GC_FAIL=Failure, GC_EXCEPT=Exception thrown
      */
-    GC_STATUS WorldToPixel( const cv::Point2d ptWorld, cv::Point2d &ptPixel );
+    GC_STATUS WorldToPixel( const cv::Point2d ptWorld, cv::Point2d &ptPixel ) const;
+
+    /**
+     * @brief Convert an array of pixel points to world points in one call
+     * @param ptsPixel Array of pixel points to be converted
+     * @param ptsWorld Array of at least count points to hold the world points (may be ptsPixel)
+     * @param count Number of points to convert
+     * @see PixelToWorld()
+     * @return GC_OK=Success, GC_FAIL=Failure, GC_EXCEPT=Exception thrown
+     */
+    GC_STATUS PixelToWorld( const cv::Point2d *ptsPixel, cv::Point2d *ptsWorld, const size_t count ) const;
+
+    /**
+     * @brief Convert an array of world points to pixel points in one call
+     * @param ptsWorld Array of world points to be converted
+     * @param ptsPixel Array of at least count points to hold the pixel points (may be ptsWorld)
+     * @param count Number of points to convert
+     * @see WorldToPixel()
+     * @return GC_OK=Success, GC_FAIL=Failure, GC_EXCEPT=Exception thrown
+     */
+    GC_STATUS WorldToPixel( const cv::Point2d *ptsWorld, cv::Point2d *ptsPixel, const size_t count ) const;
 
     /**
      * @brief Returns the current calibration model properties as a json string
      * @return The json string of the calibration model
      */
-    std::string ModelJsonString();
+    std::string ModelJsonString() const;
 
     /**
      * @brief Returns the current calibration model object
      * @return The curren calibration model object
      */
-    CalibModel &GetModel() { return m_model; }
+    const CalibModel &GetModel() const { return m_model; }
 
     /**
      * @brief Retrieves one of the move search target regions
      * @param isLeft true=Return the left region, false=Return the right region
      * @return A cv::Rect object that holds the specified move search region
      */
-    cv::Rect MoveSearchROI( const bool isLeft );
+    cv::Rect MoveSearchROI( const bool isLeft ) const;
 
     /**
      * @brief Returns one of the move reference points
      * @param isLeft true=Return the left point, false=Return the right point
      * @return A cv::Point2d object that holds the specified move reference point
      */
-    cv::Point2d MoveRefPoint( const bool isLeft );
+    cv::Point2d MoveRefPoint( const bool isLeft ) const;
 
     /**
      * @brief Returns a vector of search lines along which an image is search for a water level line.
      * @return A vector of LineEnds that represent search lines
      */
-    std::vector< LineEnds > &SearchLines() { return m_model.searchLines; }
+    const std::vector< LineEnds > &SearchLines() const { return m_model.searchLines; }
+
+    /**
+     * @brief Returns the pixel sampling table of the search lines (calculated when the search lines are)
+     * @return A SearchSwathTable that holds the pixel offsets of the search line swaths
+     */
+    const SearchSwathTable &SwathTable() const { return m_swathTable; }
 
 private:
     cv::Mat m_matHomogPixToWorld;
@@ -194,8 +227,12 @@ private:
 
     cv::Size m_imgSize;
     CalibModel m_model;
+    SearchSwathTable m_swathTable;
 
     GC_STATUS CalcSearchSwaths();
+    GC_STATUS CalcSwathTable();
+    GC_STATUS LoadCache( const std::string cacheFilepath, const uint64_t jsonSize, const uint64_t jsonChecksum );
+    GC_STATUS SaveCache( const std::string cacheFilepath, const uint64_t jsonSize, const uint64_t jsonChecksum );
 };
 
 }   // namespace gc
@@ -0,0 +1,152 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+   Copyright 2021 Kenneth W. Chapman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include "log.h"
+#include "calibcache.h"
+#include <boost/filesystem.hpp>
+#include <boost/exception/diagnostic_information.hpp>
+
+using namespace std;
+using namespace boost;
+namespace fs = boost::filesystem;
+
+namespace gc
+{
+
+CalibCache::CalibCache( const size_t capacity ) :
+    m_capacity( 0 == capacity ? 1 : capacity )
+{
+}
+GC_STATUS CalibCache::Get( const string jsonCalFilepath, std::shared_ptr< const Calib > &calib )
+{
+    GC_STATUS retVal = GC_OK;
+    try
+    {
+        // a hit costs two stats of the json file, a missing file fails the first one
+        boost::system::error_code errCode;
+        time_t modTime = fs::last_write_time( jsonCalFilepath, errCode );
+        uintmax_t fileSize = errCode ? 0 : fs::file_size( jsonCalFilepath, errCode );
+        if ( errCode )
+        {
+            FILE_LOG( logERROR ) << "[CalibCache::Get] " << jsonCalFilepath << " does not exist";
+            retVal = GC_ERR;
+        }
+        else
+        {
+            if ( !Find( jsonCalFilepath, modTime, fileSize, calib ) )
+            {
+                // loads are done one at a time so threads that miss on the same calibration at once
+                // load it only once, the cache itself is not locked while the json file is parsed
+                std::lock_guard< std::mutex > loadLock( m_loadMutex );
+                if ( !Find( jsonCalFilepath, modTime, fileSize, calib ) )
+                {
+                    std::shared_ptr< Calib > calibLoaded = std::make_shared< Calib >();
+                    retVal = calibLoaded->Load( jsonCalFilepath );
+                    if ( GC_OK != retVal )
+                    {
+                        FILE_LOG( logERROR ) << "[CalibCache::Get] Could not load calibration " << jsonCalFilepath;
+                    }
+                    else
+                    {
+                        std::lock_guard< std::mutex > lock( m_mutex );
+                        ++m_stats.misses;
+                        auto found = m_index.find( jsonCalFilepath );
+                        if ( m_index.end() != found )
+                        {
+                            m_entries.erase( found->second );
+                            m_index.erase( found );
+                        }
+                        CacheEntry entry;
+                        entry.filepath = jsonCalFilepath;
+                        entry.modTime = modTime;
+                        entry.fileSize = fileSize;
+                        entry.calib = calibLoaded;
+                        m_entries.push_front( entry );
+                        m_index[ jsonCalFilepath ] = m_entries.begin();
+                        Trim();
+                        calib = calibLoaded;
+                    }
+                }
+            }
+        }
+    }
+    catch( boost::exception &e )
+    {
+        FILE_LOG( logERROR ) << "[CalibCache::Get] " << diagnostic_information( e );
+        retVal = GC_EXCEPT;
+    }
+    catch( std::exception &e )
+    {
+        FILE_LOG( logERROR ) << "[CalibCache::Get] " << e.what();
+        retVal = GC_EXCEPT;
+    }
+
+    return retVal;
+}
+GC_STATUS CalibCache::SetCapacity( const size_t capacity )
+{
+    GC_STATUS retVal = GC_OK;
+    if ( 0 == capacity )
+    {
+        FILE_LOG( logERROR ) << "[CalibCache::SetCapacity] Capacity must be one or more";
+        retVal = GC_ERR;
+    }
+    else
+    {
+        std::lock_guard< std::mutex > lock( m_mutex );
+        m_capacity = capacity;
+        Trim();
+    }
+    return retVal;
+}
+void CalibCache::Clear()
+{
+    std::lock_guard< std::mutex > lock( m_mutex );
+    m_index.clear();
+    m_entries.clear();
+}
+CalibCacheStats CalibCache::Stats()
+{
+    std::lock_guard< std::mutex > lock( m_mutex );
+    return m_stats;
+}
+bool CalibCache::Find( const string &jsonCalFilepath, const time_t modTime,
+                       const uintmax_t fileSize, std::shared_ptr< const Calib > &calib )
+{
+    bool isFound = false;
+    std::lock_guard< std::mutex > lock( m_mutex );
+    auto found = m_index.find( jsonCalFilepath );
+    if ( m_index.end() != found && modTime == found->second->modTime && fileSize == found->second->fileSize )
+    {
+        m_entries.splice( m_entries.begin(), m_entries, found->second );
+        calib = found->second->calib;
+        ++m_stats.hits;
+        isFound = true;
+    }
+    return isFound;
+}
+// must be called with m_mutex locked
+void CalibCache::Trim()
+{
+    while ( m_capacity < m_entries.size() )
+    {
+        m_index.erase( m_entries.back().filepath );
+        m_entries.pop_back();
+        ++m_stats.evictions;
+    }
+}
+
+} // namespace gc
@@ -0,0 +1,138 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+   Copyright 2021 Kenneth W. Chapman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/** \file calibcache.h
+ * @brief A class to hold the calibrations of several sites for reuse between images
+ *
+ * This file holds a thread safe, least recently used cache of loaded calibrations. It lets
+ * images from several sites be processed in any order without the calibration of each
+ * site being loaded again every time the site changes.
+ *
+ * \author Kenneth W. Chapman
+ * \copyright Copyright (C) 2010-2021, Kenneth W. Chapman <coffeesig@gmail.com>, all rights reserved.\n
+ * This project is released under the Apache License, Version 2.0.
+ * \bug No known bugs.
+ */
+
+#ifndef CALIBCACHE_H
+#define CALIBCACHE_H
+
+#include "gc_types.h"
+#include "calib.h"
+#include <ctime>
+#include <list>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace gc
+{
+
+static const size_t CALIB_CACHE_DEFAULT_CAPACITY = 8;      ///< Default number of calibrations held by a CalibCache
+
+/**
+ * @brief Counters of the use of a calibration cache
+ */
+class CalibCacheStats
+{
+public:
+    /**
+     * @brief Constructor
+     */
+    CalibCacheStats() :
+        hits( 0 ),
+        misses( 0 ),
+        evictions( 0 )
+    {}
+
+    size_t hits;        ///< Number of calibrations returned from the cache
+    size_t misses;      ///< Number of calibrations loaded from file
+    size_t evictions;   ///< Number of calibrations dropped to stay within the cache capacity
+};
+
+/**
+ * @brief Least recently used cache of loaded calibrations
+ *
+ * Calibrations are keyed by the filepath of their json file along with its modification time and
+ * size, so a calibration file that is changed is loaded again. All methods may be called from
+ * several threads at once. The calibrations are shared read only by everyone that gets them.
+ */
+class CalibCache
+{
+public:
+    /**
+     * @brief Constructor
+     * @param capacity Maximum number of calibrations held by the cache
+     */
+    explicit CalibCache( const size_t capacity = CALIB_CACHE_DEFAULT_CAPACITY );
+
+    /**
+     * @brief Destructor
+     */
+    ~CalibCache() {}
+
+    /**
+     * @brief Get a calibration from the cache, loading it from its json file if it is not held
+     * @param jsonCalFilepath Filepath of the calibration json file
+     * @param calib Pointer to the loaded calibration
+     * @return GC_OK=Success, GC_FAIL=Failure, GC_EXCEPT=Exception thrown
+     */
+    GC_STATUS Get( const std::string jsonCalFilepath, std::shared_ptr< const Calib > &calib );
+
+    /**
+     * @brief Set the maximum number of calibrations held by the cache (least recently used are dropped)
+     * @param capacity Maximum number of calibrations (must be one or more)
+     * @return GC_OK=Success, GC_FAIL=Failure, GC_EXCEPT=Exception thrown
+     */
+    GC_STATUS SetCapacity( const size_t capacity );
+
+    /**
+     * @brief Drop all calibrations held by the cache (the counters are kept)
+     */
+    void Clear();
+
+    /**
+     * @brief Get the hit, miss, and eviction counters of the cache
+     * @return The counters
+     */
+    CalibCacheStats Stats();
+
+private:
+    class CacheEntry
+    {
+    public:
+        std::string filepath;
+        std::time_t modTime;
+        uintmax_t fileSize;
+        std::shared_ptr< const Calib > calib;
+    };
+
+    size_t m_capacity;
+    std::list< CacheEntry > m_entries;                      // most recently used first
+    std::unordered_map< std::string, std::list< CacheEntry >::iterator > m_index;
+    CalibCacheStats m_stats;
+    std::mutex m_mutex;
+    std::mutex m_loadMutex;
+
+    bool Find( const std::string &jsonCalFilepath, const std::time_t modTime,
+               const uintmax_t fileSize, std::shared_ptr< const Calib > &calib );
+    void Trim();
+};
+
+} // namespace gc
+
+#endif // CALIBCACHE_H
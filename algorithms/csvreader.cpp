@@ -0,0 +1,261 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+   Copyright 2021 Kenneth W. Chapman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include "log.h"
+#include "csvreader.h"
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+#include <cerrno>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace gc
+{
+
+// longest field converted to a number, longer fields are not numbers
+static const size_t CSV_NUMBER_MAX_LENGTH = 63;
+
+// copies the field without surrounding white space to a null terminated buffer
+static bool NumberText( const char *ptr, size_t len, char *buf )
+{
+    while ( 0 < len && isspace( static_cast< unsigned char >( *ptr ) ) )
+    {
+        ++ptr;
+        --len;
+    }
+    while ( 0 < len && isspace( static_cast< unsigned char >( ptr[ len - 1 ] ) ) )
+        --len;
+    if ( 0 == len || CSV_NUMBER_MAX_LENGTH < len )
+        return false;
+    memcpy( buf, ptr, len );
+    buf[ len ] = '\0';
+    return true;
+}
+bool CSVField::toDouble( double &value ) const
+{
+    char buf[ CSV_NUMBER_MAX_LENGTH + 1 ];
+    if ( !NumberText( ptr, len, buf ) )
+        return false;
+    char *end;
+    errno = 0;
+    double number = strtod( buf, &end );
+    if ( '\0' != *end || ERANGE == errno )
+        return false;
+    value = number;
+    return true;
+}
+bool CSVField::toInt( long long &value ) const
+{
+    char buf[ CSV_NUMBER_MAX_LENGTH + 1 ];
+    if ( !NumberText( ptr, len, buf ) )
+        return false;
+    char *end;
+    errno = 0;
+    long long number = strtoll( buf, &end, 10 );
+    if ( '\0' != *end || ERANGE == errno )
+        return false;
+    value = number;
+    return true;
+}
+GC_STATUS CSVReader::open()
+{
+    close();
+
+    GC_STATUS retVal = GC_OK;
+#ifdef _WIN32
+    fileHandle = CreateFileA( fileName.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                              nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr );
+    if ( INVALID_HANDLE_VALUE == fileHandle )
+    {
+        fileHandle = nullptr;
+    }
+    else
+    {
+        LARGE_INTEGER fileSize;
+        if ( GetFileSizeEx( fileHandle, &fileSize ) )
+        {
+            // an empty file can not be mapped, it is open with no rows
+            opened = 0 == fileSize.QuadPart;
+            if ( !opened )
+            {
+                mapHandle = CreateFileMappingA( fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr );
+                if ( nullptr != mapHandle )
+                {
+                    mapData = static_cast< const char * >( MapViewOfFile( mapHandle, FILE_MAP_READ, 0, 0, 0 ) );
+                    mapSize = static_cast< size_t >( fileSize.QuadPart );
+                    opened = nullptr != mapData;
+                }
+            }
+        }
+    }
+#else
+    fileDesc = ::open( fileName.c_str(), O_RDONLY );
+    if ( 0 <= fileDesc )
+    {
+        struct stat fileStat;
+        if ( 0 == fstat( fileDesc, &fileStat ) )
+        {
+            // an empty file can not be mapped, it is open with no rows
+            opened = 0 == fileStat.st_size;
+            if ( !opened )
+            {
+                void *mapped = mmap( nullptr, static_cast< size_t >( fileStat.st_size ), PROT_READ, MAP_SHARED, fileDesc, 0 );
+                if ( MAP_FAILED != mapped )
+                {
+                    madvise( mapped, static_cast< size_t >( fileStat.st_size ), MADV_SEQUENTIAL );
+                    mapData = static_cast< const char * >( mapped );
+                    mapSize = static_cast< size_t >( fileStat.st_size );
+                    opened = true;
+                }
+            }
+        }
+    }
+#endif
+    if ( !opened )
+    {
+        FILE_LOG( logERROR ) << "[CSVReader::open] Could not map " << fileName;
+        close();
+        retVal = GC_ERR;
+    }
+    return retVal;
+}
+void CSVReader::close()
+{
+#ifdef _WIN32
+    if ( nullptr != mapData )
+        UnmapViewOfFile( mapData );
+    if ( nullptr != mapHandle )
+        CloseHandle( mapHandle );
+    if ( nullptr != fileHandle )
+        CloseHandle( fileHandle );
+    mapHandle = nullptr;
+    fileHandle = nullptr;
+#else
+    if ( nullptr != mapData )
+        munmap( const_cast< char * >( mapData ), mapSize );
+    if ( 0 <= fileDesc )
+        ::close( fileDesc );
+    fileDesc = -1;
+#endif
+    opened = false;
+    mapData = nullptr;
+    mapSize = 0;
+    lines.clear();
+}
+bool CSVReader::nextLine( const char *&pos, CSVField &line ) const
+{
+    const char *end = mapData + mapSize;
+    while ( pos < end )
+    {
+        const char *eol = static_cast< const char * >( memchr( pos, '\n', static_cast< size_t >( end - pos ) ) );
+        const char *next = nullptr == eol ? end : eol + 1;
+        if ( nullptr == eol )
+            eol = end;
+        if ( eol > pos && '\r' == eol[ -1 ] )
+            --eol;
+        if ( eol > pos && '#' != *pos )
+        {
+            line = CSVField( pos, static_cast< size_t >( eol - pos ) );
+            pos = next;
+            return true;
+        }
+        pos = next;
+    }
+    return false;
+}
+void CSVReader::splitLine( const CSVField &line, CSVRow &row ) const
+{
+    row.clear();
+    const char *start = line.data();
+    const char *end = start + line.size();
+    if ( 1 == delimeter.size() )
+    {
+        const char *delim;
+        while ( nullptr != ( delim = static_cast< const char * >( memchr( start, delimeter[ 0 ], static_cast< size_t >( end - start ) ) ) ) )
+        {
+            row.push_back( CSVField( start, static_cast< size_t >( delim - start ) ) );
+            start = delim + 1;
+        }
+    }
+    else
+    {
+        for ( const char *pos = start; pos < end; ++pos )
+        {
+            if ( string::npos != delimeter.find( *pos ) )
+            {
+                row.push_back( CSVField( start, static_cast< size_t >( pos - start ) ) );
+                start = pos + 1;
+            }
+        }
+    }
+    row.push_back( CSVField( start, static_cast< size_t >( end - start ) ) );
+}
+GC_STATUS CSVReader::forEachRow( CSVRowCallback callback )
+{
+    GC_STATUS retVal = opened ? GC_OK : open();
+    if ( GC_OK == retVal )
+    {
+        CSVRow row;
+        CSVField line;
+        size_t rowIndex = 0;
+        const char *pos = mapData;
+        while ( nextLine( pos, line ) )
+        {
+            splitLine( line, row );
+            if ( !callback( rowIndex++, row ) )
+                break;
+        }
+    }
+    return retVal;
+}
+GC_STATUS CSVReader::indexRows()
+{
+    GC_STATUS retVal = opened ? GC_OK : open();
+    if ( GC_OK == retVal )
+    {
+        lines.clear();
+        CSVField line;
+        const char *pos = mapData;
+        while ( nextLine( pos, line ) )
+            lines.push_back( line );
+    }
+    return retVal;
+}
+bool CSVReader::getLine( const size_t rowIndex, CSVField &line ) const
+{
+    if ( lines.size() <= rowIndex )
+        return false;
+    line = lines[ rowIndex ];
+    return true;
+}
+bool CSVReader::getRow( const size_t rowIndex, CSVRow &row ) const
+{
+    if ( lines.size() <= rowIndex )
+        return false;
+    splitLine( lines[ rowIndex ], row );
+    return true;
+}
+
+} // namespace gc
@@ -1,11 +1,13 @@
 #ifndef CSVREADER_H
 #define CSVREADER_H
 
+#include "gc_types.h"
 #include <fstream>
 #include <vector>
 #include <iterator>
 #include <string>
 #include <algorithm>
+#include <functional>
 #include <boost/algorithm/string.hpp>
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -30,11 +32,59 @@
 //     }
 //     return 0;
 // }
+//
+// Large files are better read from the memory map, row by row, without copying the fields
+//
+// int main()
+// {
+//     CSVReader reader("example.csv");
+//     double sum = 0.0;
+//     reader.forEachRow( [&sum]( const size_t rowIndex, const gc::CSVRow &row )
+//     {
+//         double value;
+//         if ( 1 < row.size() && row[ 1 ].toDouble( value ) )
+//             sum += value;
+//         return true;
+//     } );
+//     std::cout << sum << std::endl;
+//     return 0;
+// }
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 namespace gc
 {
 
+/*
+ * A field of a csv row that points into the memory mapped file. The field is not
+ * null terminated and is only valid while the reader that returned it is open.
+ */
+class CSVField
+{
+public:
+    CSVField() : ptr( nullptr ), len( 0 ) { }
+    CSVField( const char *data, const size_t size ) : ptr( data ), len( size ) { }
+
+    const char *data() const { return ptr; }
+    size_t size() const { return len; }
+    bool empty() const { return 0 == len; }
+    std::string str() const { return std::string( ptr, len ); }
+    bool operator==( const std::string &text ) const { return text.size() == len && 0 == text.compare( 0, len, ptr, len ); }
+    bool operator!=( const std::string &text ) const { return !( *this == text ); }
+
+    // Converts the whole field (surrounding white space allowed) to a number, false if it is not one
+    bool toDouble( double &value ) const;
+    bool toInt( long long &value ) const;
+
+private:
+    const char *ptr;
+    size_t len;
+};
+
+typedef std::vector< CSVField > CSVRow;
+
+// Called for each row with the index of the row and its fields, return false to stop reading
+typedef std::function< bool( const size_t rowIndex, const CSVRow &row ) > CSVRowCallback;
+
 /*
  * A class to read data from a csv file.
  */
@@ -43,11 +93,54 @@ class CSVReader
     std::string fileName;
     std::string delimeter;
 
+    bool opened;
+    const char *mapData;
+    size_t mapSize;
+#ifdef _WIN32
+    void *fileHandle;
+    void *mapHandle;
+#else
+    int fileDesc;
+#endif
+    std::vector< CSVField > lines;
+
+    bool nextLine( const char *&pos, CSVField &line ) const;
+    void splitLine( const CSVField &line, CSVRow &row ) const;
+
 public:
     CSVReader( std::string filename, std::string delm = "," ) :
             fileName( filename),
-            delimeter( delm )
+            delimeter( delm ),
+            opened( false ),
+            mapData( nullptr ),
+            mapSize( 0 ),
+#ifdef _WIN32
+            fileHandle( nullptr ),
+            mapHandle( nullptr ),
+#else
+            fileDesc( -1 ),
+#endif
+            lines()
     { }
+    ~CSVReader() { close(); }
+
+    CSVReader( const CSVReader & ) = delete;
+    CSVReader &operator=( const CSVReader & ) = delete;
+
+    // Memory maps the file, called by forEachRow() and indexRows() when the file is not open
+    GC_STATUS open();
+    void close();
+    bool isOpen() const { return opened; }
+
+    // Streams the rows of the map to the callback. Empty lines and lines that start with '#'
+    // are skipped as getData() does, a '\r' at the end of a line is not part of the last field.
+    GC_STATUS forEachRow( CSVRowCallback callback );
+
+    // Finds the lines of the file for random access with getLine() and getRow()
+    GC_STATUS indexRows();
+    size_t rowCount() const { return lines.size(); }
+    bool getLine( const size_t rowIndex, CSVField &line ) const;
+    bool getRow( const size_t rowIndex, CSVRow &row ) const;
 
     // Function to fetch data from a CSV File
     std::vector< std::vector< std::string > > getData()
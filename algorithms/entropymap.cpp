@@ -61,25 +61,211 @@ string GetNowString()
 namespace gc
 {
 
+static const int ENTROPY_MAP_BIN_COUNT = 32;
+static const int ENTROPY_MAP_BIN_SHIFT = 3;
+
+// run of set pixels in a row of the kernel mask, columns [start, end)
+struct EntropyMaskRun
+{
+    int row;
+    int start;
+    int end;
+};
+
+// counts the occupied bins of a kernel histogram, the reference map counts masked out pixels as zeros
+static inline float OccupiedBins( const int *hist, const bool hasMaskedPixels )
+{
+    int count = ( hasMaskedPixels && 0 == hist[ 0 ] ) ? 1 : 0;
+    for ( int i = 0; i < ENTROPY_MAP_BIN_COUNT; ++i )
+        count += 0 == hist[ i ] ? 0 : 1;
+    return static_cast< float >( count );
+}
+
+// Full kernels (Perreault-Hebert): a histogram is kept for every kernelSize high image column and slid
+// down by stride rows from map row to map row, the kernel histogram is slid right by subtracting the
+// column histograms that leave it and adding those that enter it, so the cost per map pixel does not
+// depend on the kernel size
+static void EntropyRowsFull( const Mat &src, Mat &dst, const int kernelSize, const int stride,
+                             const Range &range, const int colCount, const int dstOffset )
+{
+    int usedCols = ( colCount - 1 ) * stride + kernelSize;
+    vector< int > colHists( static_cast< size_t >( usedCols ) * ENTROPY_MAP_BIN_COUNT, 0 );
+    int hist[ ENTROPY_MAP_BIN_COUNT ];
+    bool rebuild = stride >= kernelSize;
+
+    for ( int mapRow = range.start; mapRow < range.end; ++mapRow )
+    {
+        int top = mapRow * stride;
+        if ( mapRow == range.start || rebuild )
+        {
+            std::fill( colHists.begin(), colHists.end(), 0 );
+            for ( int row = top; row < top + kernelSize; ++row )
+            {
+                const uchar *pSrc = src.ptr< uchar >( row );
+                for ( int col = 0; col < usedCols; ++col )
+                    ++colHists[ col * ENTROPY_MAP_BIN_COUNT + ( pSrc[ col ] >> ENTROPY_MAP_BIN_SHIFT ) ];
+            }
+        }
+        else
+        {
+            for ( int row = top - stride; row < top; ++row )
+            {
+                const uchar *pOut = src.ptr< uchar >( row );
+                const uchar *pIn = src.ptr< uchar >( row + kernelSize );
+                for ( int col = 0; col < usedCols; ++col )
+                {
+                    --colHists[ col * ENTROPY_MAP_BIN_COUNT + ( pOut[ col ] >> ENTROPY_MAP_BIN_SHIFT ) ];
+                    ++colHists[ col * ENTROPY_MAP_BIN_COUNT + ( pIn[ col ] >> ENTROPY_MAP_BIN_SHIFT ) ];
+                }
+            }
+        }
+
+        float *pDst = dst.ptr< float >( dstOffset + mapRow ) + dstOffset;
+        for ( int mapCol = 0; mapCol < colCount; ++mapCol )
+        {
+            int left = mapCol * stride;
+            if ( 0 == mapCol || rebuild )
+            {
+                std::fill( hist, hist + ENTROPY_MAP_BIN_COUNT, 0 );
+                for ( int col = left; col < left + kernelSize; ++col )
+                {
+                    const int *pCol = &colHists[ col * ENTROPY_MAP_BIN_COUNT ];
+                    for ( int bin = 0; bin < ENTROPY_MAP_BIN_COUNT; ++bin )
+                        hist[ bin ] += pCol[ bin ];
+                }
+            }
+            else
+            {
+                for ( int col = left - stride; col < left; ++col )
+                {
+                    const int *pOut = &colHists[ col * ENTROPY_MAP_BIN_COUNT ];
+                    const int *pIn = &colHists[ ( col + kernelSize ) * ENTROPY_MAP_BIN_COUNT ];
+                    for ( int bin = 0; bin < ENTROPY_MAP_BIN_COUNT; ++bin )
+                        hist[ bin ] += pIn[ bin ] - pOut[ bin ];
+                }
+            }
+            pDst[ mapCol ] = OccupiedBins( hist, false );
+        }
+    }
+}
+
+// Masked kernels (Huang): the kernel histogram is slid right by removing the first stride pixels of each
+// mask run and adding the stride pixels that follow it, and rebuilt at the start of each map row
+static void EntropyRowsMasked( const Mat &src, Mat &dst, const int kernelSize, const int stride,
+                               const Range &range, const int colCount, const int dstOffset,
+                               const vector< EntropyMaskRun > &runs )
+{
+    int minRunLength = kernelSize;
+    for ( size_t i = 0; i < runs.size(); ++i )
+        minRunLength = std::min( minRunLength, runs[ i ].end - runs[ i ].start );
+    bool rebuild = stride > minRunLength;
+
+    int hist[ ENTROPY_MAP_BIN_COUNT ];
+    vector< const uchar * > rowPtrs( kernelSize );
+    for ( int mapRow = range.start; mapRow < range.end; ++mapRow )
+    {
+        int top = mapRow * stride;
+        for ( int row = 0; row < kernelSize; ++row )
+            rowPtrs[ row ] = src.ptr< uchar >( top + row );
+
+        float *pDst = dst.ptr< float >( dstOffset + mapRow ) + dstOffset;
+        for ( int mapCol = 0; mapCol < colCount; ++mapCol )
+        {
+            int left = mapCol * stride;
+            if ( 0 == mapCol || rebuild )
+            {
+                std::fill( hist, hist + ENTROPY_MAP_BIN_COUNT, 0 );
+                for ( size_t i = 0; i < runs.size(); ++i )
+                {
+                    const uchar *pSrc = rowPtrs[ runs[ i ].row ] + left;
+                    for ( int col = runs[ i ].start; col < runs[ i ].end; ++col )
+                        ++hist[ pSrc[ col ] >> ENTROPY_MAP_BIN_SHIFT ];
+                }
+            }
+            else
+            {
+                for ( size_t i = 0; i < runs.size(); ++i )
+                {
+                    const uchar *pOut = rowPtrs[ runs[ i ].row ] + left - stride + runs[ i ].start;
+                    const uchar *pIn = rowPtrs[ runs[ i ].row ] + left - stride + runs[ i ].end;
+                    for ( int col = 0; col < stride; ++col )
+                    {
+                        --hist[ pOut[ col ] >> ENTROPY_MAP_BIN_SHIFT ];
+                        ++hist[ pIn[ col ] >> ENTROPY_MAP_BIN_SHIFT ];
+                    }
+                }
+            }
+            pDst[ mapCol ] = OccupiedBins( hist, true );
+        }
+    }
+}
+
 EntropyMap::EntropyMap()
 {
 }
 EntropyMap::~EntropyMap()
 {
 }
-GC_STATUS EntropyMap::CalcMap( const Mat &src, Mat &dst, const int kernelSize, const bool useEllipse )
+GC_STATUS EntropyMap::CalcMap( const Mat &src, Mat &dst, const int kernelSize, const bool useEllipse, const int stride )
+{
+    GC_STATUS retVal = GC_OK;
+    if ( src.empty() || CV_8UC1 != src.type() )
+    {
+        FILE_LOG( logERROR ) << "[" << __func__ << "][EntropyMap::CalcMap] Cannot calculate entropy map for empty or non 8-bit gray image";
+        retVal = GC_ERR;
+    }
+    else if ( ENTROPY_MAP_KERNEL_SIZE_MIN > kernelSize || ENTROPY_MAP_KERNEL_SIZE_MAX < kernelSize )
+    {
+        FILE_LOG( logERROR ) << "[" << __func__ << "][EntropyMap::CalcMap] Invalid entropy map with kernSize=" << kernelSize \
+                             << ". Must be in range " << ENTROPY_MAP_KERNEL_SIZE_MIN << " to " << ENTROPY_MAP_KERNEL_SIZE_MAX << ".";
+        retVal = GC_ERR;
+    }
+    else if ( kernelSize > src.rows || kernelSize > src.cols )
+    {
+        FILE_LOG( logERROR ) << "[" << __func__ << "][EntropyMap::CalcMap] Image " << src.cols << "x" << src.rows \
+                             << " is smaller than kernSize=" << kernelSize;
+        retVal = GC_ERR;
+    }
+    else if ( 1 > stride )
+    {
+        FILE_LOG( logERROR ) << "[" << __func__ << "][EntropyMap::CalcMap] Invalid stride=" << stride;
+        retVal = GC_ERR;
+    }
+    else
+    {
+        try
+        {
+            Mat ellipseMask;
+            retVal = BuildMask( kernelSize, useEllipse, ellipseMask );
+            if ( GC_OK == retVal )
+            {
+                Mat scratch = Mat::zeros( src.size(), CV_32FC1 );
+                retVal = CalcTileSliding( src, scratch, kernelSize, ellipseMask, stride );
+                if ( GC_OK == retVal )
+                    scratch.copyTo( dst );
+            }
+        }
+        catch( Exception &e )
+        {
+            FILE_LOG( logERROR ) << "[" << __func__ << "][EntropyMap::CalcMap] " << e.what();
+            retVal = GC_EXCEPT;
+        }
+    }
+    return retVal;
+}
+GC_STATUS EntropyMap::CalcMapReference( const Mat &src, Mat &dst, const int kernelSize, const bool useEllipse )
 {
     GC_STATUS retVal = src.empty() ? GC_ERR : GC_OK;
     if ( GC_OK != retVal )
     {
-        FILE_LOG( logERROR ) << "[" << __func__ << "][EntropyMap::CalcMap] Cannot calculate entropy map for empty image";
+        FILE_LOG( logERROR ) << "[" << __func__ << "][EntropyMap::CalcMapReference] Cannot calculate entropy map for empty image";
         retVal = GC_ERR;
     }
     else
     {
         if ( 3 > kernelSize )
         {
-            FILE_LOG( logERROR ) << "[" << __func__ << "][EntropyMap::CalcMap] Cannot calculate entropy map with kernSize less than 3";
+            FILE_LOG( logERROR ) << "[" << __func__ << "][EntropyMap::CalcMapReference] Cannot calculate entropy map with kernSize less than 3";
             retVal = GC_ERR;
         }
         else
@@ -89,25 +275,15 @@ GC_STATUS EntropyMap::CalcMap( const Mat &src, Mat &dst, const int kernelSize, c
 #ifdef DEBUT_ENTROPY
                 imwrite( DEBUG_FOLDER + string("__gray_src.png"), src );
 #endif
-                Mat ellipseMask = Mat::zeros( kernelSize, kernelSize, CV_8UC1 );
-                if ( useEllipse )
-                {
-                    int kernHalf = kernelSize >> 1;
-                    ellipse( ellipseMask, Point( kernHalf, kernHalf ), Size( kernelSize, kernelSize ),
-                             0.0, 0.0, 360.0, Scalar( 255 ), FILLED );
-                }
-                else
+                Mat ellipseMask;
+                retVal = BuildMask( kernelSize, useEllipse, ellipseMask );
+                if ( GC_OK == retVal )
                 {
-                    ellipseMask.setTo( 255 );
+                    Mat scratch = Mat::zeros( src.size(), CV_32FC1 );
+                    retVal = CalcTile( src, scratch, kernelSize, ellipseMask );
+                    if ( GC_OK == retVal )
+                        scratch.copyTo( dst );
                 }
-                Mat scratch = Mat::zeros( src.size(), CV_32FC1 );
-                retVal = CalcTile( src, scratch, kernelSize, ellipseMask );
-                if ( GC_OK == retVal )
-#if 1
-                    scratch.copyTo( dst );
-#else
-                    scratch( Rect( 0, 0, scratch.cols >> 2, scratch.rows >> 2 ) ).copyTo( dst );
-#endif
 
 #ifdef DEBUT_ENTROPY
                 imwrite( DEBUG_FOLDER + string("__morph_8u.png"), dst );
@@ -115,13 +291,93 @@ GC_STATUS EntropyMap::CalcMap( const Mat &src, Mat &dst, const int kernelSize, c
             }
             catch( Exception &e )
             {
-                FILE_LOG( logERROR ) << "[" << __func__ << "][EntropyMap::CalcMap] " << e.what();
+                FILE_LOG( logERROR ) << "[" << __func__ << "][EntropyMap::CalcMapReference] " << e.what();
                 retVal = GC_EXCEPT;
             }
         }
     }
     return retVal;
 }
+GC_STATUS EntropyMap::BuildMask( const int kernelSize, const bool useEllipse, Mat &mask )
+{
+    GC_STATUS retVal = GC_OK;
+    try
+    {
+        mask = Mat::zeros( kernelSize, kernelSize, CV_8UC1 );
+        if ( useEllipse )
+        {
+            int kernHalf = kernelSize >> 1;
+            ellipse( mask, Point( kernHalf, kernHalf ), Size( kernelSize, kernelSize ),
+                     0.0, 0.0, 360.0, Scalar( 255 ), FILLED );
+        }
+        else
+        {
+            mask.setTo( 255 );
+        }
+    }
+    catch( Exception &e )
+    {
+        FILE_LOG( logERROR ) << "[" << __func__ << "][EntropyMap::BuildMask] " << e.what();
+        retVal = GC_EXCEPT;
+    }
+
+    return retVal;
+}
+GC_STATUS EntropyMap::CalcTileSliding( const Mat &src, Mat &dst, const int kernelSize, const Mat &mask, const int stride )
+{
+    GC_STATUS retVal = GC_OK;
+    try
+    {
+        int kernHalf = kernelSize >> 1;
+        int dstOffset = kernHalf / stride;
+        int rowCount = ( src.rows - 2 * kernHalf + stride - 1 ) / stride;
+        int colCount = ( src.cols - 2 * kernHalf + stride - 1 ) / stride;
+
+        // the mask is kept as the runs of set pixels of each of its rows
+        vector< EntropyMaskRun > runs;
+        bool hasMaskedPixels = false;
+        for ( int row = 0; row < mask.rows; ++row )
+        {
+            const uchar *pMask = mask.ptr< uchar >( row );
+            for ( int col = 0; col < mask.cols; )
+            {
+                if ( 0 == pMask[ col ] )
+                {
+                    hasMaskedPixels = true;
+                    ++col;
+                }
+                else
+                {
+                    EntropyMaskRun run;
+                    run.row = row;
+                    run.start = col;
+                    while ( col < mask.cols && 0 != pMask[ col ] )
+                        ++col;
+                    run.end = col;
+                    runs.push_back( run );
+                }
+            }
+        }
+
+        if ( 0 < rowCount && 0 < colCount )
+        {
+            parallel_for_( Range( 0, rowCount ), [ & ]( const Range &range )
+            {
+                if ( hasMaskedPixels )
+                    EntropyRowsMasked( src, dst, kernelSize, stride, range, colCount, dstOffset, runs );
+                else
+                    EntropyRowsFull( src, dst, kernelSize, stride, range, colCount, dstOffset );
+            }, std::max( 1, getNumThreads() ) );
+        }
+    }
+    catch( Exception &e )
+    {
+        FILE_LOG( logERROR ) << "[" << __func__ << "][EntropyMap::CalcTileSliding] " << e.what();
+        retVal = GC_EXCEPT;
+    }
+
+    return retVal;
+}
 GC_STATUS EntropyMap::CalcTile( const Mat &src, Mat &dst, const int kernelSize, const cv::Mat &mask )
 {
     GC_STATUS retVal = src.empty() ? GC_ERR : GC_OK;
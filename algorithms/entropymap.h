@@ -26,6 +26,7 @@ static const int DEFAULT_ENTROPY_MORPH_KERN_SIZE = 5;
 static const int DEFAULT_ENTROPY_MORPH_ITERS = 1;
 static const double DEFAULT_ENTROPY_THRESHGAIN = 1.0;
 static const int DEFAULT_ENTROPY_CLEAN_CONTOUR_WIDTH = 11;
+static const int DEFAULT_ENTROPY_STRIDE = 4;
 
 namespace gc
 {
@@ -36,9 +37,41 @@ public:
     EntropyMap();
     ~EntropyMap();
 
-    GC_STATUS CalcMap( const cv::Mat &src, cv::Mat &dst, const int kernelSize, const bool useEllipse = true );
+    /**
+     * @brief Calculates the map of the number of occupied 32 level histogram bins of the kernels of an image
+     *
+     * The histograms are slid across and down the image rather than rebuilt for every kernel.
+     * Kernels whose top left corners are stride pixels apart are calculated, the result for the
+     * kernel at ( stride * j, stride * i ) is written to dst at ( kernHalf / stride + j, kernHalf / stride + i ).
+     * A stride of 1 gives a full resolution map, the default stride of 4 gives the same map as
+     * CalcMapReference(). The rows of the map are calculated in parallel bands.
+     *
+     * @param src 8-bit gray image
+     * @param dst CV_32FC1 map the size of src
+     * @param kernelSize Width and height of the kernel
+     * @param useEllipse true=Only the pixels of the kernel within an ellipse are counted
+     * @param stride Distance in pixels between the kernels that are calculated
+     * @return GC_OK=Success, GC_FAIL=Failure, GC_EXCEPT=Exception thrown
+     */
+    GC_STATUS CalcMap( const cv::Mat &src, cv::Mat &dst, const int kernelSize, const bool useEllipse = true,
+                       const int stride = DEFAULT_ENTROPY_STRIDE );
+
+    /**
+     * @brief Calculates the map of CalcMap() with a stride of 4 by building a histogram for each kernel
+     *
+     * Kept as the reference the sliding histogram map is checked against.
+     *
+     * @param src 8-bit gray image
+     * @param dst CV_32FC1 map the size of src
+     * @param kernelSize Width and height of the kernel
+     * @param useEllipse true=Only the pixels of the kernel within an ellipse are counted
+     * @return GC_OK=Success, GC_FAIL=Failure, GC_EXCEPT=Exception thrown
+     */
+    GC_STATUS CalcMapReference( const cv::Mat &src, cv::Mat &dst, const int kernelSize, const bool useEllipse = true );
 
 private:
+    GC_STATUS BuildMask( const int kernelSize, const bool useEllipse, cv::Mat &mask );
+    GC_STATUS CalcTileSliding( const cv::Mat &src, cv::Mat &dst, const int kernelSize, const cv::Mat &mask, const int stride );
     GC_STATUS BuildLogLUT( const cv::Mat &mask, std::vector< float > &lut );
     GC_STATUS CalcTile( const cv::Mat &src, cv::Mat &dst, const int kernelSize, const cv::Mat &mask );
     GC_STATUS CalcEntropyValue( const cv::Mat &img, float &enter, const cv::Mat &mask );
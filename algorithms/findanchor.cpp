@@ -45,7 +45,8 @@ FindAnchor::FindAnchor() :
     isDarkSparseHoriz( true ),
     angleRef( -99999.0 ),
     offsetRef( Point( -9999999, -9999999 ) ),
-    modelRect( Rect( -1, -1, -1, -1 ) )
+    modelRect( Rect( -1, -1, -1, -1 ) ),
+    matchEngine( MATCH_ENGINE_SPATIAL )
 {
 #ifdef DEBUG_FIND_ANCHOR
     if ( !boost::filesystem::exists( DEBUG_FOLDER ) )
@@ -74,7 +75,7 @@ void FindAnchor::clear()
     offsetRef = Point( -9999999, -9999999 );
     modelRect = Rect( -1, -1, -1, -1 ),
     rotModelSet.clear();
-    matProbSpace = Mat();
+    matchDFT = nullptr;
 }
 bool FindAnchor::isInitializedVertHoriz()
 {
@@ -84,8 +85,52 @@ bool FindAnchor::isInitializedVertHoriz()
 }
 bool FindAnchor::isInitializedModel()
 {
-    return ( rotModelSet.empty() || matProbSpace.empty() ||
-             0 > modelRect.x ) ? false : true;
+    return ( rotModelSet.empty() || 0 > modelRect.x || 0 > modelRect.y ||
+             0 >= modelRect.width || 0 >= modelRect.height ) ? false : true;
+}
+GC_STATUS FindAnchor::SetMatchEngine( const GC_MATCH_ENGINE engine )
+{
+    GC_STATUS retVal = GC_OK;
+    try
+    {
+        matchEngine = engine;
+        if ( MATCH_ENGINE_DFT == matchEngine )
+        {
+            if ( nullptr == matchDFT && !rotModelSet.empty() )
+                retVal = BuildMatchDFT();
+        }
+        else
+        {
+            matchDFT = nullptr;
+        }
+    }
+    catch( const Exception &e )
+    {
+        FILE_LOG( logERROR ) << "[FindAnchor::SetMatchEngine] " << e.what();
+        retVal = GC_EXCEPT;
+    }
+    return retVal;
+}
+GC_STATUS FindAnchor::BuildMatchDFT()
+{
+    GC_STATUS retVal = GC_OK;
+    try
+    {
+        // a new engine rather than a changed one, copies of this anchor keep their own models
+        vector< Mat > models;
+        for ( size_t i = 0; i < rotModelSet.size(); ++i )
+            models.push_back( rotModelSet[ i ].model );
+        shared_ptr< TemplateMatchDFT > matchDFTNew = make_shared< TemplateMatchDFT >();
+        retVal = matchDFTNew->SetTemplates( models );
+        if ( GC_OK == retVal )
+            matchDFT = matchDFTNew;
+    }
+    catch( const Exception &e )
+    {
+        FILE_LOG( logERROR ) << "[FindAnchor::BuildMatchDFT] " << e.what();
+        retVal = GC_EXCEPT;
+    }
+    return retVal;
 }
 GC_STATUS FindAnchor::SetRef( const string imgFilepath, const Rect &modelROI )
 {
@@ -159,7 +204,8 @@ GC_STATUS FindAnchor::SetRef( const Mat &img, const Rect &modelROI  )
             if ( GC_OK == retVal )
             {
                 modelRect = modelROI;
-                matProbSpace = Mat();
+                if ( MATCH_ENGINE_DFT == matchEngine )
+                    retVal = BuildMatchDFT();
             }
         }
     }
@@ -255,17 +301,17 @@ GC_STATUS FindAnchor::CalcMoveModel( const cv::Mat &img, cv::Point &ptOrig, cv::
 
             GaussianBlur( img, scratch, Size( 5, 5 ), 3.0 );
 
-            matProbSpace = Mat();
             double maxScore = -9999999.0;
             ptOrig = Point( modelRect.x, modelRect.y );
-            for ( size_t i = 0; i < rotModelSet.size(); ++i )
+            vector< double > scores;
+            vector< Point > offsets;
+            retVal = MatchRotatedModels( scratch, TM_CCOEFF_NORMED, scores, offsets );
+            for ( size_t i = 0; GC_OK == retVal && i < rotModelSet.size(); ++i )
             {
-                matchTemplate( scratch, rotModelSet[ i ].model, matProbSpace, TM_CCOEFF_NORMED );
-                minMaxLoc( matProbSpace, nullptr, &rotModelSet[ i ].score, nullptr, &rotModelSet[ i ].offset );
-                if ( rotModelSet[ i ].score > maxScore )
+                if ( scores[ i ] > maxScore )
                 {
                     ptMove = Point( modelRect.x, modelRect.y );
-                    maxScore = rotModelSet[ i ].score;
+                    maxScore = scores[ i ];
                     angle = rotModelSet[ i ].angle;
                 }
             }
@@ -287,15 +333,16 @@ GC_STATUS FindAnchor::FindModel( const Mat &img, double &angle, cv::Point &offse
         double maxScore = -9999999.0;
         angle = -99999.0;
         offset = Point( -1, -1 );
-        for ( size_t i = 0; i < rotModelSet.size(); ++i )
+        vector< double > scores;
+        vector< Point > offsets;
+        retVal = MatchRotatedModels( img, TM_CCORR_NORMED, scores, offsets );
+        for ( size_t i = 0; GC_OK == retVal && i < rotModelSet.size(); ++i )
         {
-            matchTemplate( img, rotModelSet[ i ].model, matProbSpace, TM_CCORR_NORMED );
-            minMaxLoc( matProbSpace, nullptr, &rotModelSet[ i ].score, nullptr, &rotModelSet[ i ].offset );
-            if ( rotModelSet[ i ].score > maxScore )
+            if ( scores[ i ] > maxScore )
             {
                 angle = rotModelSet[ i ].angle;
-                offset = rotModelSet[ i ].offset - Point( modelRect.x, modelRect.y );
-                maxScore = rotModelSet[ i ].score;
+                offset = offsets[ i ] - Point( modelRect.x, modelRect.y );
+                maxScore = scores[ i ];
             }
         }
     }
@@ -307,6 +354,59 @@ GC_STATUS FindAnchor::FindModel( const Mat &img, double &angle, cv::Point &offse
 
     return retVal;
 }
+GC_STATUS FindAnchor::MatchRotatedModels( const Mat &img, const int method, vector< double > &scores, vector< Point > &offsets )
+{
+    GC_STATUS retVal = GC_OK;
+    try
+    {
+        // the DFT engine transforms the image once for all of the rotations
+        DFTSearchImage searchDFT;
+        bool isDFT = MATCH_ENGINE_DFT == matchEngine;
+        if ( isDFT )
+        {
+            if ( nullptr == matchDFT )
+            {
+                FILE_LOG( logERROR ) << "[FindAnchor::MatchRotatedModels] No DFT match engine models defined";
+                retVal = GC_ERR;
+            }
+            else
+            {
+                retVal = matchDFT->SetImage( img, searchDFT );
+            }
+        }
+
+        // each rotation is matched in its own task with its own probability space
+        scores.assign( rotModelSet.size(), -9999999.0 );
+        offsets.assign( rotModelSet.size(), Point( -1, -1 ) );
+        if ( GC_OK == retVal )
+        {
+            vector< GC_STATUS > rotStatus( rotModelSet.size(), GC_OK );
+            parallel_for_( Range( 0, static_cast< int >( rotModelSet.size() ) ), [ & ]( const Range &range )
+            {
+                Mat probSpace;
+                for ( int i = range.start; i < range.end; ++i )
+                {
+                    size_t idx = static_cast< size_t >( i );
+                    if ( isDFT )
+                        rotStatus[ idx ] = matchDFT->Match( searchDFT, idx, method, probSpace );
+                    else
+                        matchTemplate( img, rotModelSet[ idx ].model, probSpace, method );
+                    if ( GC_OK == rotStatus[ idx ] )
+                        minMaxLoc( probSpace, nullptr, &scores[ idx ], nullptr, &offsets[ idx ] );
+                }
+            } );
+            for ( size_t i = 0; GC_OK == retVal && i < rotStatus.size(); ++i )
+                retVal = rotStatus[ i ];
+        }
+    }
+    catch( const Exception &e )
+    {
+        FILE_LOG( logERROR ) << "[FindAnchor::MatchRotatedModels] " << e.what();
+        retVal = GC_EXCEPT;
+    }
+
+    return retVal;
+}
 GC_STATUS FindAnchor::FindHoriz( const Mat &img, Point &ptA, Point &ptB )
 {
     GC_STATUS retVal = GC_OK;
@@ -18,6 +18,8 @@
 #define FINDANCHOR_H
 
 #include "gc_types.h"
+#include "templatematchdft.h"
+#include <memory>
 
 namespace gc
 {
@@ -55,6 +57,8 @@ public:
     GC_STATUS RotateImage( const cv::Mat &src, cv::Mat &dst, const cv::Point2d ptCenter, const double angle );
     GC_STATUS CalcMove( const cv::Mat &img, cv::Point &ptOrig, cv::Point &ptMove );
 
+    GC_STATUS SetMatchEngine( const GC_MATCH_ENGINE engine );
+
     cv::Rect &ModelRect() { return modelRect; }
     std::string ModelRefImagePath() { return modelRefImageFilepath; }
 
@@ -70,17 +74,19 @@ private:
     cv::Point offsetRef;
     cv::Rect modelRect;
     std::vector< RotatedModel > rotModelSet;
+    GC_MATCH_ENGINE matchEngine;
+    std::shared_ptr< const TemplateMatchDFT > matchDFT;
     std::string modelRefImageFilepath;
 
-    cv::Mat matProbSpace;
-
     void clear();
 
     bool isInitializedVertHoriz();
     bool isInitializedModel();
+    GC_STATUS BuildMatchDFT();
     GC_STATUS FindModel( const cv::Mat &img, double &angle, cv::Point &offset );
     GC_STATUS FindHoriz( const cv::Mat &img, cv::Point &ptA, cv::Point &ptB );
     GC_STATUS FindVert( const cv::Mat &img, cv::Point &ptA, cv::Point &ptB );
+    GC_STATUS MatchRotatedModels( const cv::Mat &img, const int method, std::vector< double > &scores, std::vector< cv::Point > &offsets );
     GC_STATUS SetRef( const cv::Mat &img, const cv::Rect &modelROI );
     GC_STATUS SetRef( const cv::Mat &img, const std::vector< cv::Point > regionV, const std::vector< cv::Point > regionH,
                       const bool darkSparseV, const bool darkSparseH, const int morphCountV, const int morphCountH );
@@ -21,6 +21,8 @@
 #include "opencv2/imgproc.hpp"
 #include "opencv2/imgcodecs.hpp"
 #include <exception>
+#include <map>
+#include <mutex>
 
 #ifdef DEBUG_FIND_CALIB_GRID
 #undef DEBUG_FIND_CALIB_GRID
@@ -34,6 +36,8 @@ namespace gc
 {
 
 FindCalibGrid::FindCalibGrid() :
+    m_usePyramid( true ),
+    m_matchEngine( MATCH_ENGINE_SPATIAL ),
     m_rectLeftMoveSearch( Rect( 0, 0, 5, 5 ) ),
     m_rectRightMoveSearch( Rect( 10, 0, 5, 5 ) )
 {
@@ -47,83 +51,154 @@ GC_STATUS FindCalibGrid::InitBowtieTemplate( const int templateDim, const Size s
                                                    " Invalid template dimension " << templateDim;
         retVal = GC_ERR;
     }
+    else if ( templateDim > searchImgSize.width || templateDim > searchImgSize.height )
+    {
+        FILE_LOG( logERROR ) << "[" << __func__ << "][FindCalibGrid::InitBowtieTemplate]"
+                                                   " Template dimension " << templateDim << " larger than search image";
+        retVal = GC_ERR;
+    }
     else
     {
-        int templateDimEven = templateDim + ( templateDim % 2 );
-
-        int center = TEMPLATE_COUNT / 2;
         try
         {
-            // create templates
-            m_templates.clear();
-
-            int tempDim = templateDimEven << 1;
-            Mat matTemp( Size( tempDim, tempDim ), CV_8U );
-            Mat matTempRot( Size( tempDim, tempDim ), CV_8U );
-
-            for ( int i = 0; i < TEMPLATE_COUNT; ++i )
-                m_templates.push_back( Mat( Size( templateDimEven, templateDimEven ), CV_8U ) );
-
-            // create the unrotated center template
-            matTemp.setTo( 224 );
+            std::shared_ptr< const BowtieTemplateBank > bank;
+            retVal = GetBowtieTemplateBank( templateDim + ( templateDim % 2 ), bank );
+            if ( GC_OK == retVal )
+                m_bowtieBank = bank;
+        }
+        catch( exception &e )
+        {
+            FILE_LOG( logERROR ) << "[" << __func__ << "][FindCalibGrid::InitBowtieTemplate] " << e.what();
+            retVal = GC_EXCEPT;
+        }
+    }
+    return retVal;
+}
+GC_STATUS FindCalibGrid::GetBowtieTemplateBank( const int templateDimEven, std::shared_ptr< const BowtieTemplateBank > &bank )
+{
+    // one bank per template dimension for the whole process, built by the first instance that asks for it
+    static std::mutex bankMutex;
+    static std::map< int, std::shared_ptr< const BowtieTemplateBank > > banks;
 
-            Point drawPoints[ 3 ];
-            drawPoints[ 0 ] = Point( 1, 1 );
-            drawPoints[ 1 ] = Point( 1, matTemp.rows - 2 );
-            drawPoints[ 2 ] = Point( matTemp.cols / 2,
-                               matTemp.rows / 2 );
-            fillConvexPoly( matTemp, drawPoints, 3, Scalar( 32 ) );
+    GC_STATUS retVal = GC_OK;
+    try
+    {
+        std::lock_guard< std::mutex > lock( bankMutex );
+        auto found = banks.find( templateDimEven );
+        if ( banks.end() != found )
+        {
+            bank = found->second;
+        }
+        else
+        {
+            std::shared_ptr< BowtieTemplateBank > bankNew = std::make_shared< BowtieTemplateBank >();
+            retVal = BuildBowtieTemplateBank( templateDimEven, *bankNew );
+            if ( GC_OK == retVal )
+            {
+                banks[ templateDimEven ] = bankNew;
+                bank = bankNew;
+            }
+        }
+    }
+    catch( exception &e )
+    {
+        FILE_LOG( logERROR ) << "[" << __func__ << "][FindCalibGrid::GetBowtieTemplateBank] " << e.what();
+        retVal = GC_EXCEPT;
+    }
+    return retVal;
+}
+GC_STATUS FindCalibGrid::BuildBowtieTemplateBank( const int templateDimEven, BowtieTemplateBank &bank )
+{
+    GC_STATUS retVal = GC_OK;
+    try
+    {
+        // create templates
+        bank.templates.clear();
 
-            drawPoints[ 0 ] = Point( matTemp.cols - 2, 1 );
-            drawPoints[ 1 ] = Point( matTemp.cols - 2,
-                               matTemp.rows - 2 );
-            drawPoints[ 2 ] = Point( matTemp.cols / 2,
-                               matTemp.rows / 2 );
-            fillConvexPoly( matTemp, drawPoints, 3, Scalar( 32 ) );
+        int center = TEMPLATE_COUNT / 2;
+        int tempDim = templateDimEven << 1;
+        Mat matTemp( Size( tempDim, tempDim ), CV_8U );
+        Mat matTempRot( Size( tempDim, tempDim ), CV_8U );
+
+        for ( int i = 0; i < TEMPLATE_COUNT; ++i )
+            bank.templates.push_back( Mat( Size( templateDimEven, templateDimEven ), CV_8U ) );
+
+        // create the unrotated center template
+        matTemp.setTo( 224 );
+
+        Point drawPoints[ 3 ];
+        drawPoints[ 0 ] = Point( 1, 1 );
+        drawPoints[ 1 ] = Point( 1, matTemp.rows - 2 );
+        drawPoints[ 2 ] = Point( matTemp.cols / 2,
+                           matTemp.rows / 2 );
+        fillConvexPoly( matTemp, drawPoints, 3, Scalar( 32 ) );
+
+        drawPoints[ 0 ] = Point( matTemp.cols - 2, 1 );
+        drawPoints[ 1 ] = Point( matTemp.cols - 2,
+                           matTemp.rows - 2 );
+        drawPoints[ 2 ] = Point( matTemp.cols / 2,
+                           matTemp.rows / 2 );
+        fillConvexPoly( matTemp, drawPoints, 3, Scalar( 32 ) );
 
 #ifdef DEBUG_FIND_CALIB_GRID   // debug of template rotation
-            imwrite( DEBUG_RESULT_FOLDER + "_template_center.png", matTemp );
+        imwrite( DEBUG_RESULT_FOLDER + "_template_center.png", matTemp );
 #endif
 
-            // create the rotated templates
-            Rect roiRotate( templateDimEven >> 1, templateDimEven >> 1, templateDimEven, templateDimEven );
-            Mat matTemplateTemp = matTemp( roiRotate );
-            matTemplateTemp.copyTo( m_templates[ static_cast< size_t >( center ) ] );
+        // create the rotated templates
+        Rect roiRotate( templateDimEven >> 1, templateDimEven >> 1, templateDimEven, templateDimEven );
+        Mat matTemplateTemp = matTemp( roiRotate );
+        matTemplateTemp.copyTo( bank.templates[ static_cast< size_t >( center ) ] );
 
-            for ( int i = 0; i < center; ++i )
-            {
-                retVal = RotateImage( matTemp, matTempRot, static_cast< double >( i - center ) );
-                if ( GC_OK != retVal )
-                    break;
+        for ( int i = 0; i < center; ++i )
+        {
+            retVal = RotateImage( matTemp, matTempRot, static_cast< double >( i - center ) );
+            if ( GC_OK != retVal )
+                break;
 
-                matTemplateTemp = matTempRot( roiRotate );
-                matTemplateTemp.copyTo( m_templates[ static_cast< size_t >( i ) ] );
+            matTemplateTemp = matTempRot( roiRotate );
+            matTemplateTemp.copyTo( bank.templates[ static_cast< size_t >( i ) ] );
 
-                retVal = RotateImage( matTemp, matTempRot, static_cast< double >( i + 1 ) );
-                if ( 0 != retVal )
-                    break;
+            retVal = RotateImage( matTemp, matTempRot, static_cast< double >( i + 1 ) );
+            if ( GC_OK != retVal )
+                break;
 
-                matTemplateTemp = matTempRot( roiRotate );
-                matTemplateTemp.copyTo( m_templates[ static_cast< size_t >( center + i + 1 ) ] );
-            }
-
-            // allocate template match space
-            m_matchSpace.create( Size( searchImgSize.width - templateDimEven + 1,
-                                       searchImgSize.height - templateDimEven + 1 ), CV_32F );
-            m_matchSpaceSmall.create( Size( ( templateDimEven >> 1 ) + 1, ( templateDimEven >> 1 ) + 1 ), CV_32F );
+            matTemplateTemp = matTempRot( roiRotate );
+            matTemplateTemp.copyTo( bank.templates[ static_cast< size_t >( center + i + 1 ) ] );
+        }
 
-#ifdef DEBUG_FIND_CALIB_GRID   // debug of template rotation
-            for ( size_t i = 0; i < TEMPLATE_COUNT; ++i )
+        // create the reduced resolution templates for the coarse pyramid search
+        bank.templatesCoarse.clear();
+        bank.pyramidLevels = 0;
+        while ( PYRAMID_LEVELS > bank.pyramidLevels && PYRAMID_MIN_TEMPLATE_DIM <= ( templateDimEven >> ( bank.pyramidLevels + 1 ) ) )
+            ++bank.pyramidLevels;
+        if ( 0 < bank.pyramidLevels )
+        {
+            for ( size_t i = 0; i < bank.templates.size(); ++i )
             {
-                imwrite( DEBUG_RESULT_FOLDER + "template_" + to_string( i ) + ".png", m_templates[ i ] );
+                Mat matCoarse = bank.templates[ i ];
+                for ( int j = 0; j < bank.pyramidLevels; ++j )
+                    pyrDown( matCoarse, matCoarse );
+                bank.templatesCoarse.push_back( matCoarse );
             }
-#endif
         }
-        catch( exception &e )
+
+        // the DFT engines calculate the template spectra the first time an image size is searched
+        if ( GC_OK == retVal )
+            retVal = bank.matchDFT.SetTemplates( bank.templates );
+        if ( GC_OK == retVal && !bank.templatesCoarse.empty() )
+            retVal = bank.matchDFTCoarse.SetTemplates( bank.templatesCoarse );
+
+#ifdef DEBUG_FIND_CALIB_GRID   // debug of template rotation
+        for ( size_t i = 0; i < TEMPLATE_COUNT; ++i )
         {
-            FILE_LOG( logERROR ) << "[" << __func__ << "][FindCalibGrid::InitBowtieTemplate] " << e.what();
-            retVal = GC_EXCEPT;
+            imwrite( DEBUG_RESULT_FOLDER + "template_" + to_string( i ) + ".png", bank.templates[ i ] );
         }
+#endif
+    }
+    catch( exception &e )
+    {
+        FILE_LOG( logERROR ) << "[" << __func__ << "][FindCalibGrid::BuildBowtieTemplateBank] " << e.what();
+        retVal = GC_EXCEPT;
     }
     return retVal;
 }
@@ -146,7 +221,7 @@ GC_STATUS FindCalibGrid::RotateImage( const Mat &src, Mat &dst, const double ang
 GC_STATUS FindCalibGrid::FindTargets( const Mat &img, const double minScore, const string resultFilepath )
 {
     GC_STATUS retVal = GC_OK;
-    if ( m_templates.empty() )
+    if ( nullptr == m_bowtieBank )
     {
         FILE_LOG( logERROR ) << "[" << __func__ << "][FindCalibGrid::FindTargets] Templates not devined";
         retVal = GC_ERR;
@@ -163,22 +238,14 @@ GC_STATUS FindCalibGrid::FindTargets( const Mat &img, const double minScore, con
     }
     else
     {
-        retVal = MatchTemplate( TEMPLATE_COUNT >> 1, img, minScore, TARGET_COUNT * 2 );
+        vector< TemplateBowtieItem > itemsTemp;
+        retVal = MatchTemplate( TEMPLATE_COUNT >> 1, img, minScore, TARGET_COUNT * 2, itemsTemp );
         if ( GC_OK == retVal )
         {
-            vector< TemplateBowtieItem > itemsTemp;
-            for ( size_t i = 0; i < m_matchItems.size(); ++i )
-                itemsTemp.push_back( m_matchItems[ i ] );
-
             m_matchItems.clear();
             for ( size_t i = 0; i < itemsTemp.size(); ++i )
             {
-                for ( size_t j = 0; j < TEMPLATE_COUNT; ++j )
-                {
-                    retVal = MatchRefine( static_cast< int >( j ), img, minScore, 1, itemsTemp[ i ] );
-                    if ( GC_OK != retVal )
-                        break;
-                }
+                retVal = MatchRefineRotations( img, minScore, itemsTemp[ i ] );
                 if ( GC_OK != retVal )
                     break;
                 m_matchItems.push_back( itemsTemp[ i ] );
@@ -226,8 +293,8 @@ GC_STATUS FindCalibGrid::FindTargets( const Mat &img, const double minScore, con
     }
     return retVal;
 }
-GC_STATUS FindCalibGrid::MatchRefine( const int index, const Mat &img, const double minScore,
-                                      const int numToFind, TemplateBowtieItem &item )
+GC_STATUS FindCalibGrid::MatchRefine( const int index, const Mat &img, const Rect rect, const DFTSearchImage *searchDFT,
+                                      Mat &matchSpace, double &score, Point &ptMax ) const
 {
     GC_STATUS retVal = GC_OK;
 
@@ -238,72 +305,113 @@ GC_STATUS FindCalibGrid::MatchRefine( const int index, const Mat &img, const dou
                                                    " Must be in range 0-" << TEMPLATE_COUNT - 1;
         retVal = GC_ERR;
     }
-    else if ( 0.05 > minScore || 1.0 < minScore )
+    else
     {
-        FILE_LOG( logERROR ) << "[" << __func__ << "][FindCalibGrid::MatchRefine]"
-                                                   " Min score %.3f must be in range 0.05-1.0" << minScore;
-        retVal = GC_ERR;
+        try
+        {
+            double minScore;
+            Point ptMin;
+            if ( nullptr == searchDFT )
+            {
+                matchTemplate( img( rect ), m_bowtieBank->templates[ static_cast< size_t >( index ) ], matchSpace, TM_CCOEFF_NORMED );
+            }
+            else
+            {
+                retVal = m_bowtieBank->matchDFT.Match( *searchDFT, static_cast< size_t >( index ), TM_CCOEFF_NORMED, matchSpace );
+            }
+            if ( GC_OK == retVal )
+                minMaxLoc( matchSpace, &minScore, &score, &ptMin, &ptMax );
+        }
+        catch( exception &e )
+        {
+            FILE_LOG( logERROR ) << "[" << __func__ << "][FindCalibGrid::MatchRefine] " << e.what();
+            retVal = GC_EXCEPT;
+        }
     }
-    else if ( 1 > numToFind || 1000 < numToFind )
+    return retVal;
+}
+GC_STATUS FindCalibGrid::MatchRefineRotations( const Mat &img, const double minScore, TemplateBowtieItem &item )
+{
+    GC_STATUS retVal = GC_OK;
+    if ( 0.05 > minScore || 1.0 < minScore )
     {
-        FILE_LOG( logERROR ) << "[" << __func__ << "][FindCalibGrid::MatchRefine]"
-                                                   " Attempted to find " << numToFind << \
-                                                   " matches.  Must be in range 1-1000";
+        FILE_LOG( logERROR ) << "[" << __func__ << "][FindCalibGrid::MatchRefineRotations]"
+                                                   " Min score %.3f must be in range 0.05-1.0" << minScore;
         retVal = GC_ERR;
     }
     else
     {
         try
         {
+            const Mat &matTemplate = m_bowtieBank->templates[ 0 ];
             Rect rect;
-            double minScore, maxScore;
-            Point ptMin, ptMax;
-            Point2d ptFinal;
-
-            m_matchSpace = 0;
-            TemplateBowtieItem itemTemp;
-
-            matchTemplate( img, m_templates[ static_cast< size_t >( index ) ], m_matchSpace, TM_CCOEFF_NORMED );
-#ifdef DEBUG_FIND_CALIB_GRID
-            Mat matTemp;
-            normalize( m_matchSpace, matTemp, 255.0 );
-            imwrite( DEBUG_RESULT_FOLDER + "bowtie_match_fine.png", matTemp );
-#endif
-            rect.x = std::max( 0, cvRound( item.pt.x )- ( m_templates[ 0 ].cols >> 1 ) - ( m_templates[ 0 ].cols >> 2 ) );
-            rect.y = std::max( 0, cvRound( item.pt.y ) - ( m_templates[ 0 ].rows >> 1 ) - ( m_templates[ 0 ].rows >> 2 ) );
-            rect.width = m_templates[ 0 ].cols + ( m_templates[ 0 ].cols >> 1 );
-            rect.height = m_templates[ 0 ].rows + ( m_templates[ 0 ].rows >> 1 );
+            rect.x = std::max( 0, cvRound( item.pt.x )- ( matTemplate.cols >> 1 ) - ( matTemplate.cols >> 2 ) );
+            rect.y = std::max( 0, cvRound( item.pt.y ) - ( matTemplate.rows >> 1 ) - ( matTemplate.rows >> 2 ) );
+            rect.width = matTemplate.cols + ( matTemplate.cols >> 1 );
+            rect.height = matTemplate.rows + ( matTemplate.rows >> 1 );
             if ( rect.x + rect.width >= img.cols )
                 rect.x = img.cols - rect.width;
             if ( rect.y + rect.height >= img.rows )
                 rect.y = img.rows - rect.height;
 
-            Mat matROI = img( rect );
-            m_matchSpaceSmall = 0;
+            // the DFT engine transforms the region once for all of the rotations
+            DFTSearchImage searchDFT;
+            bool isDFT = MATCH_ENGINE_DFT == m_matchEngine;
+            vector< GC_STATUS > rotStatus( TEMPLATE_COUNT, GC_OK );
+            if ( isDFT )
+                rotStatus.assign( TEMPLATE_COUNT, m_bowtieBank->matchDFT.SetImage( img( rect ), searchDFT ) );
+
+            // every rotation is scored in its own task around the same starting item
+            vector< Mat > matchSpaces( TEMPLATE_COUNT );
+            vector< double > scores( TEMPLATE_COUNT, -1.0 );
+            vector< Point > peaks( TEMPLATE_COUNT );
+            parallel_for_( Range( 0, TEMPLATE_COUNT ), [ & ]( const Range &range )
+            {
+                for ( int j = range.start; j < range.end; ++j )
+                {
+                    size_t idx = static_cast< size_t >( j );
+                    if ( GC_OK == rotStatus[ idx ] )
+                        rotStatus[ idx ] = MatchRefine( j, img, rect, isDFT ? &searchDFT : nullptr, matchSpaces[ idx ], scores[ idx ], peaks[ idx ] );
+                }
+            } );
 
-            matchTemplate( matROI, m_templates[ static_cast< size_t >( index ) ], m_matchSpaceSmall, TM_CCOEFF_NORMED );
-            minMaxLoc( m_matchSpaceSmall, &minScore, &maxScore, &ptMin, &ptMax );
-            if ( maxScore > item.score )
+            // only the rotations that beat the starting score are candidates, best score first with ties
+            // going to the lower rotation index as they did when the rotations ran in order. A rotation
+            // that could not be scored or refined is no improvement
+            vector< size_t > candidates;
+            for ( size_t j = 0; j < scores.size(); ++j )
             {
-                retVal = SubpixelPointRefine( m_matchSpaceSmall, ptMax, ptFinal );
-                if ( GC_OK == retVal )
+                if ( GC_OK == rotStatus[ j ] && scores[ j ] > item.score )
+                    candidates.push_back( j );
+            }
+            stable_sort( candidates.begin(), candidates.end(), [ &scores ]( const size_t a, const size_t b )
+            {
+                return scores[ a ] > scores[ b ];
+            } );
+
+            Point2d ptFinal;
+            for ( size_t j = 0; j < candidates.size(); ++j )
+            {
+                size_t idx = candidates[ j ];
+                if ( GC_OK == SubpixelPointRefine( matchSpaces[ idx ], peaks[ idx ], ptFinal ) )
                 {
-                    // ptFinal = Point2d( static_cast< double >( ptMax.x ), static_cast< double >( ptMax.y ) );
-                    item.score = maxScore;
-                    item.pt.x = static_cast< double >( rect.x ) + ptFinal.x + static_cast< double >( m_templates[ 0 ].cols ) / 2.0;
-                    item.pt.y = static_cast< double >( rect.y ) + ptFinal.y + static_cast< double >( m_templates[ 0 ].rows ) / 2.0;
+                    item.score = scores[ idx ];
+                    item.pt.x = static_cast< double >( rect.x ) + ptFinal.x + static_cast< double >( matTemplate.cols ) / 2.0;
+                    item.pt.y = static_cast< double >( rect.y ) + ptFinal.y + static_cast< double >( matTemplate.rows ) / 2.0;
+                    break;
                 }
             }
         }
         catch( exception &e )
         {
-            FILE_LOG( logERROR ) << "[" << __func__ << "][FindCalibGrid::MatchRefine] " << e.what();
+            FILE_LOG( logERROR ) << "[" << __func__ << "][FindCalibGrid::MatchRefineRotations] " << e.what();
             retVal = GC_EXCEPT;
         }
     }
     return retVal;
 }
-GC_STATUS FindCalibGrid::MatchTemplate( const int index, const Mat &img, const double minScore, const int numToFind )
+GC_STATUS FindCalibGrid::MatchTemplate( const int index, const Mat &img, const double minScore,
+                                        const int numToFind, vector< TemplateBowtieItem > &items )
 {
     GC_STATUS retVal = GC_OK;
 
@@ -331,46 +439,104 @@ GC_STATUS FindCalibGrid::MatchTemplate( const int index, const Mat &img, const d
     {
         try
         {
-            Rect rect;
-            double dMin, dMax;
-            Point ptMin, ptMax;
-            Point2d ptFinal;
+            double dMin, dMax, score;
+            Point ptMin, ptMax, ptMatch;
             TemplateBowtieItem itemTemp;
 
-            m_matchSpace = 0.0;
-            m_matchItems.clear();
-            matchTemplate( img, m_templates[ static_cast< size_t >( index ) ], m_matchSpace, cv::TM_CCOEFF_NORMED );
+            // coarse search on a reduced resolution copy of the image when the templates allow it
+            int pyramidLevels = m_usePyramid ? m_bowtieBank->pyramidLevels : 0;
+            int scale = 1 << pyramidLevels;
+            Mat matchSpace, imgCoarse;
+            items.clear();
+            if ( 0 < pyramidLevels )
+            {
+                pyrDown( img, imgCoarse );
+                for ( int i = 1; i < pyramidLevels; ++i )
+                    pyrDown( imgCoarse, imgCoarse );
+            }
+            const Mat &searchImg = 0 < pyramidLevels ? imgCoarse : img;
+            if ( MATCH_ENGINE_DFT == m_matchEngine )
+            {
+                DFTSearchImage searchDFT;
+                const TemplateMatchDFT &matchDFT = 0 < pyramidLevels ? m_bowtieBank->matchDFTCoarse : m_bowtieBank->matchDFT;
+                retVal = matchDFT.SetImage( searchImg, searchDFT );
+                if ( GC_OK == retVal )
+                    retVal = matchDFT.Match( searchDFT, static_cast< size_t >( index ), cv::TM_CCOEFF_NORMED, matchSpace );
+                if ( GC_OK != retVal )
+                    return retVal;
+            }
+            else if ( 0 < pyramidLevels )
+            {
+                matchTemplate( searchImg, m_bowtieBank->templatesCoarse[ static_cast< size_t >( index ) ], matchSpace, cv::TM_CCOEFF_NORMED );
+            }
+            else
+            {
+                matchTemplate( searchImg, m_bowtieBank->templates[ static_cast< size_t >( index ) ], matchSpace, cv::TM_CCOEFF_NORMED );
+            }
 
 #ifdef DEBUG_FIND_CALIB_GRID
             Mat matTemp;
-            normalize( m_matchSpace, matTemp, 255.0 );
+            normalize( matchSpace, matTemp, 255.0 );
             imwrite( DEBUG_RESULT_FOLDER + "bowtie_match_coarse.png", matTemp );
 #endif
 
-            for ( int i = 0; i < numToFind; i++ )
+            // coarse matches are relocated and scored at full resolution in a small region around
+            // the scaled up coarse position, so their order is not known until all are scored. A coarse
+            // peak can refine onto a bowtie already found or score below the minimum, so more peaks
+            // than are needed are examined until enough of them pass
+            int candidateCount = 1 < scale ? numToFind * PYRAMID_CANDIDATE_OVERSAMPLE : numToFind;
+            for ( int i = 0; i < candidateCount && numToFind > static_cast< int >( items.size() ); i++ )
             {
-                minMaxLoc( m_matchSpace, &dMin, &dMax, &ptMin, &ptMax );
-                if (  0 < ptMax.x && 0 < ptMax.y && img.cols - 1 > ptMax.x && img.rows - 1 > ptMax.y )
+                minMaxLoc( matchSpace, &dMin, &dMax, &ptMin, &ptMax );
+                if ( 1 < scale )
                 {
-                    if ( dMax >= minScore )
+                    retVal = MatchTemplateLocal( index, img, ptMax * scale, scale << 1, ptMatch, score );
+                    if ( GC_OK != retVal )
+                        break;
+                }
+                else
+                {
+                    ptMatch = ptMax;
+                    score = dMax;
+                }
+                if (  0 < ptMatch.x && 0 < ptMatch.y && img.cols - 1 > ptMatch.x && img.rows - 1 > ptMatch.y )
+                {
+                    if ( score >= minScore )
                     {
-                        itemTemp.score = dMax;
-                        itemTemp.pt.x = static_cast< double >( ptMax.x ) + static_cast< double >( m_templates[ 0 ].cols ) / 2.0;
-                        itemTemp.pt.y = static_cast< double >( ptMax.y ) + static_cast< double >( m_templates[ 0 ].rows ) / 2.0;
-                        m_matchItems.push_back( itemTemp );
+                        itemTemp.score = score;
+                        itemTemp.pt.x = static_cast< double >( ptMatch.x ) + static_cast< double >( m_bowtieBank->templates[ 0 ].cols ) / 2.0;
+                        itemTemp.pt.y = static_cast< double >( ptMatch.y ) + static_cast< double >( m_bowtieBank->templates[ 0 ].rows ) / 2.0;
+
+                        bool isDuplicate = false;
+                        for ( size_t j = 0; j < items.size(); ++j )
+                        {
+                            if ( MATCH_SUPPRESS_RADIUS >= norm( items[ j ].pt - itemTemp.pt ) )
+                            {
+                                isDuplicate = true;
+                                break;
+                            }
+                        }
+                        if ( !isDuplicate )
+                            items.push_back( itemTemp );
                     }
-                    else
+                    else if ( 1 == scale )
                         break;
                 }
-                circle( m_matchSpace, ptMax, 17, Scalar( 0.0 ), FILLED );
+                circle( matchSpace, ptMax, std::max( 1, MATCH_SUPPRESS_RADIUS / scale ), Scalar( 0.0 ), FILLED );
             }
+
+            // sort by score (high scores at the top) as the full resolution search returns them
+            sort( items.begin(), items.end(), []( TemplateBowtieItem const &a, TemplateBowtieItem const &b )
+            {
+                return ( a.score > b.score );
+            } );
         }
         catch( exception &e )
         {
             FILE_LOG( logERROR ) << "[" << __func__ << "][FindCalibGrid::MatchTemplate] " << e.what();
             return GC_EXCEPT;
         }
-        if ( m_matchItems.empty() )
+        if ( GC_OK == retVal && items.empty() )
         {
             FILE_LOG( logERROR ) << "[" << __func__ << "][FindCalibGrid::MatchTemplate] No template matches found";
             retVal = GC_ERR;
@@ -378,6 +544,38 @@ GC_STATUS FindCalibGrid::MatchTemplate( const int index, const Mat &img, const d
     }
     return retVal;
 }
+GC_STATUS FindCalibGrid::MatchTemplateLocal( const int index, const Mat &img, const Point ptCoarse,
+                                             const int searchRadius, Point &ptMatch, double &score )
+{
+    GC_STATUS retVal = GC_OK;
+    try
+    {
+        const Mat &matTemplate = m_bowtieBank->templates[ static_cast< size_t >( index ) ];
+        Rect rect( ptCoarse.x - searchRadius, ptCoarse.y - searchRadius,
+                   matTemplate.cols + ( searchRadius << 1 ), matTemplate.rows + ( searchRadius << 1 ) );
+        rect &= Rect( 0, 0, img.cols, img.rows );
+        if ( rect.width < matTemplate.cols || rect.height < matTemplate.rows )
+        {
+            ptMatch = ptCoarse;
+            score = -1.0;
+        }
+        else
+        {
+            double dMin;
+            Point ptMin;
+            Mat matchSpace;
+            matchTemplate( img( rect ), matTemplate, matchSpace, TM_CCOEFF_NORMED );
+            minMaxLoc( matchSpace, &dMin, &score, &ptMin, &ptMatch );
+            ptMatch += rect.tl();
+        }
+    }
+    catch( exception &e )
+    {
+        FILE_LOG( logERROR ) << "[" << __func__ << "][FindCalibGrid::MatchTemplateLocal] " << e.what();
+        retVal = GC_EXCEPT;
+    }
+    return retVal;
+}
 GC_STATUS FindCalibGrid::GetFoundPoints( vector< vector< Point2d > > &pts )
 {
     GC_STATUS retVal = GC_OK;
@@ -554,7 +752,7 @@ void FindCalibGrid::GetMoveTargetROIs( Rect &rectLeft, Rect &rectRight )
 GC_STATUS FindCalibGrid::FindMoveTargets( const Mat &img, Point2d &ptLeft, Point2d &ptRight )
 {
     GC_STATUS retVal = GC_OK;
-    if ( m_templates.empty() )
+    if ( nullptr == m_bowtieBank )
     {
         FILE_LOG( logERROR ) << "[" << __func__ << "][FindCalibGrid::FindMoveTargets]"
                                  " Cannot find move targets in an uninitialized object";
@@ -585,46 +783,35 @@ GC_STATUS FindCalibGrid::FindMoveTargets( const Mat &img, Point2d &ptLeft, Point
             imwrite( DEBUG_RESULT_FOLDER + "move_search_image.png", scratch );
 #endif
 
-            m_matchItems.clear();
-
-            retVal = MatchTemplate( TEMPLATE_COUNT >> 1, scratch, TEMPLATE_MATCH_MIN_SCORE, 2 );
+            vector< TemplateBowtieItem > tempItems, moveItems;
+            retVal = MatchTemplate( TEMPLATE_COUNT >> 1, scratch, TEMPLATE_MATCH_MIN_SCORE, 2, tempItems );
             if ( GC_OK == retVal )
             {
-                vector< TemplateBowtieItem > tempItems;
-                for ( size_t i = 0; i < m_matchItems.size(); ++i )
-                    tempItems.push_back( m_matchItems[ i ] );
-
-                m_matchItems.clear();
                 for ( size_t i = 0; i < tempItems.size(); ++i )
                 {
-                    for ( int j = 0; j < TEMPLATE_COUNT; ++j )
-                    {
-                        retVal = MatchRefine( j, scratch, 0.5, 1, tempItems[ i ] );
-                        if ( GC_OK != retVal )
-                            break;
-                    }
+                    retVal = MatchRefineRotations( scratch, 0.5, tempItems[ i ] );
                     if ( GC_OK != retVal )
                         break;
-                    m_matchItems.push_back( tempItems[ i ] );
+                    moveItems.push_back( tempItems[ i ] );
                 }
             }
-            if ( 2 != m_matchItems.size() )
+            if ( 2 != moveItems.size() )
             {
                 FILE_LOG( logERROR ) << "[" << __func__ << "][FindCalibGrid::FindMoveTargets]"
-                                        " Invalid move point count=" << m_matchItems.size() << ".  Should be 2";
+                                        " Invalid move point count=" << moveItems.size() << ".  Should be 2";
                 retVal = GC_ERR;
             }
             else
             {
-                if ( m_matchItems[ 0 ].pt.x < m_matchItems[ 1 ].pt.x )
+                if ( moveItems[ 0 ].pt.x < moveItems[ 1 ].pt.x )
                 {
-                    ptLeft =  m_matchItems[ 0 ].pt;
-                    ptRight =  m_matchItems[ 1 ].pt;
+                    ptLeft =  moveItems[ 0 ].pt;
+                    ptRight =  moveItems[ 1 ].pt;
                 }
                 else
                 {
-                    ptLeft =  m_matchItems[ 1 ].pt;
-                    ptRight =  m_matchItems[ 0 ].pt;
+                    ptLeft =  moveItems[ 1 ].pt;
+                    ptRight =  moveItems[ 0 ].pt;
                 }
             }
         }
@@ -33,8 +33,10 @@
 #define FINDCALIBGRID_H
 
 #include "gc_types.h"
+#include "templatematchdft.h"
 #include <vector>
 #include <functional>
+#include <memory>
 #include <opencv2/core.hpp>
 
 using namespace std;
@@ -48,6 +50,10 @@ static const int TEMPLATE_COUNT = 21;               /**< Number of rotated bowti
 static const double ROTATE_INC = CV_PI / 180.0;     /**< Rotation increment for bowtie match templates */
 static const int CALIB_POINT_ROW_COUNT = 4;         /**< Number of rows of bowties in a gaugecam calibration target */
 static const int CALIB_POINT_COL_COUNT = 2;         /**< Number of columns bowties in a gaugecam calibration target */
+static const int MATCH_SUPPRESS_RADIUS = 17;        /**< Radius around a found match that is cleared before the next search */
+static const int PYRAMID_LEVELS = 2;                /**< Pyramid levels of the coarse bowtie search (2=1/4 scale) */
+static const int PYRAMID_MIN_TEMPLATE_DIM = 12;     /**< Smallest coarse template dimension allowed for the pyramid search */
+static const int PYRAMID_CANDIDATE_OVERSAMPLE = 2;  /**< Coarse pyramid peaks examined for each bowtie to be found */
 
 /**
  * @brief Data class that holds the score and found position of a bowtie
@@ -77,6 +83,27 @@ public:
     double score;   /**< Score of the template match for the found bowtie */
 };
 
+/**
+ * @brief Data class that holds the rotated bowtie templates of one template dimension
+ *
+ * A bank is built once per process for each template dimension and shared by every
+ * FindCalibGrid instance. It is never changed after it is built.
+ */
+class BowtieTemplateBank
+{
+public:
+    /**
+     * @brief Constructor
+     */
+    BowtieTemplateBank() : pyramidLevels( 0 ) {}
+
+    std::vector< cv::Mat > templates;       /**< Bowtie templates, one per rotation angle */
+    std::vector< cv::Mat > templatesCoarse; /**< Reduced resolution templates for the coarse pyramid search */
+    int pyramidLevels;                      /**< Pyramid levels of the coarse search (0=no coarse search) */
+    TemplateMatchDFT matchDFT;              /**< DFT match engine with the spectra of the templates */
+    TemplateMatchDFT matchDFTCoarse;        /**< DFT match engine with the spectra of the coarse templates */
+};
+
 /**
  * @brief Class to search for bowtie targets for calibration and  for targe movement detection
  */
@@ -97,14 +124,38 @@ public:
      * @brief Initializes the bowtie search templates
      *
      * Initializes the bowtie search templates creating a template
-     * for a series of rotation angles.
+     * for a series of rotation angles. Reduced resolution copies of the templates
+     * are created for the coarse pyramid search when the template is large enough.
+     * The templates are built by the first call for a template dimension and shared
+     * by all later calls in the process.
      *
      * @param templateDim The template dimension will create an nxn template
-     * @param searchImgSize Size of the image to be searched (for probablity space creation)
+     * @param searchImgSize Size of the image to be searched (the templates must fit within it)
      * @return GC_OK=Success, GC_FAIL=Failure, GC_EXCEPT=Exception thrown
      */
     GC_STATUS InitBowtieTemplate( const int templateDim , const cv::Size searchImgSize );
 
+    /**
+     * @brief Selects the coarse pyramid or the full resolution whole image bowtie search
+     *
+     * The full resolution search is slower and is kept as the reference against which the
+     * pyramid search is compared.
+     *
+     * @param usePyramid true=Coarse to fine pyramid search (default), false=Full resolution search
+     */
+    void SetPyramidSearch( const bool usePyramid ) { m_usePyramid = usePyramid; }
+
+    /**
+     * @brief Selects the engine used to calculate the bowtie match spaces
+     *
+     * The DFT engine transforms each searched image once and matches it against template
+     * spectra that are cached for the process, so the rotation refinement transforms the
+     * region around a bowtie once for all of the rotated templates.
+     *
+     * @param engine MATCH_ENGINE_SPATIAL=cv::matchTemplate() (default), MATCH_ENGINE_DFT=Cached template spectra
+     */
+    void SetMatchEngine( const GC_MATCH_ENGINE engine ) { m_matchEngine = engine; }
+
     /**
      * @brief Search the image for eight calibration targets
      * @param img Image to search
@@ -132,6 +183,9 @@ public:
 
     /**
      * @brief Search for the move targets in the provided image
+     *
+     * The search state is kept on the stack, so several images may be searched at once.
+     *
      * @param img Image within which to search
      * @param ptLeft The found position of the left region
      * @param ptRight The found position of the right region
@@ -164,18 +218,24 @@ public:
     GC_STATUS GetFoundPoints( vector< vector< cv::Point2d > > &pts );
 
 private:
-    std::vector< cv::Mat > m_templates;
-    cv::Mat m_matchSpace;
-    cv::Mat m_matchSpaceSmall;
+    std::shared_ptr< const BowtieTemplateBank > m_bowtieBank;
+    bool m_usePyramid;
+    GC_MATCH_ENGINE m_matchEngine;
     std::vector< TemplateBowtieItem > m_matchItems;
     std::vector< std::vector< TemplateBowtieItem > > m_itemArray;
     cv::Rect m_rectLeftMoveSearch;
     cv::Rect m_rectRightMoveSearch;
 
-    GC_STATUS RotateImage( const cv::Mat &src, cv::Mat &dst, const double angle );
-    GC_STATUS MatchTemplate( const int index, const cv::Mat &img, const double minScore, const int numToFind );
-    GC_STATUS MatchRefine( const int index, const cv::Mat &img, const double minScore,
-                           const int numToFind, TemplateBowtieItem &item );
+    static GC_STATUS GetBowtieTemplateBank( const int templateDimEven, std::shared_ptr< const BowtieTemplateBank > &bank );
+    static GC_STATUS BuildBowtieTemplateBank( const int templateDimEven, BowtieTemplateBank &bank );
+    static GC_STATUS RotateImage( const cv::Mat &src, cv::Mat &dst, const double angle );
+    GC_STATUS MatchTemplate( const int index, const cv::Mat &img, const double minScore,
+                             const int numToFind, std::vector< TemplateBowtieItem > &items );
+    GC_STATUS MatchTemplateLocal( const int index, const cv::Mat &img, const cv::Point ptCoarse,
+                                  const int searchRadius, cv::Point &ptMatch, double &score );
+    GC_STATUS MatchRefine( const int index, const cv::Mat &img, const cv::Rect rect, const DFTSearchImage *searchDFT,
+                           cv::Mat &matchSpace, double &score, cv::Point &ptMax ) const;
+    GC_STATUS MatchRefineRotations( const cv::Mat &img, const double minScore, TemplateBowtieItem &item );
 
     GC_STATUS SubpixelPointRefine( const cv::Mat &matchSpace, const cv::Point ptMax, cv::Point2d &ptResult );
     GC_STATUS SortPoints( const cv::Size sizeSearchImage );
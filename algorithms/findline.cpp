@@ -16,12 +16,13 @@
 
 #include "log.h"
 #include "findline.h"
-#include <chrono>
+#include <algorithm>
 #include <opencv2/imgproc.hpp>
 #include <opencv2/imgcodecs.hpp>
 
-#ifndef DEBUG_FIND_LINE
-#define DEBUG_FIND_LINE
+// Diagnostic images (rowsums.png, ransac.png) and random sample traces are only produced
+// when built with DEBUG_FIND_LINE defined, e.g. qmake CONFIG+=debug_find_line
+#ifdef DEBUG_FIND_LINE
 #include <iostream>
 #include <boost/filesystem.hpp>
 #ifdef WIN32
@@ -38,14 +39,17 @@ using namespace boost;
 namespace fs = boost::filesystem;
 #endif
 
-static const int MEDIAN_FILTER_KERN_SIZE = 9;
+static const size_t MEDIAN_FILTER_KERN_SIZE = 9;
 
 namespace gc
 {
 
 FindLine::FindLine() :
     m_minLineFindAngle( DEFAULT_MIN_LINE_ANGLE ),
-    m_maxLineFindAngle( DEFAULT_MAX_LINE_ANGLE )
+    m_maxLineFindAngle( DEFAULT_MAX_LINE_ANGLE ),
+    m_randomEngine( FIT_LINE_RANSAC_DEFAULT_SEED ),
+    m_ransacSeed( FIT_LINE_RANSAC_DEFAULT_SEED ),
+    m_medianKernSize( MEDIAN_FILTER_KERN_SIZE )
 {
 #ifdef DEBUG_FIND_LINE
     if ( !fs::exists( DEBUG_RESULT_FOLDER ) )
@@ -105,6 +109,12 @@ GC_STATUS FindLine::FindMoveTargets( const Mat &img, FindPointSet &ptsFound )
     return retVal;
 }
 GC_STATUS FindLine::Find( const Mat &img, const vector< LineEnds > &lines, FindLineResult &result )
+{
+    SearchSwathTable noTable;
+    GC_STATUS retVal = Find( img, lines, noTable, result );
+    return retVal;
+}
+GC_STATUS FindLine::Find( const Mat &img, const vector< LineEnds > &lines, const SearchSwathTable &swathTable, FindLineResult &result )
 {
     result.findSuccess = false;
     GC_STATUS retVal = lines.empty() || img.empty() ? GC_ERR : GC_OK;
@@ -116,14 +126,17 @@ GC_STATUS FindLine::Find( const Mat &img, const vector< LineEnds > &lines, FindL
     {
         try
         {
-            // clean-up a little
+            // clean-up a little (only the search region is sampled, so with a valid swath
+            // table only the search region is cleaned up)
+            bool useTable = swathTable.IsValidFor( img, lines );
+
             Mat scratch;
-            Mat kern = getStructuringElement( MORPH_RECT, Size( 1, 9 ) );
-            dilate( img, scratch, kern, Point( -1, -1 ), 3 );
-            erode( scratch, scratch, kern, Point( -1, -1 ), 3 );
+            Mat kern = getStructuringElement( MORPH_RECT, Size( 1, GC_FINDLINE_MORPH_KERN_HEIGHT ) );
+            dilate( useTable ? img( swathTable.roi ) : img, scratch, kern, Point( -1, -1 ), GC_FINDLINE_MORPH_ITERATIONS );
+            erode( scratch, scratch, kern, Point( -1, -1 ), GC_FINDLINE_MORPH_ITERATIONS );
 
-            Mat outImg;
 #ifdef DEBUG_FIND_LINE
+            Mat outImg;
             if ( CV_8UC1 == img.type() )
                 cvtColor( img, outImg, COLOR_GRAY2BGR );
             else if ( CV_8UC3 == img.type() )
@@ -137,13 +150,14 @@ GC_STATUS FindLine::Find( const Mat &img, const vector< LineEnds > &lines, FindL
 
             size_t start;
             Point2d linePt;
+            SearchSwathTable noTable;
             vector< uint > rowSums;
             result.clear();
-            size_t linesPerSwath = lines.size() / 10;
-            for ( size_t i = 0; i < 10; ++i )
+            size_t linesPerSwath = lines.size() / GC_SEARCH_SWATH_COUNT;
+            for ( size_t i = 0; i < GC_SEARCH_SWATH_COUNT; ++i )
             {
                 start = i * linesPerSwath;
-                retVal = EvaluateSwath( scratch, lines, start, start + linesPerSwath, linePt, result );
+                retVal = EvaluateSwath( scratch, lines, useTable ? swathTable : noTable, i, start, start + linesPerSwath, linePt, result );
                 if ( GC_OK == retVal )
                     result.foundPoints.push_back( linePt );
             }
@@ -159,7 +173,7 @@ GC_STATUS FindLine::Find( const Mat &img, const vector< LineEnds > &lines, FindL
 #if 1
             FindPointSet findPtSet;
             double xCenter = ( lines[ 0 ].bot.x + lines[ lines.size() - 1 ].bot.x ) / 2.0;
-            retVal = FitLineRANSAC( result.foundPoints, result.calcLinePts, xCenter, scratch );
+            retVal = FitLineRANSAC( result.foundPoints, result.calcLinePts, xCenter, img );
             if ( GC_OK == retVal )
             {
                 result.findSuccess = true;
@@ -190,7 +204,7 @@ GC_STATUS FindLine::Find( const Mat &img, const vector< LineEnds > &lines, FindL
 GC_STATUS FindLine::FitLineRANSAC( const std::vector< Point2d > &pts, FindPointSet &findPtSet,
                                    const double xCenter, const cv::Mat &img )
 {
-    GC_STATUS retVal = 5 > pts.size() ? GC_ERR : GC_OK;
+    GC_STATUS retVal = FIT_LINE_RANSAC_POINT_COUNT > static_cast< int >( pts.size() ) ? GC_ERR : GC_OK;
     if ( GC_OK != retVal )
     {
         FILE_LOG( logERROR ) << "[FindLine::FitLineRANSAC] At least five points are needed to fit a line";
@@ -206,25 +220,37 @@ GC_STATUS FindLine::FitLineRANSAC( const std::vector< Point2d > &pts, FindPointS
             else
                 scratch = img.clone();
 #endif
+            // the engine is reset for every fit so a level never depends on the images fit before it
+            m_randomEngine.seed( m_ransacSeed );
+
+            int ptCount = static_cast< int >( pts.size() );
+            m_ransacIndices.resize( pts.size() );
+            for ( int i = 0; i < ptCount; ++i )
+                m_ransacIndices[ i ] = i;
+            m_ransacLines.clear();
+            m_ransacLines.reserve( FIT_LINE_RANSAC_TRIES_EARLY_OUT );
+
+            int swapIndex;
             Vec4d lineVec;
-            vector< int > indices;
-            vector< Point2d > ptSet;
-            vector< FindPointSet > validLines;
+            RansacLine ransacLine;
             for ( int i = 0; i < FIT_LINE_RANSAC_TRIES_TOTAL; ++i )
             {
-                retVal = GetRandomNumbers( 0, static_cast< int >( pts.size() ) - 1, FIT_LINE_RANSAC_POINT_COUNT, indices, 0 == i );
-                if ( GC_OK == retVal )
+                // partial Fisher-Yates shuffle, the first FIT_LINE_RANSAC_POINT_COUNT indices are the sample.
+                // the engine output is scaled to the range rather than passed through a std:: distribution,
+                // whose results differ between standard libraries
+                for ( int j = 0; j < FIT_LINE_RANSAC_POINT_COUNT; ++j )
                 {
-                    ptSet.clear();
-                    for ( size_t i = 0; i < indices.size(); ++i )
-                    {
+                    swapIndex = j + static_cast< int >( ( static_cast< unsigned long long >( m_randomEngine() ) *
+                                                          static_cast< unsigned long long >( ptCount - j ) ) >> 32 );
+                    std::swap( m_ransacIndices[ j ], m_ransacIndices[ swapIndex ] );
 #ifdef DEBUG_FIND_LINE
-                        circle( scratch, pts[ indices[ i ] ], 5, Scalar( 0, 255, 255 ), 3 );
+                    circle( scratch, pts[ m_ransacIndices[ j ] ], 5, Scalar( 0, 255, 255 ), 3 );
 #endif
-                        ptSet.push_back( pts[ indices[ i ] ] );
-                    }
+                }
 
-                    fitLine( ptSet, lineVec, DIST_L2, 0.0, 0.01, 0.01 );
+                retVal = FitSampleLine( pts, &m_ransacIndices[ 0 ], FIT_LINE_RANSAC_POINT_COUNT, lineVec );
+                if ( GC_OK == retVal )
+                {
                     findPtSet.lftPixel.x = lineVec[ 2 ] + ( lineVec[ 0 ] * -lineVec[ 2 ] );
                     findPtSet.lftPixel.y = lineVec[ 3 ] + ( lineVec[ 1 ] * -lineVec[ 2 ] );
                     findPtSet.rgtPixel.x = lineVec[ 2 ] + ( lineVec[ 0 ] * ( img.cols - lineVec[ 2 ] - 1 ) );
@@ -238,33 +264,44 @@ GC_STATUS FindLine::FitLineRANSAC( const std::vector< Point2d > &pts, FindPointS
 #endif
                     if ( m_minLineFindAngle <= findPtSet.anglePixel && m_maxLineFindAngle >= findPtSet.anglePixel )
                     {
-                        validLines.push_back( findPtSet );
+                        ransacLine.ctrY = findPtSet.ctrPixel.y;
+                        ransacLine.angle = findPtSet.anglePixel;
+                        m_ransacLines.push_back( ransacLine );
                     }
-                    if ( validLines.size() >= FIT_LINE_RANSAC_TRIES_EARLY_OUT )
+                    if ( m_ransacLines.size() >= FIT_LINE_RANSAC_TRIES_EARLY_OUT )
                         break;
                 }
             }
 #ifdef DEBUG_FIND_LINE
             imwrite( DEBUG_RESULT_FOLDER + "ransac.png", scratch );
 #endif
-            if ( 9 > validLines.size() )
+            if ( 9 > m_ransacLines.size() )
             {
                 FILE_LOG( logERROR ) << "[FindLine::FitLineRANSAC] No valid lines found";
                 retVal = GC_ERR;
             }
             else
             {
-                sort( validLines.begin(), validLines.end(), []( FindPointSet a, FindPointSet b ) {
-                    return a.ctrPixel.y > b.ctrPixel.y; } );
+                // only the middle half of the lines ordered by center height is averaged, so the
+                // lines are partitioned around its ends and only the middle half is sorted. Ties in
+                // center height are ordered by angle, so which lines are averaged and the order they
+                // are summed in do not depend on the standard library
+                size_t start = m_ransacLines.size() >> 2;
+                size_t end = m_ransacLines.size() - start;
+                auto isHigher = []( const RansacLine &a, const RansacLine &b )
+                {
+                    return a.ctrY > b.ctrY || ( a.ctrY == b.ctrY && a.angle > b.angle );
+                };
+                std::nth_element( m_ransacLines.begin(), m_ransacLines.begin() + start, m_ransacLines.end(), isHigher );
+                std::nth_element( m_ransacLines.begin() + start, m_ransacLines.begin() + end, m_ransacLines.end(), isHigher );
+                std::sort( m_ransacLines.begin() + start, m_ransacLines.begin() + end, isHigher );
 
                 double totalY = 0.0;
                 double totalTheta = 0.0;
-                size_t start = validLines.size() >> 2;
-                size_t end = validLines.size() - start;
                 for ( size_t i = start; i < end; ++i )
                 {
-                    totalY += validLines[ i ].ctrPixel.y;
-                    totalTheta += validLines[ i ].anglePixel;
+                    totalY += m_ransacLines[ i ].ctrY;
+                    totalTheta += m_ransacLines[ i ].angle;
                 }
                 findPtSet.ctrPixel.x = xCenter;
                 findPtSet.ctrPixel.y = totalY / static_cast< double >( end - start );
@@ -310,73 +347,39 @@ GC_STATUS FindLine::GetSlopeIntercept( const Point2d one, const Point2d two, dou
     }
     return retVal;
 }
-GC_STATUS FindLine::GetRandomNumbers( const int low_bound, const int high_bound, const int cnt_to_generate,
-                                      vector< int > &numbers, const bool isFirst )
+GC_STATUS FindLine::FitSampleLine( const std::vector< Point2d > &pts, const int *indices, const int count, Vec4d &lineVec )
 {
     GC_STATUS retVal = GC_OK;
     try
     {
-        if ( high_bound - low_bound + 1 < static_cast< int >( numbers.size() ) / 2 )
+        // closed form of cv::fitLine() with DIST_L2: the line passes through the centroid of the points
+        // along the major axis of their covariance
+        double x = 0.0, y = 0.0, x2 = 0.0, y2 = 0.0, xy = 0.0;
+        for ( int i = 0; i < count; ++i )
         {
-            FILE_LOG( logERROR ) << "[FindLine::GetRandomNumbers] Not enough points to find good numbers";
-            retVal = GC_ERR;
-        }
-        else
-        {
-            if ( isFirst )
-            {
-                auto seed = std::chrono::system_clock::now().time_since_epoch().count(); //seed
-                m_randomEngine.seed( static_cast< unsigned int >( seed ) );
-            }
-
-            std::uniform_int_distribution< int > di( low_bound, high_bound ); //distribution
-
-            vector< int > tempVec;
-            for ( int i = 0; i < cnt_to_generate; ++i )
-                tempVec.push_back( 0 );
-
-            bool foundIt;
-            int tries = 10;
-            numbers.clear();
-            while ( tries > 0 && static_cast< int >( numbers.size() ) < cnt_to_generate )
-            {
-                std::generate( tempVec.begin(), tempVec.end(), [ & ]{ return di( m_randomEngine ); } );
-                for ( size_t i = 0; i < tempVec.size(); ++i )
-                {
-                    foundIt = false;
-                    for ( size_t j = 0; j < numbers.size(); ++j )
-                    {
-                        if ( tempVec[ i ] == numbers[ j ] )
-                        {
-                            foundIt = true;
-                            break;
-                        }
-                    }
-                    if ( !foundIt )
-                    {
-                        numbers.push_back( tempVec[ i ] );
-                        if ( static_cast< int >( numbers.size() ) >= cnt_to_generate )
-                            break;
-                    }
-                }
-                --tries;
-            }
-            if ( static_cast< int >( numbers.size() ) < cnt_to_generate )
-            {
-                FILE_LOG( logERROR ) << "[FindLine::GetRandomNumbers] Not enough unique numbers found";
-                retVal = GC_ERR;
-            }
-
-#ifdef DEBUG_FIND_LINE
-            for ( size_t i = 0; i < static_cast< size_t >( cnt_to_generate ); ++i )
-                std::cout << numbers[ i ] << ", ";
-            std::cout << endl;
-#endif
+            const Point2d &pt = pts[ indices[ i ] ];
+            x += pt.x;
+            y += pt.y;
+            x2 += pt.x * pt.x;
+            y2 += pt.y * pt.y;
+            xy += pt.x * pt.y;
         }
+        double invCount = 1.0 / static_cast< double >( count );
+        x *= invCount;
+        y *= invCount;
+        double dx2 = x2 * invCount - x * x;
+        double dy2 = y2 * invCount - y * y;
+        double dxy = xy * invCount - x * y;
+        double theta = atan2( 2.0 * dxy, dx2 - dy2 ) / 2.0;
+
+        lineVec[ 0 ] = cos( theta );
+        lineVec[ 1 ] = sin( theta );
+        lineVec[ 2 ] = x;
+        lineVec[ 3 ] = y;
     }
     catch( std::exception &e )
     {
-        FILE_LOG( logERROR ) << "[FindLine::GetRandomNumbers] " << e.what();
+        FILE_LOG( logERROR ) << "[FindLine::FitSampleLine] " << e.what();
         retVal = GC_EXCEPT;
     }
     return retVal;
@@ -515,8 +518,9 @@ GC_STATUS FindLine::DrawResult( const Mat &img, Mat &imgOut, const FindLineResul
     }
     return retVal;
 }
-GC_STATUS FindLine::EvaluateSwath( const Mat &img, const vector< LineEnds > &lines, const size_t startIndex,
-                                   const size_t endIndex, Point2d &resultPt, FindLineResult &result )
+GC_STATUS FindLine::EvaluateSwath( const Mat &img, const vector< LineEnds > &lines, const SearchSwathTable &swathTable,
+                                   const size_t swathIndex, const size_t startIndex, const size_t endIndex,
+                                   Point2d &resultPt, FindLineResult &result )
 {
     GC_STATUS retVal = ( lines.empty() || img.empty() || startIndex > endIndex ||
                          lines.size() - 1 < endIndex ) ? GC_ERR : GC_OK;
@@ -528,22 +532,26 @@ GC_STATUS FindLine::EvaluateSwath( const Mat &img, const vector< LineEnds > &lin
     {
         try
         {
-            vector< LineEnds > swath;
-            for ( size_t i = startIndex; i <= endIndex; ++i )
-                swath.push_back( lines[ i ] );
-
             vector< uint > rowSums;
-            retVal = CalcRowSums( img, swath, rowSums );
+            if ( swathIndex < swathTable.lineStart.size() && startIndex == swathTable.lineStart[ swathIndex ] &&
+                 endIndex == swathTable.lineEnd[ swathIndex ] )
+            {
+                retVal = CalcRowSums( img, swathTable, swathIndex, rowSums );
+            }
+            else
+            {
+                retVal = CalcRowSums( img, lines, startIndex, endIndex, rowSums );
+            }
             if ( GC_OK == retVal )
             {
-                retVal = CalculateRowSumsLines( rowSums, swath, result.diagRowSums,
+                retVal = CalculateRowSumsLines( rowSums, lines[ startIndex ], result.diagRowSums,
                                                 result.diag1stDeriv, result.diag2ndDeriv );
                 if ( GC_OK != retVal )
                 {
                     FILE_LOG( logWARNING ) << "[FindLine::EvaluateSwath] Cannot retrieve diagnosic line points";
                     retVal = GC_OK;
                 }
-                retVal = CalcSwathPoint( swath, rowSums, resultPt );
+                retVal = CalcSwathPoint( lines[ startIndex ], lines[ endIndex ], rowSums, resultPt );
             }
         }
         catch( cv::Exception &e )
@@ -555,9 +563,9 @@ GC_STATUS FindLine::EvaluateSwath( const Mat &img, const vector< LineEnds > &lin
 
     return retVal;
 }
-GC_STATUS FindLine::CalcSwathPoint( const vector< LineEnds > &swath, const vector< uint > &rowSums, Point2d &resultPt )
+GC_STATUS FindLine::CalcSwathPoint( const LineEnds &firstLine, const LineEnds &lastLine, const vector< uint > &rowSums, Point2d &resultPt )
 {
-    GC_STATUS retVal = ( swath.empty() || rowSums.empty() ) ? GC_ERR : GC_OK;
+    GC_STATUS retVal = rowSums.empty() ? GC_ERR : GC_OK;
     if ( GC_OK != retVal )
     {
         FILE_LOG( logERROR ) << "[FindLine::CalcSwathPoint] Cannot calculate swath point with empty line or rowsums vector(s)";
@@ -585,12 +593,12 @@ GC_STATUS FindLine::CalcSwathPoint( const vector< LineEnds > &swath, const vecto
             }
             else
             {
-                resultPt.x = static_cast< double >( swath[ 0 ].top.x + swath[ swath.size() - 1 ].top.x ) / 2.0;
+                resultPt.x = static_cast< double >( firstLine.top.x + lastLine.top.x ) / 2.0;
                 double total = static_cast< double >( rowSums[ static_cast< size_t >( index - 1 ) ] * static_cast< uint >( ( index - 1 ) ) +
                                                       rowSums[ static_cast< size_t >( index ) ] * static_cast< uint >( index ) +
                                                       rowSums[ static_cast< size_t >( index + 1 ) ] * static_cast< uint >( index + 1 ) );
                 double denom = ( rowSums[ static_cast< size_t >( index - 1 ) ] + rowSums[ static_cast< size_t >( index ) ] + rowSums[ static_cast< size_t >( index + 1 ) ] );
-                resultPt.y = ( total / denom ) + static_cast< double >( swath[ 0 ].top.y + swath[ swath.size() - 1 ].top.y ) / 2.0;
+                resultPt.y = ( total / denom ) + static_cast< double >( firstLine.top.y + lastLine.top.y ) / 2.0;
 
             }
         }
@@ -602,9 +610,10 @@ GC_STATUS FindLine::CalcSwathPoint( const vector< LineEnds > &swath, const vecto
     }
     return retVal;
 }
-GC_STATUS FindLine::CalcRowSums( const Mat &img, const vector< LineEnds > &lines, vector< uint > &rowSums )
+GC_STATUS FindLine::CalcRowSums( const Mat &img, const vector< LineEnds > &lines, const size_t startIndex,
+                                 const size_t endIndex, vector< uint > &rowSums )
 {
-    GC_STATUS retVal = lines.empty() || img.empty() ? GC_ERR : GC_OK;
+    GC_STATUS retVal = lines.empty() || img.empty() || endIndex >= lines.size() ? GC_ERR : GC_OK;
     if ( GC_OK != retVal )
     {
         FILE_LOG( logERROR ) << "[FindLine::CalcRowSums] Cannot calculate row sums with no search lines defined or in a NULL image";
@@ -614,20 +623,52 @@ GC_STATUS FindLine::CalcRowSums( const Mat &img, const vector< LineEnds > &lines
         try
         {
             rowSums.clear();
-            vector< uint > rowSumsTemp;
-            int height = lines[ 0 ].bot.y - lines[ 0 ].top.y;
-            for ( int i = 0; i < height; ++i )
-                rowSumsTemp.push_back( 0 );
+            int height = lines[ startIndex ].bot.y - lines[ startIndex ].top.y;
+            m_rowSumsRaw.assign( static_cast< size_t >( std::max( 0, height ) ), 0 );
 
-            for ( size_t i = 0; i < lines.size(); ++i )
+            for ( size_t i = startIndex; i <= endIndex; ++i )
             {
                 LineIterator iter( img, lines[ i ].top, lines[ i ].bot );
                 for ( int j = 0; j < std::min( height, iter.count ); ++j, ++iter )
                 {
-                    rowSumsTemp[ static_cast< size_t >( j ) ] += static_cast< uint >( **iter );
+                    m_rowSumsRaw[ static_cast< size_t >( j ) ] += static_cast< uint >( **iter );
                 }
             }
-            retVal = MedianFilter( MEDIAN_FILTER_KERN_SIZE, rowSumsTemp, rowSums );
+            retVal = MedianFilter( m_medianKernSize, m_rowSumsRaw, rowSums, m_medianSortBuf, m_medianWindow );
+        }
+        catch( cv::Exception &e )
+        {
+            FILE_LOG( logERROR ) << "[FindLine::CalcRowSums] " << e.what();
+            retVal = GC_EXCEPT;
+        }
+    }
+
+    return retVal;
+}
+GC_STATUS FindLine::CalcRowSums( const Mat &img, const SearchSwathTable &swathTable, const size_t swathIndex, vector< uint > &rowSums )
+{
+    GC_STATUS retVal = img.empty() || swathIndex >= swathTable.rowCount.size() || !img.isContinuous() ||
+                       img.cols != swathTable.roi.width || img.rows != swathTable.roi.height ? GC_ERR : GC_OK;
+    if ( GC_OK != retVal )
+    {
+        FILE_LOG( logERROR ) << "[FindLine::CalcRowSums] Cannot calculate row sums with an invalid swath or in a NULL or mismatched search region image";
+    }
+    else
+    {
+        try
+        {
+            rowSums.clear();
+            m_rowSumsRaw.assign( swathTable.rowCount[ swathIndex ], 0 );
+
+            const uchar *pixels = img.ptr< uchar >( 0 );
+            const uint32_t *offsets = swathTable.offsets.data();
+            const uint32_t *bins = swathTable.bins.data();
+            uint *sums = m_rowSumsRaw.data();
+            for ( size_t i = swathTable.sampleStart[ swathIndex ]; i < swathTable.sampleStart[ swathIndex + 1 ]; ++i )
+            {
+                sums[ bins[ i ] ] += static_cast< uint >( pixels[ offsets[ i ] ] );
+            }
+            retVal = MedianFilter( m_medianKernSize, m_rowSumsRaw, rowSums, m_medianSortBuf, m_medianWindow );
         }
         catch( cv::Exception &e )
         {
@@ -638,10 +679,10 @@ GC_STATUS FindLine::CalcRowSums( const Mat &img, const vector< LineEnds > &lines
 
     return retVal;
 }
-GC_STATUS FindLine::CalculateRowSumsLines( const vector< uint > rowSums, const vector< LineEnds > lines, vector< vector< Point > > &rowSumsLines,
+GC_STATUS FindLine::CalculateRowSumsLines( const vector< uint > &rowSums, const LineEnds &firstLine, vector< vector< Point > > &rowSumsLines,
                                            vector< vector< Point > > &deriveOneLines,  vector< vector< Point > > &deriveTwoLines )
 {
-    GC_STATUS retVal = lines.empty() || rowSums.empty() ? GC_ERR : GC_OK;
+    GC_STATUS retVal = rowSums.empty() ? GC_ERR : GC_OK;
     if ( GC_OK != retVal )
     {
         FILE_LOG( logERROR ) << "[FindLine::CalculateRowSumsLines] Cannot calculate row sums line points with empty search lines, image, or row sum array";
@@ -657,12 +698,11 @@ GC_STATUS FindLine::CalculateRowSumsLines( const vector< uint > rowSums, const v
                     maxVal = rowSums[ i ];
             }
 
-            int beg = min( lines[ 0 ].top.x, lines[ 0 ].bot.x ) - 180;
-            // double wide = static_cast< double >( min( lines[ lines.size() - 1 ].top.x, lines[ lines.size() - 1 ].bot.x ) - beg - 3 );
+            int beg = min( firstLine.top.x, firstLine.bot.x ) - 180;
             double wide = 64.0;
 
             int right;
-            int y = lines[ 0 ].top.y;
+            int y = firstLine.top.y;
             double dMaxVal = static_cast< double >( maxVal );
 
             vector< Point > rowSumsPts;
@@ -700,7 +740,7 @@ GC_STATUS FindLine::CalculateRowSumsLines( const vector< uint > rowSums, const v
             else
             {
                 beg += 120;
-                y = lines[ 0 ].top.y + 1;
+                y = firstLine.top.y + 1;
                 rowSumsPts.clear();
 
                 int minDiff2 = 9999999;
@@ -737,7 +777,7 @@ GC_STATUS FindLine::CalculateRowSumsLines( const vector< uint > rowSums, const v
                 else
                 {
                     beg += 150;
-                    y = lines[ 0 ].top.y + 1;
+                    y = firstLine.top.y + 1;
                     rowSumsPts.clear();
 
                     double totDiff = maxDiff2 - minDiff;
@@ -767,7 +807,27 @@ GC_STATUS FindLine::CalculateRowSumsLines( const vector< uint > rowSums, const v
 
     return retVal;
 }
-GC_STATUS FindLine::MedianFilter( const size_t kernSize, const vector< uint > values, vector< uint > &valuesOut )
+GC_STATUS FindLine::SetMedianFilterKernSize( const size_t kernSize )
+{
+    GC_STATUS retVal = GC_OK;
+    if ( 3 > kernSize )
+    {
+        FILE_LOG( logERROR ) << "[FindLine::SetMedianFilterKernSize] Median filter kernel size must be 3 or more: size=" << kernSize;
+        retVal = GC_ERR;
+    }
+    else
+    {
+        m_medianKernSize = kernSize;
+    }
+    return retVal;
+}
+// The kernSize >> 1 values at either end use shrinking windows as before. The rest use one sorted
+// window that is slid a value at a time (binary search remove/insert) rather than being refilled and
+// partitioned for every output value. It yields the same order statistic as the nth_element version.
+// A step shifts up to kernSize values, for the kernel sizes used (9 to 21) that is a memmove within
+// a cache line or two, which beats the pointer chasing of a two heap or multiset window.
+GC_STATUS FindLine::MedianFilter( const size_t kernSize, const vector< uint > &values, vector< uint > &valuesOut,
+                                  vector< uint > &sortBuf, vector< uint > &window )
 {
     GC_STATUS retVal = values.empty() || 3 > kernSize || kernSize * 2 > values.size() ? GC_ERR : GC_OK;
     if ( GC_OK != retVal )
@@ -779,37 +839,40 @@ GC_STATUS FindLine::MedianFilter( const size_t kernSize, const vector< uint > va
         try
         {
             valuesOut.clear();
-            vector< uint > sortVec;
+            valuesOut.reserve( values.size() );
+
+            vector< uint > &sortVec = sortBuf;
             size_t halfVec, kernHalf = kernSize >> 1;
             for ( size_t i = 0; i < kernHalf; ++i )
             {
-                sortVec.clear();
-                for ( size_t j = 0; j < kernHalf + i; j++ )
-                    sortVec.push_back( values[ j ] );
+                sortVec.assign( values.begin(), values.begin() + static_cast< long >( kernHalf + i ) );
                 halfVec = sortVec.size() / 2;
-                nth_element( sortVec.begin(), sortVec.begin() + static_cast< int >( halfVec ), sortVec.end() );
+                nth_element( sortVec.begin(), sortVec.begin() + static_cast< long >( halfVec ), sortVec.end() );
                 if ( 0 == sortVec.size() % 2 )
-                    valuesOut.push_back( ( sortVec[ halfVec ] + sortVec[ halfVec + 1 ] ) / 2 );
+                    valuesOut.push_back( ( sortVec[ halfVec ] + sortVec[ std::min( halfVec + 1, sortVec.size() - 1 ) ] ) / 2 );
                 else
                     valuesOut.push_back( sortVec[ halfVec ] );
             }
-            for ( int i = static_cast< int >( kernHalf ); i < static_cast< int >( values.size() - kernHalf ); ++i )
+
+            window.assign( values.begin(), values.begin() + static_cast< long >( kernHalf * 2 ) );
+            sort( window.begin(), window.end() );
+            for ( size_t i = kernHalf; i < values.size() - kernHalf; ++i )
             {
-                sortVec.clear();
-                for ( int j = -static_cast< int >( kernHalf ); j < static_cast< int >( kernHalf ); j++ )
-                    sortVec.push_back( values[ static_cast< size_t >( i + j ) ] );
-                nth_element( sortVec.begin(), sortVec.begin() + static_cast< int >( kernHalf ), sortVec.end() );
-                valuesOut.push_back( sortVec[ kernHalf ] );
+                valuesOut.push_back( window[ kernHalf ] );
+                if ( i + 1 < values.size() - kernHalf )
+                {
+                    window.erase( lower_bound( window.begin(), window.end(), values[ i - kernHalf ] ) );
+                    window.insert( upper_bound( window.begin(), window.end(), values[ i + kernHalf ] ), values[ i + kernHalf ] );
+                }
             }
+
             for ( size_t i = values.size() - kernHalf; i < values.size(); ++i )
             {
-                sortVec.clear();
-                for ( size_t j = i - kernHalf; j < values.size(); j++ )
-                    sortVec.push_back( values[ j ] );
+                sortVec.assign( values.begin() + static_cast< long >( i - kernHalf ), values.end() );
                 halfVec = sortVec.size() / 2;
-                nth_element( sortVec.begin(), sortVec.begin() + static_cast< int >( halfVec ), sortVec.end() );
+                nth_element( sortVec.begin(), sortVec.begin() + static_cast< long >( halfVec ), sortVec.end() );
                 if ( 0 == sortVec.size() % 2 )
-                    valuesOut.push_back( ( sortVec[ halfVec ] + sortVec[ halfVec + 1 ] ) / 2 );
+                    valuesOut.push_back( ( sortVec[ halfVec ] + sortVec[ std::min( halfVec + 1, sortVec.size() - 1 ) ] ) / 2 );
                 else
                     valuesOut.push_back( sortVec[ halfVec ] );
             }
@@ -67,6 +67,29 @@ public:
     // TODO: Add doxygen comments -- KWC
     GC_STATUS SetLineFindAngleBounds( const double minAngle, const double maxAngle );
 
+    /**
+     * @brief Sets the size of the median filter applied to the search line row sums
+     * @param kernSize Median filter kernel size (must be 3 or more, default is 9)
+     * @return GC_OK=Success, GC_FAIL=Failure, GC_EXCEPT=Exception thrown
+     */
+    GC_STATUS SetMedianFilterKernSize( const size_t kernSize );
+
+    /**
+     * @brief Median filters a row sum profile, the ends use windows that shrink to half the kernel size
+     *
+     * The full windows are filtered with one sorted window that is slid a value at a time. Each step
+     * is a binary search remove and insert, O(kernSize) for the shift of the window values.
+     *
+     * @param kernSize Median filter kernel size (must be 3 or more and at most half the number of values)
+     * @param values Values to filter
+     * @param valuesOut Filtered values, the same number as values
+     * @param sortBuf Scratch buffer for the end windows, reused between calls
+     * @param window Scratch buffer for the sliding window, reused between calls
+     * @return GC_OK=Success, GC_FAIL=Failure, GC_EXCEPT=Exception thrown
+     */
+    static GC_STATUS MedianFilter( const size_t kernSize, const std::vector< uint > &values, std::vector< uint > &valuesOut,
+                                   std::vector< uint > &sortBuf, std::vector< uint > &window );
+
     /**
      * @brief Initializes the bowtie target templates in this objects instance of the calibration object
      * @param bowTieTemplateDim The template dimension will create an nxn template
@@ -84,9 +107,42 @@ public:
      */
     GC_STATUS Find( const cv::Mat &img, const std::vector< LineEnds > &lines, FindLineResult &result );
 
-    // TODO: Add doxygen comments -- KWC
+    /**
+     * @brief Given an image with a calibration target find the water level in the image
+     *
+     * Row sums are gathered through the precomputed pixel offsets of the swath table when it matches the
+     * image and the search lines. Otherwise the search lines are walked pixel by pixel.
+     *
+     * @param img The image to be searched
+     * @param lines a vector of vertical lines that pass over the water line along which to be searched
+     * @param swathTable Pixel sampling table of the search lines (see Calib::SwathTable())
+     * @param result The result of the line search
+     * @return GC_OK=Success, GC_FAIL=Failure, GC_EXCEPT=Exception thrown
+     */
+    GC_STATUS Find( const cv::Mat &img, const std::vector< LineEnds > &lines,
+                    const SearchSwathTable &swathTable, FindLineResult &result );
+
+    /**
+     * @brief Fits the water line to the swath points by RANSAC
+     *
+     * Lines are fit to random sets of five points and the center height and angle of the
+     * middle half of the lines within the angle bounds are averaged. The random engine is
+     * reseeded with the RANSAC seed on every call, so the same points always give the same line.
+     *
+     * @param pts Points found in the search swaths
+     * @param findPtSet The fit line
+     * @param xCenter Column of the center of the search region
+     * @param img The image that was searched
+     * @return GC_OK=Success, GC_FAIL=Failure, GC_EXCEPT=Exception thrown
+     */
     GC_STATUS FitLineRANSAC( const std::vector< cv::Point2d > &pts, FindPointSet &findPtSet, const double xCenter, const cv::Mat &img );
 
+    /**
+     * @brief Sets the seed of the random engine of the RANSAC line fit
+     * @param seed Seed the random engine is reset to at the start of every line fit
+     */
+    void SetRansacSeed( const unsigned int seed ) { m_ransacSeed = seed; }
+
     /**
      * @brief Method to search for the move targets using an instance of the FindCalibGrid class
      * @param img The image for which to search for the bowtie targets
@@ -119,18 +175,33 @@ private:
     FindCalibGrid m_findGrid;
     double m_minLineFindAngle;
     double m_maxLineFindAngle;
-    std::default_random_engine m_randomEngine;
-
-    GC_STATUS GetRandomNumbers( const int low_bound, const int high_bound, const int cnt_to_generate,
-                                vector< int > &numbers, const bool isFirst );
-    GC_STATUS CalcRowSums( const cv::Mat &img, const std::vector< LineEnds > &lines, std::vector< uint > &rowSums );
-    GC_STATUS EvaluateSwath( const cv::Mat &img, const std::vector< LineEnds > &lines, const size_t startIndex,
-                             const size_t endIndex, cv::Point2d &resultPt, FindLineResult &result );
-    GC_STATUS CalcSwathPoint( const std::vector< LineEnds > &swath, const std::vector< uint > &rowSums, cv::Point2d &resultPt );
-    GC_STATUS MedianFilter( const size_t kernSize, const std::vector< uint > values, std::vector< uint > &valuesOut );
+    // center height and angle of a RANSAC candidate line
+    struct RansacLine
+    {
+        double ctrY;
+        double angle;
+    };
+
+    std::mt19937 m_randomEngine;
+    unsigned int m_ransacSeed;
+    std::vector< int > m_ransacIndices;
+    std::vector< RansacLine > m_ransacLines;
+    size_t m_medianKernSize;
+    std::vector< uint > m_rowSumsRaw;
+    std::vector< uint > m_medianSortBuf;
+    std::vector< uint > m_medianWindow;
+
+    GC_STATUS FitSampleLine( const std::vector< cv::Point2d > &pts, const int *indices, const int count, cv::Vec4d &lineVec );
+    GC_STATUS CalcRowSums( const cv::Mat &img, const std::vector< LineEnds > &lines, const size_t startIndex,
+                           const size_t endIndex, std::vector< uint > &rowSums );
+    GC_STATUS CalcRowSums( const cv::Mat &img, const SearchSwathTable &swathTable, const size_t swathIndex, std::vector< uint > &rowSums );
+    GC_STATUS EvaluateSwath( const cv::Mat &img, const std::vector< LineEnds > &lines, const SearchSwathTable &swathTable,
+                             const size_t swathIndex, const size_t startIndex, const size_t endIndex,
+                             cv::Point2d &resultPt, FindLineResult &result );
+    GC_STATUS CalcSwathPoint( const LineEnds &firstLine, const LineEnds &lastLine, const std::vector< uint > &rowSums, cv::Point2d &resultPt );
 
     GC_STATUS GetSlopeIntercept( const cv::Point2d one, const cv::Point2d two, double &slope, double &intercept );
-    GC_STATUS CalculateRowSumsLines( const vector< uint > rowSums, const vector< LineEnds > lines, vector< vector< cv::Point > > &rowSumsLines,
+    GC_STATUS CalculateRowSumsLines( const vector< uint > &rowSums, const LineEnds &firstLine, vector< vector< cv::Point > > &rowSumsLines,
                                      vector< vector< cv::Point > > &deriveOneLines,  vector< vector< cv::Point > > &deriveTwoLines );
 };
 
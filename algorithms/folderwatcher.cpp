@@ -0,0 +1,224 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+   Copyright 2021 Kenneth W. Chapman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include "log.h"
+#include "folderwatcher.h"
+#include <algorithm>
+#include <boost/filesystem.hpp>
+#include <boost/exception/diagnostic_information.hpp>
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#else
+#include <chrono>
+#include <thread>
+#endif
+
+using namespace std;
+using namespace boost;
+namespace fs = boost::filesystem;
+
+#ifdef __linux__
+static const size_t FOLDER_WATCHER_EVENT_BUF_SIZE = 65536;
+#endif
+
+namespace gc
+{
+
+FolderWatcher::FolderWatcher()
+#ifdef __linux__
+    : m_inotifyFd( -1 )
+#endif
+{
+}
+FolderWatcher::~FolderWatcher()
+{
+    Close();
+}
+GC_STATUS FolderWatcher::Open( const string folder )
+{
+    GC_STATUS retVal = GC_OK;
+    Close();
+    try
+    {
+        if ( !fs::is_directory( folder ) )
+        {
+            FILE_LOG( logERROR ) << "[FolderWatcher::Open] Path specified is not a folder: " << folder;
+            retVal = GC_ERR;
+        }
+        else
+        {
+#ifdef __linux__
+            m_inotifyFd = inotify_init1( IN_CLOEXEC );
+            if ( 0 > m_inotifyFd )
+            {
+                FILE_LOG( logERROR ) << "[FolderWatcher::Open] Could not start inotify: " << strerror( errno );
+                retVal = GC_ERR;
+            }
+            else if ( 0 > inotify_add_watch( m_inotifyFd, folder.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO ) )
+            {
+                FILE_LOG( logERROR ) << "[FolderWatcher::Open] Could not watch " << folder << ": " << strerror( errno );
+                close( m_inotifyFd );
+                m_inotifyFd = -1;
+                retVal = GC_ERR;
+            }
+            else
+            {
+                m_eventBuf.resize( FOLDER_WATCHER_EVENT_BUF_SIZE );
+                m_folder = folder;
+            }
+#else
+            // the images already in the folder are taken as reported
+            for ( auto &p: fs::directory_iterator( folder ) )
+            {
+                if ( fs::is_regular_file( p.path() ) )
+                    m_reported.insert( p.path().string() );
+            }
+            m_folder = folder;
+#endif
+        }
+    }
+    catch( const boost::exception &e )
+    {
+        FILE_LOG( logERROR ) << "[FolderWatcher::Open] " << diagnostic_information( e );
+        Close();
+        retVal = GC_EXCEPT;
+    }
+    return retVal;
+}
+GC_STATUS FolderWatcher::Wait( const int timeoutMsecs, vector< string > &readyImages )
+{
+    GC_STATUS retVal = GC_OK;
+    readyImages.clear();
+    if ( !IsOpen() )
+    {
+        FILE_LOG( logERROR ) << "[FolderWatcher::Wait] No folder is being watched";
+        retVal = GC_ERR;
+    }
+    else
+    {
+        try
+        {
+#ifdef __linux__
+            pollfd pfd;
+            pfd.fd = m_inotifyFd;
+            pfd.events = POLLIN;
+            pfd.revents = 0;
+            int ret = poll( &pfd, 1, std::max( 0, timeoutMsecs ) );
+            if ( 0 > ret && EINTR != errno )
+            {
+                FILE_LOG( logERROR ) << "[FolderWatcher::Wait] Could not wait on " << m_folder << ": " << strerror( errno );
+                retVal = GC_ERR;
+            }
+            else if ( 0 < ret && ( pfd.revents & POLLIN ) )
+            {
+                ssize_t len = read( m_inotifyFd, &m_eventBuf[ 0 ], m_eventBuf.size() );
+                if ( 0 > len && EINTR != errno && EAGAIN != errno )
+                {
+                    FILE_LOG( logERROR ) << "[FolderWatcher::Wait] Could not read events of " << m_folder << ": " << strerror( errno );
+                    retVal = GC_ERR;
+                }
+                for ( ssize_t pos = 0; 0 < len && pos < len; )
+                {
+                    const inotify_event *event = reinterpret_cast< const inotify_event * >( &m_eventBuf[ pos ] );
+                    if ( event->mask & IN_Q_OVERFLOW )
+                    {
+                        FILE_LOG( logWARNING ) << "[FolderWatcher::Wait] Events were lost for " << m_folder;
+                    }
+                    else if ( 0 < event->len && !( event->mask & IN_ISDIR ) )
+                    {
+                        string filepath = ( fs::path( m_folder ) / fs::path( event->name ) ).string();
+                        if ( IsImageFile( filepath ) )
+                            readyImages.push_back( filepath );
+                    }
+                    pos += static_cast< ssize_t >( sizeof( inotify_event ) + event->len );
+                }
+            }
+#else
+            this_thread::sleep_for( chrono::milliseconds( std::max( 0, timeoutMsecs ) ) );
+            retVal = Poll( readyImages );
+#endif
+            sort( readyImages.begin(), readyImages.end() );
+            readyImages.erase( unique( readyImages.begin(), readyImages.end() ), readyImages.end() );
+        }
+        catch( const boost::exception &e )
+        {
+            FILE_LOG( logERROR ) << "[FolderWatcher::Wait] " << diagnostic_information( e );
+            retVal = GC_EXCEPT;
+        }
+    }
+    return retVal;
+}
+void FolderWatcher::Close()
+{
+#ifdef __linux__
+    if ( 0 <= m_inotifyFd )
+    {
+        close( m_inotifyFd );
+        m_inotifyFd = -1;
+    }
+#else
+    m_candidates.clear();
+    m_reported.clear();
+#endif
+    m_folder.clear();
+}
+bool FolderWatcher::IsImageFile( const string &filepath )
+{
+    string ext = fs::path( filepath ).extension().string();
+    return ext == ".png" || ext == ".jpg";
+}
+#ifndef __linux__
+GC_STATUS FolderWatcher::Poll( vector< string > &readyImages )
+{
+    GC_STATUS retVal = GC_OK;
+    boost::system::error_code ec;
+    PollCandidate current;
+    string filepath;
+    for ( auto &p: fs::directory_iterator( m_folder ) )
+    {
+        filepath = p.path().string();
+        if ( m_reported.end() == m_reported.find( filepath ) && IsImageFile( filepath ) )
+        {
+            current.fileSize = fs::file_size( p.path(), ec );
+            if ( !ec )
+                current.modTime = fs::last_write_time( p.path(), ec );
+            if ( !ec )
+            {
+                // a file whose size and time did not change since the last poll is no longer being written
+                auto found = m_candidates.find( filepath );
+                if ( m_candidates.end() != found && 0 < current.fileSize &&
+                     found->second.fileSize == current.fileSize && found->second.modTime == current.modTime )
+                {
+                    readyImages.push_back( filepath );
+                    m_reported.insert( filepath );
+                    m_candidates.erase( found );
+                }
+                else
+                {
+                    m_candidates[ filepath ] = current;
+                }
+            }
+        }
+    }
+    return retVal;
+}
+#endif
+
+} // namespace gc
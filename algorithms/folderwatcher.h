@@ -0,0 +1,127 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+   Copyright 2021 Kenneth W. Chapman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/** \file folderwatcher.h
+ * @brief A class to wait for new images to be written to a folder
+ *
+ * This file holds a watcher that reports images once they have been completely written to
+ * a folder, so a long running process can find the line in each new image of a station as
+ * it arrives. On Linux the folder is watched with inotify, elsewhere it is polled.
+ *
+ * \author Kenneth W. Chapman
+ * \copyright Copyright (C) 2010-2021, Kenneth W. Chapman <coffeesig@gmail.com>, all rights reserved.\n
+ * This project is released under the Apache License, Version 2.0.
+ * \bug No known bugs.
+ */
+
+#ifndef FOLDERWATCHER_H
+#define FOLDERWATCHER_H
+
+#include "gc_types.h"
+#include <ctime>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace gc
+{
+
+static const int FOLDER_WATCHER_WAIT_MSECS = 1000;          ///< Default time to wait for new images before returning
+
+/**
+ * @brief Reports the .png and .jpg images written to a folder (not its subfolders) after it is opened
+ *
+ * With inotify an image is ready when the program writing it closes it (IN_CLOSE_WRITE) or when it
+ * is moved into the folder (IN_MOVED_TO). When the folder is polled an image is ready when its size
+ * and modification time are the same on two polls in a row.
+ */
+class FolderWatcher
+{
+public:
+    /**
+     * @brief Constructor
+     */
+    FolderWatcher();
+
+    /**
+     * @brief Destructor, stops watching
+     */
+    ~FolderWatcher();
+
+    FolderWatcher( const FolderWatcher & ) = delete;
+    FolderWatcher &operator=( const FolderWatcher & ) = delete;
+
+    /**
+     * @brief Starts watching a folder, images already in it are not reported
+     * @param folder Folder to watch
+     * @return GC_OK=Success, GC_FAIL=Failure, GC_EXCEPT=Exception thrown
+     */
+    GC_STATUS Open( const std::string folder );
+
+    /**
+     * @brief Waits for images to be completely written to the folder
+     *
+     * Returns when images are ready, when the wait times out or when a signal interrupts the wait,
+     * so the caller can check a stop flag between calls.
+     *
+     * @param timeoutMsecs Longest time to wait in milliseconds
+     * @param readyImages Filepaths of the images that are ready, in filename order (empty on timeout)
+     * @return GC_OK=Success, GC_FAIL=Failure, GC_EXCEPT=Exception thrown
+     */
+    GC_STATUS Wait( const int timeoutMsecs, std::vector< std::string > &readyImages );
+
+    /**
+     * @brief Stops watching the folder
+     */
+    void Close();
+
+    /**
+     * @brief Get whether a folder is being watched
+     * @return true=Watching, false=Not watching
+     */
+    bool IsOpen() const { return !m_folder.empty(); }
+
+    /**
+     * @brief Get whether a filepath has an image extension the line find handles (.png or .jpg)
+     * @param filepath Filepath to check
+     * @return true=Image, false=Not an image
+     */
+    static bool IsImageFile( const std::string &filepath );
+
+private:
+    std::string m_folder;
+#ifdef __linux__
+    int m_inotifyFd;
+    std::vector< char > m_eventBuf;
+#else
+    class PollCandidate
+    {
+    public:
+        PollCandidate() : fileSize( 0 ), modTime( 0 ) {}
+        uintmax_t fileSize;
+        time_t modTime;
+    };
+    std::map< std::string, PollCandidate > m_candidates;
+    std::set< std::string > m_reported;
+
+    GC_STATUS Poll( std::vector< std::string > &readyImages );
+#endif
+};
+
+} // namespace gc
+
+#endif // FOLDERWATCHER_H
@@ -50,16 +50,31 @@ enum GC_TIMESTAMP_TYPE
     FROM_EXTERNAL       ///< Pass filename to algorithm using YYYY-MM-DDThh:mm::ss format (ISO)
 };
 
+/// enum for the engine used to calculate template match spaces
+enum GC_MATCH_ENGINE
+{
+    MATCH_ENGINE_SPATIAL = 0,   ///< cv::matchTemplate() on every call
+    MATCH_ENGINE_DFT            ///< DFT correlation with template spectra cached at the search image size
+};
+
 static const double DEFAULT_MIN_LINE_ANGLE = -10.0;                             ///< Default minimum line find angle
 static const double DEFAULT_MAX_LINE_ANGLE = 10.0;                              ///< Default maximum line find angle
 static const int FIT_LINE_RANSAC_TRIES_TOTAL = 100;                             ///< Fit line RANSAC total tries
 static const int FIT_LINE_RANSAC_TRIES_EARLY_OUT = 50;                          ///< Fit line RANSAC early out tries
 static const int FIT_LINE_RANSAC_POINT_COUNT = 5;                               ///< Fit line RANSAC early out tries
+static const unsigned int FIT_LINE_RANSAC_DEFAULT_SEED = 5489u;                 ///< Fit line RANSAC random engine seed
 static const int MIN_DEFAULT_INT = -std::numeric_limits< int >::max();          ///< Minimum value for an integer
 static const double MIN_DEFAULT_DBL = -std::numeric_limits< double >::max();    ///< Minimum value for a double
 static const int GC_BOWTIE_TEMPLATE_DIM = 56;                                   ///< Default bowtie template size
+static const double MIN_BOWTIE_FIND_SCORE = 0.55;                               ///< Minimum bowtie target match score of a calibration
 static const int GC_IMAGE_SIZE_WIDTH = 800;                                     ///< Default image width
 static const int GC_IMAGE_SIZE_HEIGHT = 600;                                    ///< Default image height
+static const size_t GC_SEARCH_SWATH_COUNT = 10;                                 ///< Number of swaths the search lines are split into
+static const int GC_FINDLINE_MORPH_KERN_HEIGHT = 9;                             ///< Height of the 1xn line find cleanup dilate/erode kernel
+static const int GC_FINDLINE_MORPH_ITERATIONS = 3;                              ///< Iterations of the line find cleanup dilate and erode
+static const std::string GC_UNSET_TIMESTAMP = "1955-09-24T12:05:00";            ///< Capture time of a FindLineResult whose timestamp was not found
+static const double GC_UNSET_LEVEL = -9999999.9;                                ///< Adjusted level of a FindLineResult whose level was not found
+static const double GC_UNSET_FILTERED_LEVEL = -9999999.9;                       ///< Filtered level of a FindLineResult that was not Kalman filtered
 
 /**
  * @brief Data class to define a line to search an image for a water edge
@@ -145,6 +160,73 @@ public:
     cv::Rect moveSearchRegionRgt;           ///< Right move search region (to search for top-right bowtie)
 };
 
+/**
+ * @brief Data class to hold a precomputed pixel sampling table for the search lines of a calibration
+ *
+ * The search lines are split into GC_SEARCH_SWATH_COUNT swaths. For every pixel the search lines of a
+ * swath pass over, the table holds (structure-of-arrays) the row-major offset of the pixel within the
+ * search region roi of an 8-bit single channel image of size imgSize and the row sum bin into which that
+ * pixel is accumulated. The roi is the bounding box of the search lines grown vertically by the reach of
+ * the line find cleanup morphology, so the cleanup gives the same result within the search lines whether
+ * it is run on the roi or on the whole image.
+ */
+class SearchSwathTable
+{
+public:
+    /**
+     * @brief Constructor sets the table to an empty (invalid) state
+     */
+    SearchSwathTable() :
+        imgSize( cv::Size( -1, -1 ) ),
+        roi( cv::Rect( -1, -1, -1, -1 ) )
+    {}
+
+    /**
+     * @brief Sets the table to an empty (invalid) state
+     */
+    void clear()
+    {
+        imgSize = cv::Size( -1, -1 );
+        roi = cv::Rect( -1, -1, -1, -1 );
+        lines.clear();
+        lineStart.clear();
+        lineEnd.clear();
+        rowCount.clear();
+        sampleStart.clear();
+        offsets.clear();
+        bins.clear();
+    }
+
+    /**
+     * @brief Returns whether the table can be used to sample the specified image along the specified search lines
+     * @param img Image to be sampled
+     * @param searchLines Search lines to be sampled
+     * @return true=Table matches the image geometry and search lines, false=Table is empty or does not match
+     */
+    bool IsValidFor( const cv::Mat &img, const std::vector< LineEnds > &searchLines ) const
+    {
+        if ( lineStart.empty() || searchLines.size() != lines.size() || CV_8UC1 != img.type() ||
+             img.cols != imgSize.width || img.rows != imgSize.height )
+            return false;
+        for ( size_t i = 0; i < lines.size(); ++i )
+        {
+            if ( searchLines[ i ].top != lines[ i ].top || searchLines[ i ].bot != lines[ i ].bot )
+                return false;
+        }
+        return true;
+    }
+
+    cv::Size imgSize;                       ///< Dimensions of the image for which the offsets were calculated
+    cv::Rect roi;                           ///< Search region of the image to which the offsets are relative
+    std::vector< LineEnds > lines;          ///< Search lines from which the table was calculated
+    std::vector< size_t > lineStart;        ///< Index of the first search line of each swath
+    std::vector< size_t > lineEnd;          ///< Index of the last search line of each swath (inclusive)
+    std::vector< size_t > rowCount;         ///< Number of row sum bins of each swath
+    std::vector< size_t > sampleStart;      ///< Index of the first sample of each swath (swath count + 1 entries)
+    std::vector< uint32_t > offsets;        ///< Row-major offset within the search region of every sample
+    std::vector< uint32_t > bins;           ///< Row sum bin of every sample
+};
+
 /**
  * @brief Data class to hold what is required to perform a water line search
  */
@@ -288,7 +370,8 @@ public:
     /**
      * @brief Constructor sets the object to an uninitialized state
      */
-    FindLineResult()
+    FindLineResult() :
+        waterLevelFiltered( GC_UNSET_FILTERED_LEVEL )
     {}
 
     /**
@@ -320,6 +403,7 @@ public:
         findSuccess( findOk ),
         timestamp( captureTime ),
         waterLevelAdjusted( adjustedWaterLevel ),
+        waterLevelFiltered( GC_UNSET_FILTERED_LEVEL ),
         calcLinePts( lineEndPoints ),
         refMovePts( moveRefPoints ),
         foundMovePts( moveFoundPoints ),
@@ -338,8 +422,9 @@ public:
     void clear()
     {
         findSuccess = false;
-        timestamp = std::string( "1955-09-24T12:05:00" );
-        waterLevelAdjusted = cv::Point2d( -9999999.9, -9999999.9 );
+        timestamp = GC_UNSET_TIMESTAMP;
+        waterLevelAdjusted = cv::Point2d( GC_UNSET_LEVEL, GC_UNSET_LEVEL );
+        waterLevelFiltered = GC_UNSET_FILTERED_LEVEL;
         calcLinePts.clear();
         refMovePts.clear();
         foundMovePts.clear();
@@ -351,9 +436,22 @@ public:
         msgs.clear();
     }
 
+    /**
+     * @brief Get whether the capture time of the image was found
+     * @return true=timestamp holds the capture time, false=timestamp is empty or was not found
+     */
+    bool hasTimestamp() const { return !timestamp.empty() && GC_UNSET_TIMESTAMP != timestamp; }
+
+    /**
+     * @brief Get whether the Kalman filter stage set a filtered level
+     * @return true=waterLevelFiltered holds the filtered level, false=the level was not filtered
+     */
+    bool hasFilteredLevel() const { return GC_UNSET_FILTERED_LEVEL < waterLevelFiltered; }
+
     bool findSuccess;                       ///< true=Successful find, false=Failed find
     std::string timestamp;                  ///< time of image capture
     cv::Point2d waterLevelAdjusted;         ///< World coordinate water level adjust for any detected motion of the calibration target
+    double waterLevelFiltered;              ///< Kalman filtered adjusted water level (GC_UNSET_FILTERED_LEVEL when not filtered)
     FindPointSet calcLinePts;               ///< Found water level line
     FindPointSet refMovePts;                ///< Line between the move targets at the time of calibration
     FindPointSet foundMovePts;              ///< Line between the move targets at the time of the current line find
@@ -0,0 +1,215 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+   Copyright 2021 Kenneth W. Chapman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include "log.h"
+#include "imageloader.h"
+#include <algorithm>
+#include <fstream>
+#include <opencv2/imgcodecs.hpp>
+
+using namespace cv;
+using namespace std;
+
+namespace gc
+{
+
+ImageLoader::ImageLoader() :
+    m_readMode( IMREAD_GRAYSCALE ),
+    m_nextToRead( 0 ),
+    m_nextToTake( 0 ),
+    m_released( 0 ),
+    m_stop( true )
+{
+}
+ImageLoader::~ImageLoader()
+{
+    Stop();
+}
+GC_STATUS ImageLoader::Start( const vector< string > &images, const int readMode, const size_t depth, const int threadCount )
+{
+    GC_STATUS retVal = GC_OK;
+    if ( 0 == depth || 1 > threadCount )
+    {
+        FILE_LOG( logERROR ) << "[ImageLoader::Start] Invalid depth=" << depth << " or thread count=" << threadCount;
+        retVal = GC_ERR;
+    }
+    else
+    {
+        Stop();
+        try
+        {
+            m_images = images;
+            m_readMode = readMode;
+            // buffers already in the ring are kept so a loader that is started again reuses them
+            m_slots.resize( depth );
+            for ( size_t i = 0; i < m_slots.size(); ++i )
+            {
+                m_slots[ i ].isReady = false;
+                m_slots[ i ].isValid = false;
+            }
+            m_nextToRead = 0;
+            m_nextToTake = 0;
+            m_released = 0;
+            m_stop = false;
+
+            size_t readerCount = std::min( static_cast< size_t >( threadCount ), std::max( static_cast< size_t >( 1 ), images.size() ) );
+            for ( size_t i = 0; i < readerCount; ++i )
+                m_readers.push_back( thread( &ImageLoader::ReadThreadFunc, this ) );
+        }
+        catch( std::exception &e )
+        {
+            FILE_LOG( logERROR ) << "[ImageLoader::Start] " << e.what();
+            Stop();
+            retVal = GC_EXCEPT;
+        }
+    }
+    return retVal;
+}
+GC_STATUS ImageLoader::Next( size_t &index, Mat &img )
+{
+    GC_STATUS retVal = GC_OK;
+    try
+    {
+        unique_lock< mutex > lock( m_mtx );
+
+        // the image handed out by the previous call is finished with, so its slot can be read into again
+        if ( m_released < m_nextToTake )
+        {
+            m_slots[ ( m_nextToTake - 1 ) % m_slots.size() ].isReady = false;
+            m_released = m_nextToTake;
+            m_cvRead.notify_all();
+        }
+
+        if ( m_stop || m_nextToTake >= m_images.size() )
+        {
+            img = Mat();
+            retVal = GC_WARN;
+        }
+        else
+        {
+            ImageSlot &slot = m_slots[ m_nextToTake % m_slots.size() ];
+            m_cvReady.wait( lock, [ & ]{ return m_stop || ( slot.isReady && m_nextToTake == slot.index ); } );
+            if ( m_stop )
+            {
+                img = Mat();
+                retVal = GC_WARN;
+            }
+            else
+            {
+                index = m_nextToTake++;
+                if ( slot.isValid )
+                {
+                    img = slot.img;
+                }
+                else
+                {
+                    img = Mat();
+                    retVal = GC_ERR;
+                }
+            }
+        }
+    }
+    catch( std::exception &e )
+    {
+        FILE_LOG( logERROR ) << "[ImageLoader::Next] " << e.what();
+        retVal = GC_EXCEPT;
+    }
+    return retVal;
+}
+void ImageLoader::Stop()
+{
+    {
+        lock_guard< mutex > lock( m_mtx );
+        m_stop = true;
+    }
+    m_cvRead.notify_all();
+    m_cvReady.notify_all();
+    for ( size_t i = 0; i < m_readers.size(); ++i )
+    {
+        if ( m_readers[ i ].joinable() )
+            m_readers[ i ].join();
+    }
+    m_readers.clear();
+}
+void ImageLoader::ReadThreadFunc()
+{
+    size_t index;
+    bool isValid;
+    for ( ;; )
+    {
+        {
+            // the ring slot of the next image is free once the caller has handed back the image depth before it
+            unique_lock< mutex > lock( m_mtx );
+            m_cvRead.wait( lock, [ & ]{ return m_stop || m_nextToRead >= m_images.size() ||
+                                               m_nextToRead < m_released + m_slots.size(); } );
+            if ( m_stop || m_nextToRead >= m_images.size() )
+                break;
+            index = m_nextToRead++;
+        }
+
+        // the slot belongs to this thread alone until it is marked ready
+        ImageSlot &slot = m_slots[ index % m_slots.size() ];
+        isValid = ReadImage( m_images[ index ], slot );
+
+        {
+            lock_guard< mutex > lock( m_mtx );
+            slot.index = index;
+            slot.isValid = isValid;
+            slot.isReady = true;
+        }
+        m_cvReady.notify_all();
+    }
+}
+bool ImageLoader::ReadImage( const string &filepath, ImageSlot &slot )
+{
+    bool isValid = false;
+    try
+    {
+        ifstream file( filepath, ios::in | ios::binary | ios::ate );
+        if ( !file.is_open() )
+        {
+            FILE_LOG( logERROR ) << "[ImageLoader::ReadImage] Could not open image=" << filepath;
+        }
+        else
+        {
+            streamoff fileSize = file.tellg();
+            file.seekg( 0, ios::beg );
+            slot.fileBuf.resize( static_cast< size_t >( std::max( static_cast< streamoff >( 0 ), fileSize ) ) );
+            if ( slot.fileBuf.empty() ||
+                 !file.read( reinterpret_cast< char * >( &slot.fileBuf[ 0 ] ), static_cast< streamsize >( slot.fileBuf.size() ) ) )
+            {
+                FILE_LOG( logERROR ) << "[ImageLoader::ReadImage] Could not read image=" << filepath;
+            }
+            else
+            {
+                // decoding into the slot image reuses its pixel buffer when the size and type match
+                imdecode( slot.fileBuf, m_readMode, &slot.img );
+                isValid = !slot.img.empty();
+                if ( !isValid )
+                {
+                    FILE_LOG( logERROR ) << "[ImageLoader::ReadImage] Could not decode image=" << filepath;
+                }
+            }
+        }
+    }
+    catch( std::exception &e )
+    {
+        FILE_LOG( logERROR ) << "[ImageLoader::ReadImage] " << filepath << ": " << e.what();
+    }
+    return isValid;
+}
+
+} // namespace gc
@@ -0,0 +1,134 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+   Copyright 2021 Kenneth W. Chapman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/** \file imageloader.h
+ * @brief A class to read the images of a folder run ahead of the images being processed
+ *
+ * This file holds a loader that reads and decodes the next few images of a list on
+ * background threads while the calling thread works on the current one, so disk reads
+ * and image decoding overlap the line find rather than alternating with it.
+ *
+ * \author Kenneth W. Chapman
+ * \copyright Copyright (C) 2010-2021, Kenneth W. Chapman <coffeesig@gmail.com>, all rights reserved.\n
+ * This project is released under the Apache License, Version 2.0.
+ * \bug No known bugs.
+ */
+
+#ifndef IMAGELOADER_H
+#define IMAGELOADER_H
+
+#include "gc_types.h"
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <opencv2/core.hpp>
+
+namespace gc
+{
+
+static const size_t IMAGE_LOADER_DEFAULT_DEPTH = 4;         ///< Default number of images read ahead of the one being processed
+static const int IMAGE_LOADER_DEFAULT_THREADS = 1;          ///< Default number of threads that read and decode images
+
+/**
+ * @brief Reads a list of images in order on background threads into a bounded ring of buffers
+ *
+ * The ring holds depth image buffers. The reader threads decode image i into buffer i % depth,
+ * so the file and pixel buffers are reused from image to image once the ring has filled. Readers
+ * stop when they are depth images ahead of the caller and go on as the caller takes images.
+ * Images are always handed to the caller in list order.
+ */
+class ImageLoader
+{
+public:
+    /**
+     * @brief Constructor
+     */
+    ImageLoader();
+
+    /**
+     * @brief Destructor, stops the reader threads
+     */
+    ~ImageLoader();
+
+    ImageLoader( const ImageLoader & ) = delete;
+    ImageLoader &operator=( const ImageLoader & ) = delete;
+
+    /**
+     * @brief Starts reading a list of images (stops a previous list first)
+     * @param images Filepaths of the images in the order they are to be processed
+     * @param readMode cv::imread() flags the images are decoded with, e.g. cv::IMREAD_GRAYSCALE
+     * @param depth Number of image buffers in the ring (images read ahead of the caller)
+     * @param threadCount Number of reader threads
+     * @return GC_OK=Success, GC_FAIL=Failure, GC_EXCEPT=Exception thrown
+     */
+    GC_STATUS Start( const std::vector< std::string > &images, const int readMode,
+                     const size_t depth = IMAGE_LOADER_DEFAULT_DEPTH, const int threadCount = IMAGE_LOADER_DEFAULT_THREADS );
+
+    /**
+     * @brief Gets the next image of the list, waiting for it to be read if it is not ready
+     *
+     * The image shares the buffer of its ring slot. It is valid until the next call to Next() or
+     * Stop(), clone it to keep it longer. The previous image is handed back to the readers by the call.
+     *
+     * @param index Index in the list of the image returned
+     * @param img The decoded image
+     * @return GC_OK=Success, GC_ERR=The image could not be read (index is still set),
+     *         GC_WARN=No more images or the loader was stopped, GC_EXCEPT=Exception thrown
+     */
+    GC_STATUS Next( size_t &index, cv::Mat &img );
+
+    /**
+     * @brief Stops the reader threads and drops the images not yet taken
+     *
+     * A folder run that is cancelled calls this when its stop flag is cleared. It is safe to call
+     * when the loader is not running.
+     */
+    void Stop();
+
+private:
+    class ImageSlot
+    {
+    public:
+        ImageSlot() : index( 0 ), isReady( false ), isValid( false ) {}
+
+        cv::Mat img;
+        std::vector< uchar > fileBuf;
+        size_t index;
+        bool isReady;
+        bool isValid;
+    };
+
+    std::vector< std::string > m_images;
+    std::vector< ImageSlot > m_slots;
+    std::vector< std::thread > m_readers;
+    int m_readMode;
+    size_t m_nextToRead;
+    size_t m_nextToTake;
+    size_t m_released;
+    bool m_stop;
+    std::mutex m_mtx;
+    std::condition_variable m_cvRead;
+    std::condition_variable m_cvReady;
+
+    void ReadThreadFunc();
+    bool ReadImage( const std::string &filepath, ImageSlot &slot );
+};
+
+} // namespace gc
+
+#endif // IMAGELOADER_H
@@ -19,20 +19,201 @@
 #include "csvreader.h"
 #include <vector>
 #include <fstream>
-#include <opencv2/video/tracking.hpp>
+#include <algorithm>
+#include <cstdio>
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/json_parser.hpp>
+#include <boost/filesystem.hpp>
 #include <boost/exception/exception.hpp>
 #include <boost/exception/diagnostic_information.hpp>
 #include "timestampconvert.h"
 
-using namespace cv;
 using namespace std;
 using namespace boost;
+namespace fs = boost::filesystem;
 
 namespace gc
 {
 
+static const size_t KALMAN_OUTPUT_BUFFER_SIZE = 1 << 16;
+static const int KALMAN_CHECKPOINT_VERSION = 1;
+
+KalmanStations::KalmanStations( const double processNoise, const double measurementNoise ) :
+    m_processNoise( processNoise ),
+    m_measurementNoise( measurementNoise )
+{
+}
+GC_STATUS KalmanStations::Update( const string &station, const long long secsSinceEpoch, const double level, double &filtered )
+{
+    GC_STATUS retVal = GC_OK;
+
+    lock_guard< mutex > lock( m_mutex );
+    map< string, KalmanStation >::iterator iter = m_stations.find( station );
+    if ( m_stations.end() == iter )
+    {
+        KalmanStation &state = m_stations[ station ];
+        state.filter = KalmanLevel( m_processNoise, m_measurementNoise );
+        state.filter.Init( level );
+        state.secsSinceEpoch = secsSinceEpoch;
+        state.count = 1;
+        filtered = level;
+    }
+    else if ( secsSinceEpoch <= iter->second.secsSinceEpoch )
+    {
+        FILE_LOG( logWARNING ) << "[KalmanStations::Update] Level of " << station << " is not newer than the last one filtered";
+        retVal = GC_WARN;
+    }
+    else
+    {
+        filtered = iter->second.filter.Update( level );
+        iter->second.secsSinceEpoch = secsSinceEpoch;
+        ++iter->second.count;
+    }
+    return retVal;
+}
+GC_STATUS KalmanStations::Update( const string &station, FindLineResult &result )
+{
+    GC_STATUS retVal = GC_OK;
+    if ( !result.findSuccess || GC_UNSET_LEVEL >= result.waterLevelAdjusted.y )
+    {
+        retVal = GC_WARN;
+    }
+    else
+    {
+        long long secsSinceEpoch;
+        retVal = GcTimestampConvert::ISOTimestampToSeconds( result.timestamp, secsSinceEpoch );
+        if ( GC_OK == retVal )
+        {
+            retVal = Update( station, secsSinceEpoch, result.waterLevelAdjusted.y, result.waterLevelFiltered );
+        }
+    }
+    return retVal;
+}
+GC_STATUS KalmanStations::Save( const string filepath )
+{
+    GC_STATUS retVal = GC_OK;
+    try
+    {
+        property_tree::ptree pt;
+        property_tree::ptree stations;
+        {
+            lock_guard< mutex > lock( m_mutex );
+            char buf[ 32 ];
+            for ( map< string, KalmanStation >::const_iterator iter = m_stations.begin(); iter != m_stations.end(); ++iter )
+            {
+                // doubles are written with enough digits to be read back exactly
+                KalmanLevelState state = iter->second.filter.State();
+                property_tree::ptree node;
+                node.put( "station", iter->first );
+                node.put( "secs_since_epoch", iter->second.secsSinceEpoch );
+                node.put( "count", iter->second.count );
+                snprintf( buf, sizeof( buf ), "%.17g", state.level );
+                node.put( "level", string( buf ) );
+                snprintf( buf, sizeof( buf ), "%.17g", state.velocity );
+                node.put( "velocity", string( buf ) );
+                snprintf( buf, sizeof( buf ), "%.17g", state.cov00 );
+                node.put( "cov00", string( buf ) );
+                snprintf( buf, sizeof( buf ), "%.17g", state.cov01 );
+                node.put( "cov01", string( buf ) );
+                snprintf( buf, sizeof( buf ), "%.17g", state.cov11 );
+                node.put( "cov11", string( buf ) );
+                stations.push_back( make_pair( "", node ) );
+            }
+        }
+        pt.put( "version", KALMAN_CHECKPOINT_VERSION );
+        pt.add_child( "stations", stations );
+
+        // written beside the checkpoint and renamed over it so a crash never leaves a partial file
+        string tempFilepath = filepath + ".tmp";
+        ofstream outFile( tempFilepath );
+        if ( !outFile.is_open() )
+        {
+            FILE_LOG( logERROR ) << "[KalmanStations::Save] Could not open checkpoint file for writing " << tempFilepath;
+            retVal = GC_ERR;
+        }
+        else
+        {
+            property_tree::write_json( outFile, pt );
+            outFile.close();
+            if ( outFile.fail() )
+            {
+                FILE_LOG( logERROR ) << "[KalmanStations::Save] Could not write checkpoint file " << tempFilepath;
+                fs::remove( tempFilepath );
+                retVal = GC_ERR;
+            }
+            else
+            {
+                fs::rename( tempFilepath, filepath );
+            }
+        }
+    }
+    catch( std::exception &e )
+    {
+        FILE_LOG( logERROR ) << "[KalmanStations::Save] " << e.what();
+        retVal = GC_EXCEPT;
+    }
+    return retVal;
+}
+GC_STATUS KalmanStations::Load( const string filepath )
+{
+    GC_STATUS retVal = GC_OK;
+    try
+    {
+        property_tree::ptree pt;
+        property_tree::read_json( filepath, pt );
+        if ( KALMAN_CHECKPOINT_VERSION != pt.get< int >( "version" ) )
+        {
+            FILE_LOG( logERROR ) << "[KalmanStations::Load] Unsupported checkpoint version in " << filepath;
+            retVal = GC_ERR;
+        }
+        else
+        {
+            map< string, KalmanStation > stations;
+            KalmanLevelState state;
+            for ( const property_tree::ptree::value_type &item : pt.get_child( "stations" ) )
+            {
+                KalmanStation &station = stations[ item.second.get< string >( "station" ) ];
+                station.secsSinceEpoch = item.second.get< long long >( "secs_since_epoch" );
+                station.count = item.second.get< size_t >( "count" );
+                state.level = item.second.get< double >( "level" );
+                state.velocity = item.second.get< double >( "velocity" );
+                state.cov00 = item.second.get< double >( "cov00" );
+                state.cov01 = item.second.get< double >( "cov01" );
+                state.cov11 = item.second.get< double >( "cov11" );
+                station.filter = KalmanLevel( m_processNoise, m_measurementNoise );
+                station.filter.SetState( state );
+            }
+
+            lock_guard< mutex > lock( m_mutex );
+            m_stations.swap( stations );
+        }
+    }
+    catch( std::exception &e )
+    {
+        FILE_LOG( logERROR ) << "[KalmanStations::Load] " << e.what();
+        retVal = GC_EXCEPT;
+    }
+    return retVal;
+}
+void KalmanStations::Clear()
+{
+    lock_guard< mutex > lock( m_mutex );
+    m_stations.clear();
+}
+size_t KalmanStations::StationCount()
+{
+    lock_guard< mutex > lock( m_mutex );
+    return m_stations.size();
+}
+bool KalmanStations::GetStation( const string &station, KalmanStation &state )
+{
+    lock_guard< mutex > lock( m_mutex );
+    map< string, KalmanStation >::const_iterator iter = m_stations.find( station );
+    if ( m_stations.end() == iter )
+        return false;
+    state = iter->second;
+    return true;
+}
 Kalman::Kalman()
 {
 
@@ -90,15 +271,23 @@ GC_STATUS Kalman::Apply( const KalmanParams params )
     try
     {
         CSVReader reader( params.inputCSVFilepath );
-        vector< vector< string > > data = reader.getData();
-        if ( data.empty() )
+        if ( 0 > params.datetimeColumn || 0 > params.measurementColumn )
+        {
+            FILE_LOG( logERROR ) << "[Kalman::Apply] Invalid datetime and/or measurement column";
+            retVal = GC_ERR;
+        }
+        else if ( GC_OK != reader.open() )
         {
-            FILE_LOG( logERROR ) << "[Kalman::Apply] No data in input file " << params.inputCSVFilepath;
+            FILE_LOG( logERROR ) << "[Kalman::Apply] Could not read input file " << params.inputCSVFilepath;
             retVal = GC_ERR;
         }
         else
         {
-            ofstream outFile( params.outputCSVFilepath );
+            // rows are written through a large stream buffer, not flushed one by one
+            vector< char > outBuffer( KALMAN_OUTPUT_BUFFER_SIZE );
+            ofstream outFile;
+            outFile.rdbuf()->pubsetbuf( &outBuffer[ 0 ], static_cast< streamsize >( outBuffer.size() ) );
+            outFile.open( params.outputCSVFilepath );
             if ( !outFile.is_open() )
             {
                 FILE_LOG( logERROR ) << "[ApplyKalmanFilterToCSV] Could not open output file for writing " << params.outputCSVFilepath ;
@@ -106,55 +295,61 @@ GC_STATUS Kalman::Apply( const KalmanParams params )
             }
             else
             {
-                outFile << "Timestamp, measured, estimated" << endl;
+                outFile << "Timestamp, measured, estimated\n";
+
+                // the rows are streamed from the mapped file, the first row sets the initial state
+                KalmanLevel filter;
                 KalmanItem item;
-                GC_STATUS retTimeGet = GcTimestampConvert::ConvertDateToSeconds( data[ 0 ][ params.datetimeColumn ],
-                        params.timeStringStartCol, params.timeStringLength, params.datetimeFormat, item.secsSinceEpoch );
-                if ( GC_OK == retTimeGet )
+                string timestamp;
+                GC_STATUS retTimeGet = GC_OK;
+                size_t rowCount = 0;
+                const size_t columnCount = static_cast< size_t >( std::max( params.datetimeColumn, params.measurementColumn ) ) + 1;
+                GC_STATUS retRead = reader.forEachRow( [ & ]( const size_t rowIndex, const CSVRow &row )
                 {
-                    item.measurement = stod( data[ 0 ][ params.measurementColumn ] );
-                    item.prediction = item.measurement;
-                    outFile << data[ 0 ][ params.datetimeColumn ] << "," << item.measurement << "," << item.prediction << endl;
-                }
-
-                KalmanFilter kf( 4, 2, 0 );
-                kf.transitionMatrix = ( Mat_< float >( 4, 4 ) << 1,0,1,0,  0,1,0,1,  0,0,1,0,  0,0,0,1 );
-                Mat_< float > measurement( 2, 1 ); measurement.setTo( Scalar( 0 ) );
-
-                kf.statePre.at< float >( 0 ) = static_cast< float >( item.secsSinceEpoch );
-                kf.statePre.at< float >( 1 ) = static_cast< float >( item.measurement );
-                kf.statePre.at< float >( 2 ) = 0.0f;
-                kf.statePre.at< float >( 3 ) = 0.0f;
-
-                kf.statePost = kf.statePre;
-
-                // setIdentity( kf.processNoiseCov, Scalar::all( 1e-4 ) );
-                // setIdentity( kf.measurementNoiseCov, Scalar::all( 10 ) );
-                // setIdentity( kf.errorCovPost, Scalar::all( 0.1 ) );
-
-                setIdentity( kf.measurementMatrix );
-                setIdentity( kf.processNoiseCov, Scalar::all( 1e-6 ) );
-                setIdentity( kf.measurementNoiseCov, Scalar::all( 20 ) );
-                setIdentity( kf.errorCovPost, Scalar::all( 1 ) );
+                    ++rowCount;
+                    if ( columnCount > row.size() )
+                    {
+                        FILE_LOG( logERROR ) << "[Kalman::Apply] Too few columns in row " << rowIndex;
+                        retVal = GC_ERR;
+                        return false;
+                    }
+                    timestamp = row[ params.datetimeColumn ].str();
+                    retTimeGet = GcTimestampConvert::ConvertDateToSeconds( timestamp, params.timeStringStartCol,
+                                                                           params.datetimeFormat, item.secsSinceEpoch );
+                    if ( 0 == rowIndex && GC_OK != retTimeGet )
+                        return false;
+                    if ( !row[ params.measurementColumn ].toDouble( item.measurement ) )
+                    {
+                        FILE_LOG( logERROR ) << "[Kalman::Apply] Invalid measurement in row " << rowIndex;
+                        retVal = GC_ERR;
+                        return false;
+                    }
 
-                for ( size_t i = 1; i < data.size(); ++i )
-                {
-                    if ( GC_OK == retTimeGet )
+                    if ( 0 == rowIndex )
                     {
-                        retTimeGet = GcTimestampConvert::ConvertDateToSeconds( data[ i ][ params.datetimeColumn ],
-                                params.timeStringStartCol, params.timeStringLength, params.datetimeFormat, item.secsSinceEpoch );
-                        item.measurement = stod( data[ i ][ params.measurementColumn ] );
-                        if ( -1.0 < item.measurement )
-                        {
-                            Mat prediction = kf.predict();
-                            measurement( 0 ) = static_cast< float >( item.secsSinceEpoch );
-                            measurement( 1 ) = static_cast< float >( item.measurement );
-
-                            Mat estimated = kf.correct( measurement );
-                            item.prediction = estimated.at< float >( 1 );
-                            outFile << data[ i ][ params.datetimeColumn ] << "," << item.measurement << "," << item.prediction << endl;
-                        }
+                        filter.Init( item.measurement );
+                        item.prediction = item.measurement;
+                        outFile << timestamp << "," << item.measurement << "," << item.prediction << '\n';
                     }
+                    else if ( -1.0 < item.measurement )
+                    {
+                        item.prediction = filter.Update( item.measurement );
+                        outFile << timestamp << "," << item.measurement << "," << item.prediction << '\n';
+                    }
+                    return GC_OK == retTimeGet;
+                } );
+                if ( GC_OK == retVal )
+                    retVal = retRead;
+                if ( GC_OK == retVal && 0 == rowCount )
+                {
+                    FILE_LOG( logERROR ) << "[Kalman::Apply] No data in input file " << params.inputCSVFilepath;
+                    retVal = GC_ERR;
+                }
+                outFile.close();
+                if ( outFile.fail() && GC_OK == retVal )
+                {
+                    FILE_LOG( logERROR ) << "[Kalman::Apply] Could not write output file " << params.outputCSVFilepath;
+                    retVal = GC_ERR;
                 }
             }
         }
@@ -14,10 +14,13 @@
    limitations under the License.
 ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
-#ifndef KALMANFILTER_H
-#define KALMANFILTER_H
+#ifndef KALMAN_H
+#define KALMAN_H
 
 #include "gc_types.h"
+#include <map>
+#include <mutex>
+#include <string>
 
 namespace gc
 {
@@ -55,6 +58,166 @@ public:
     double prediction;
 };
 
+// noise of the level filter used by Kalman::Apply()
+static const double KALMAN_PROCESS_NOISE = 1e-6;
+static const double KALMAN_MEASUREMENT_NOISE = 20.0;
+
+// state of a KalmanLevel filter, the covariance is symmetric so only three terms are kept
+class KalmanLevelState
+{
+public:
+    KalmanLevelState() :
+        level( 0.0 ),
+        velocity( 0.0 ),
+        cov00( 1.0 ),
+        cov01( 0.0 ),
+        cov11( 1.0 )
+    {}
+
+    double level;
+    double velocity;
+    double cov00;
+    double cov01;
+    double cov11;
+};
+
+/*
+ * Closed form Kalman filter of a level with a constant velocity model
+ *
+ * The state is the level and its velocity per measurement. The filter gives the level
+ * estimates of cv::KalmanFilter( 4, 2, 0 ) set up with a constant velocity model for
+ * time and level, an identity measurement matrix and diagonal noise. With those matrices
+ * the time and level halves of the state never mix, so only the level half is kept and
+ * an update is a few scalar operations with no allocation.
+ */
+class KalmanLevel
+{
+public:
+    KalmanLevel( const double processNoise = KALMAN_PROCESS_NOISE,
+                 const double measurementNoise = KALMAN_MEASUREMENT_NOISE ) :
+        m_processNoise( processNoise ),
+        m_measurementNoise( measurementNoise ),
+        m_level( 0.0 ),
+        m_velocity( 0.0 ),
+        m_cov00( 1.0 ),
+        m_cov01( 0.0 ),
+        m_cov11( 1.0 )
+    {}
+
+    // Starts the filter at a measured level with no velocity and unit error covariance
+    void Init( const double level )
+    {
+        m_level = level;
+        m_velocity = 0.0;
+        m_cov00 = 1.0;
+        m_cov01 = 0.0;
+        m_cov11 = 1.0;
+    }
+
+    // Predicts the next level and corrects it with a measured level, returns the estimated level
+    double Update( const double level )
+    {
+        m_level += m_velocity;
+        m_cov00 += 2.0 * m_cov01 + m_cov11 + m_processNoise;
+        m_cov01 += m_cov11;
+        m_cov11 += m_processNoise;
+
+        double innovCov = m_cov00 + m_measurementNoise;
+        double gain0 = m_cov00 / innovCov;
+        double gain1 = m_cov01 / innovCov;
+        double innov = level - m_level;
+        m_level += gain0 * innov;
+        m_velocity += gain1 * innov;
+        m_cov11 -= gain1 * m_cov01;
+        m_cov00 *= 1.0 - gain0;
+        m_cov01 *= 1.0 - gain0;
+        return m_level;
+    }
+
+    double Level() const { return m_level; }
+    double Velocity() const { return m_velocity; }
+
+    KalmanLevelState State() const
+    {
+        KalmanLevelState state;
+        state.level = m_level;
+        state.velocity = m_velocity;
+        state.cov00 = m_cov00;
+        state.cov01 = m_cov01;
+        state.cov11 = m_cov11;
+        return state;
+    }
+    void SetState( const KalmanLevelState &state )
+    {
+        m_level = state.level;
+        m_velocity = state.velocity;
+        m_cov00 = state.cov00;
+        m_cov01 = state.cov01;
+        m_cov11 = state.cov11;
+    }
+
+private:
+    double m_processNoise;
+    double m_measurementNoise;
+    double m_level;
+    double m_velocity;
+    double m_cov00;
+    double m_cov01;
+    double m_cov11;
+};
+
+// filter state of one station
+class KalmanStation
+{
+public:
+    KalmanStation() :
+        secsSinceEpoch( -1 ),
+        count( 0 )
+    {}
+
+    KalmanLevel filter;
+    long long secsSinceEpoch;   // time of the last level filtered
+    size_t count;               // number of levels filtered
+};
+
+/*
+ * Online Kalman filtering of the water levels of any number of stations
+ *
+ * Each station (keyed by name, VisApp uses the calibration filepath) keeps a KalmanLevel
+ * filter in memory. Levels are filtered one at a time as they are found, so a live station
+ * gets its smoothed level without a second pass over its history. A level that is not newer
+ * than the last one of its station is not filtered. The states can be saved to and loaded
+ * from a checkpoint file so filtering carries on across runs. The methods are thread safe.
+ */
+class KalmanStations
+{
+public:
+    KalmanStations( const double processNoise = KALMAN_PROCESS_NOISE,
+                    const double measurementNoise = KALMAN_MEASUREMENT_NOISE );
+
+    // Filters a level of a station, the first level of a station starts its filter
+    GC_STATUS Update( const std::string &station, const long long secsSinceEpoch, const double level, double &filtered );
+
+    // Filters the adjusted level of a successful line find into result.waterLevelFiltered
+    GC_STATUS Update( const std::string &station, FindLineResult &result );
+
+    // Writes the station states to a json checkpoint file (written to a temporary file then renamed)
+    GC_STATUS Save( const std::string filepath );
+
+    // Replaces the station states with those of a json checkpoint file
+    GC_STATUS Load( const std::string filepath );
+
+    void Clear();
+    size_t StationCount();
+    bool GetStation( const std::string &station, KalmanStation &state );
+
+private:
+    double m_processNoise;
+    double m_measurementNoise;
+    std::mutex m_mutex;
+    std::map< std::string, KalmanStation > m_stations;
+};
+
 class Kalman
 {
 public:
@@ -72,4 +235,4 @@ private:
 
 } // namespace gc
 
-#endif // KALMANFILTER_H
+#endif // KALMAN_H
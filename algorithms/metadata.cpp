@@ -19,7 +19,11 @@
 #include <stdio.h>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cmath>
 #include <boost/bind/bind.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/property_tree/json_parser.hpp>
@@ -42,13 +46,257 @@ string trim_copy( string const &str );
 
 namespace gc
 {
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// internal exif header parsing
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+static const std::vector< std::string > NATIVE_EXIF_TAGS = { "ImageWidth", "ImageHeight", "DateTimeOriginal", "CreateDate",
+                                                             "ModifyDate", "FNumber", "ExposureTime", "ShutterSpeed", "ISO" };
+
+static uint32_t TiffGet( const vector< unsigned char > &buf, const size_t pos, const size_t bytes, const bool isMotorola )
+{
+    uint32_t val = 0;
+    for ( size_t i = 0; i < bytes; ++i )
+    {
+        if ( isMotorola )
+            val = ( val << 8 ) | buf[ pos + i ];
+        else
+            val |= static_cast< uint32_t >( buf[ pos + i ] ) << ( 8 * i );
+    }
+    return val;
+}
+static string FormatExifNumber( const double val )
+{
+    stringstream ss;
+    ss << val;
+    return ss.str();
+}
+// Reads the entries of one image file directory of a tiff structure (the body of a jpeg APP1 Exif
+// segment, a png eXIf chunk, or a tiff file) and adds the tags GaugeCam uses to the tag map
+static void ParseTiffIFD( const vector< unsigned char > &buf, const size_t ifdPos, const bool isMotorola,
+                          const bool isExifIFD, map< string, string > &tags, size_t &exifIFDPos )
+{
+    static const size_t TYPE_SIZE[ 13 ] = { 0, 1, 1, 2, 4, 8, 1, 1, 2, 4, 8, 4, 8 };
+
+    if ( ifdPos + 2 > buf.size() )
+        return;
+
+    size_t entryCount = TiffGet( buf, ifdPos, 2, isMotorola );
+    for ( size_t i = 0; i < entryCount; ++i )
+    {
+        size_t entry = ifdPos + 2 + i * 12;
+        if ( entry + 12 > buf.size() )
+            break;
+
+        uint32_t tag = TiffGet( buf, entry, 2, isMotorola );
+        uint32_t type = TiffGet( buf, entry + 2, 2, isMotorola );
+        uint32_t count = TiffGet( buf, entry + 4, 4, isMotorola );
+        if ( 1 > type || 12 < type || 0 == count )
+            continue;
+
+        size_t valueSize = TYPE_SIZE[ type ] * static_cast< size_t >( count );
+        size_t valuePos = 4 >= valueSize ? entry + 8 : TiffGet( buf, entry + 8, 4, isMotorola );
+        if ( valuePos + valueSize > buf.size() || valuePos + valueSize < valuePos )
+            continue;
+
+        string name;
+        string value;
+        if ( 2 == type )
+        {
+            value = string( reinterpret_cast< const char * >( &buf[ valuePos ] ), count );
+            value = value.substr( 0, value.find( '\0' ) );
+        }
+        else if ( 3 == type || 4 == type )
+        {
+            value = to_string( TiffGet( buf, valuePos, TYPE_SIZE[ type ], isMotorola ) );
+        }
+        else if ( 5 == type || 10 == type )
+        {
+            uint32_t numer = TiffGet( buf, valuePos, 4, isMotorola );
+            uint32_t denom = TiffGet( buf, valuePos + 4, 4, isMotorola );
+            if ( 0 == denom )
+                continue;
+            if ( 10 == type )
+                value = FormatExifNumber( static_cast< double >( static_cast< int32_t >( numer ) ) /
+                                          static_cast< double >( static_cast< int32_t >( denom ) ) );
+            else
+                value = FormatExifNumber( static_cast< double >( numer ) / static_cast< double >( denom ) );
+        }
+
+        if ( isExifIFD )
+        {
+            switch( tag )
+            {
+                case 0x829A: name = "ExposureTime"; break;
+                case 0x829D: name = "FNumber"; break;
+                case 0x8827: name = "ISO"; break;
+                case 0x9003: name = "DateTimeOriginal"; break;
+                case 0x9004: name = "CreateDate"; break;
+                case 0x9201: name = "ShutterSpeedValue"; break;
+                default: break;
+            }
+        }
+        else
+        {
+            switch( tag )
+            {
+                case 0x0100: name = "ImageWidth"; break;
+                case 0x0101: name = "ImageHeight"; break;
+                case 0x0132: name = "ModifyDate"; break;
+                case 0x8769: exifIFDPos = TiffGet( buf, valuePos, 4, isMotorola ); break;
+                default: break;
+            }
+        }
+        if ( !name.empty() && !value.empty() )
+            tags[ name ] = value;
+    }
+}
+static GC_STATUS ParseTiffExif( const vector< unsigned char > &buf, map< string, string > &tags )
+{
+    GC_STATUS retVal = GC_OK;
+    if ( 8 > buf.size() || buf[ 0 ] != buf[ 1 ] || ( 'I' != buf[ 0 ] && 'M' != buf[ 0 ] ) )
+    {
+        retVal = GC_ERR;
+    }
+    else
+    {
+        bool isMotorola = 'M' == buf[ 0 ];
+        if ( 42 != TiffGet( buf, 2, 2, isMotorola ) )
+        {
+            retVal = GC_ERR;
+        }
+        else
+        {
+            size_t exifIFDPos = 0;
+            ParseTiffIFD( buf, TiffGet( buf, 4, 4, isMotorola ), isMotorola, false, tags, exifIFDPos );
+            if ( 0 < exifIFDPos )
+                ParseTiffIFD( buf, exifIFDPos, isMotorola, true, tags, exifIFDPos );
+        }
+    }
+    return retVal;
+}
+static GC_STATUS ReadJpegHeader( ifstream &file, map< string, string > &tags )
+{
+    GC_STATUS retVal = GC_OK;
+    unsigned char hdr[ 4 ];
+    vector< unsigned char > segment;
+    bool foundFrame = false;
+    while ( file.read( reinterpret_cast< char * >( hdr ), 2 ) )
+    {
+        if ( 0xFF != hdr[ 0 ] )
+        {
+            retVal = GC_ERR;
+            break;
+        }
+        while ( 0xFF == hdr[ 1 ] )
+        {
+            if ( !file.read( reinterpret_cast< char * >( &hdr[ 1 ] ), 1 ) )
+                break;
+        }
+        unsigned char marker = hdr[ 1 ];
+        if ( 0x01 == marker || ( 0xD0 <= marker && 0xD7 >= marker ) )
+            continue;
+        if ( 0xD9 == marker || 0xDA == marker )     // end of image or start of scan: no more header segments
+            break;
+        if ( !file.read( reinterpret_cast< char * >( &hdr[ 2 ] ), 2 ) )
+            break;
+
+        size_t segLen = ( static_cast< size_t >( hdr[ 2 ] ) << 8 ) | hdr[ 3 ];
+        if ( 2 > segLen )
+        {
+            retVal = GC_ERR;
+            break;
+        }
+        segLen -= 2;
+
+        bool isFrame = 0xC0 <= marker && 0xCF >= marker && 0xC4 != marker && 0xC8 != marker && 0xCC != marker;
+        if ( 0xE1 == marker || ( isFrame && !foundFrame ) )
+        {
+            segment.resize( segLen );
+            if ( !file.read( reinterpret_cast< char * >( segment.data() ), static_cast< streamsize >( segLen ) ) )
+                break;
+            if ( isFrame )
+            {
+                if ( 5 <= segLen )
+                {
+                    tags[ "ImageHeight" ] = to_string( ( segment[ 1 ] << 8 ) | segment[ 2 ] );
+                    tags[ "ImageWidth" ] = to_string( ( segment[ 3 ] << 8 ) | segment[ 4 ] );
+                    foundFrame = true;
+                }
+            }
+            else if ( 6 < segLen && 0 == memcmp( segment.data(), "Exif\0\0", 6 ) )
+            {
+                map< string, string > exifTags;
+                vector< unsigned char > tiff( segment.begin() + 6, segment.end() );
+                if ( GC_OK == ParseTiffExif( tiff, exifTags ) )
+                {
+                    // image dimensions come from the frame header, not from the exif copy of them
+                    exifTags.erase( "ImageWidth" );
+                    exifTags.erase( "ImageHeight" );
+                    for ( auto &item : exifTags )
+                        tags.insert( item );
+                }
+            }
+        }
+        else
+        {
+            file.seekg( static_cast< streamoff >( segLen ), ios::cur );
+        }
+    }
+    return retVal;
+}
+static GC_STATUS ReadPngHeader( ifstream &file, map< string, string > &tags )
+{
+    GC_STATUS retVal = GC_OK;
+    unsigned char hdr[ 8 ];
+    vector< unsigned char > chunk;
+    while ( file.read( reinterpret_cast< char * >( hdr ), 8 ) )
+    {
+        size_t chunkLen = ( static_cast< size_t >( hdr[ 0 ] ) << 24 ) | ( static_cast< size_t >( hdr[ 1 ] ) << 16 ) |
+                          ( static_cast< size_t >( hdr[ 2 ] ) << 8 ) | hdr[ 3 ];
+        string chunkType( reinterpret_cast< const char * >( &hdr[ 4 ] ), 4 );
+        if ( "IEND" == chunkType )
+            break;
+
+        if ( "IHDR" == chunkType || "eXIf" == chunkType )
+        {
+            chunk.resize( chunkLen );
+            if ( !file.read( reinterpret_cast< char * >( chunk.data() ), static_cast< streamsize >( chunkLen ) ) )
+            {
+                retVal = GC_ERR;
+                break;
+            }
+            if ( "IHDR" == chunkType && 8 <= chunkLen )
+            {
+                tags[ "ImageWidth" ] = to_string( ( static_cast< uint32_t >( chunk[ 0 ] ) << 24 ) | ( chunk[ 1 ] << 16 ) | ( chunk[ 2 ] << 8 ) | chunk[ 3 ] );
+                tags[ "ImageHeight" ] = to_string( ( static_cast< uint32_t >( chunk[ 4 ] ) << 24 ) | ( chunk[ 5 ] << 16 ) | ( chunk[ 6 ] << 8 ) | chunk[ 7 ] );
+            }
+            else if ( "eXIf" == chunkType )
+            {
+                map< string, string > exifTags;
+                if ( GC_OK == ParseTiffExif( chunk, exifTags ) )
+                {
+                    exifTags.erase( "ImageWidth" );
+                    exifTags.erase( "ImageHeight" );
+                    for ( auto &item : exifTags )
+                        tags.insert( item );
+                }
+            }
+            file.seekg( 4, ios::cur );      // crc
+        }
+        else
+        {
+            file.seekg( static_cast< streamoff >( chunkLen ) + 4, ios::cur );
+        }
+    }
+    return retVal;
+}
 void MetaData::GetExifToolVersion()
 {
     string cmdStr = "exiftool -ver";
     std::system( cmdStr.c_str() );
 }
 #ifdef WIN32
-GC_STATUS MetaData::GetExifData( const string filepath, const string tag, string &data )
+GC_STATUS MetaData::GetExifDataExifTool( const string filepath, const string tag, string &data )
 {
     GC_STATUS retVal = GC_OK;
 
@@ -59,7 +307,7 @@ GC_STATUS MetaData::GetExifData( const string filepath, const string tag, string
         int ret = WinRunCmd::runCmd( cmdStr.c_str(), strBuf );
         if ( 0 != ret )
         {
-            FILE_LOG( logERROR ) << "[MetaData::GetExifData] Could not run exiftool command: " << cmdStr;
+            FILE_LOG( logERROR ) << "[MetaData::GetExifDataExifTool] Could not run exiftool command: " << cmdStr;
             retVal = GC_ERR;
         }
         else
@@ -67,7 +315,7 @@ GC_STATUS MetaData::GetExifData( const string filepath, const string tag, string
             size_t pos = strBuf.find( ":" );
             if ( string::npos == pos )
             {
-                FILE_LOG( logERROR ) << "[MetaData::GetExifData] Invalid exif data (no \":\" found: " << strBuf;
+                FILE_LOG( logERROR ) << "[MetaData::GetExifDataExifTool] Invalid exif data (no \":\" found: " << strBuf;
                 retVal = GC_ERR;
             }
             else
@@ -85,14 +333,14 @@ GC_STATUS MetaData::GetExifData( const string filepath, const string tag, string
     }
     catch( std::exception &e )
     {
-        FILE_LOG( logERROR ) << "[MetaData::GetExifData] " << e.what();
+        FILE_LOG( logERROR ) << "[MetaData::GetExifDataExifTool] " << e.what();
         retVal = GC_EXCEPT;
     }
 
     return retVal;
 }
 #else
-GC_STATUS MetaData::GetExifData( const string filepath, const string tag, string &data )
+GC_STATUS MetaData::GetExifDataExifTool( const string filepath, const string tag, string &data )
 {
     GC_STATUS retVal = GC_OK;
 
@@ -106,7 +354,7 @@ GC_STATUS MetaData::GetExifData( const string filepath, const string tag, string
 #endif
         if ( nullptr == cmd )
         {
-            FILE_LOG( logERROR ) << "[MetaData::GetExifData] Could not open file to retrieve metadata: " << filepath;
+            FILE_LOG( logERROR ) << "[MetaData::GetExifDataExifTool] Could not open file to retrieve metadata: " << filepath;
             retVal = GC_ERR;
         }
         else
@@ -125,7 +373,7 @@ GC_STATUS MetaData::GetExifData( const string filepath, const string tag, string
             size_t pos = strBuf.find( ":" );
             if ( string::npos == pos )
             {
-                FILE_LOG( logERROR ) << "[MetaData::GetExifData] Invalid exif data (no \":\" found: " << strBuf;
+                FILE_LOG( logERROR ) << "[MetaData::GetExifDataExifTool] Invalid exif data (no \":\" found: " << strBuf;
                 retVal = GC_ERR;
             }
             else
@@ -143,13 +391,99 @@ GC_STATUS MetaData::GetExifData( const string filepath, const string tag, string
     }
     catch( std::exception &e )
     {
-        FILE_LOG( logERROR ) << "[MetaData::GetExifData] " << e.what();
+        FILE_LOG( logERROR ) << "[MetaData::GetExifDataExifTool] " << e.what();
         retVal = GC_EXCEPT;
     }
 
     return retVal;
 }
 #endif
+GC_STATUS MetaData::ReadExifTags( const string filepath, map< string, string > &tags )
+{
+    GC_STATUS retVal = GC_OK;
+    try
+    {
+        tags.clear();
+        ifstream file( filepath, ios::binary );
+        if ( !file.is_open() )
+        {
+            retVal = GC_ERR;
+        }
+        else
+        {
+            unsigned char magic[ 8 ] = { 0 };
+            file.read( reinterpret_cast< char * >( magic ), 8 );
+            if ( 0xFF == magic[ 0 ] && 0xD8 == magic[ 1 ] )
+            {
+                file.seekg( 2, ios::beg );
+                retVal = ReadJpegHeader( file, tags );
+            }
+            else if ( 0 == memcmp( magic, "\x89PNG\r\n\x1a\n", 8 ) )
+            {
+                retVal = ReadPngHeader( file, tags );
+            }
+            else if ( ( 'I' == magic[ 0 ] && 'I' == magic[ 1 ] ) || ( 'M' == magic[ 0 ] && 'M' == magic[ 1 ] ) )
+            {
+                file.seekg( 0, ios::beg );
+                vector< unsigned char > buf( ( istreambuf_iterator< char >( file ) ), istreambuf_iterator< char >() );
+                retVal = ParseTiffExif( buf, tags );
+            }
+            else
+            {
+                retVal = GC_ERR;
+            }
+
+            if ( GC_OK == retVal )
+            {
+                // exiftool ShutterSpeed composite: ExposureTime if it exists, otherwise from the APEX ShutterSpeedValue
+                if ( tags.end() != tags.find( "ExposureTime" ) )
+                    tags[ "ShutterSpeed" ] = tags[ "ExposureTime" ];
+                else if ( tags.end() != tags.find( "ShutterSpeedValue" ) )
+                    tags[ "ShutterSpeed" ] = FormatExifNumber( pow( 2.0, -stod( tags[ "ShutterSpeedValue" ] ) ) );
+            }
+        }
+    }
+    catch( std::exception &e )
+    {
+        FILE_LOG( logERROR ) << "[MetaData::ReadExifTags] " << e.what();
+        retVal = GC_EXCEPT;
+    }
+
+    return retVal;
+}
+GC_STATUS MetaData::GetTagValue( const string filepath, const bool isNativeRead, const map< string, string > &tags,
+                                 const string tag, string &data )
+{
+    GC_STATUS retVal = GC_OK;
+    auto it = tags.end();
+    if ( isNativeRead && NATIVE_EXIF_TAGS.end() != find( NATIVE_EXIF_TAGS.begin(), NATIVE_EXIF_TAGS.end(), tag ) )
+    {
+        it = tags.find( tag );
+    }
+
+    // exiftool also reads tags from makernotes, XMP and other places the native reader does not
+    // look, so a tag the native read did not find is asked of exiftool as well
+    if ( tags.end() == it )
+    {
+        retVal = GetExifDataExifTool( filepath, tag, data );
+    }
+    else
+    {
+        data = it->second;
+    }
+    return retVal;
+}
+GC_STATUS MetaData::GetExifData( const string filepath, const string tag, string &data )
+{
+    map< string, string > tags;
+    bool isNativeRead = false;
+    if ( NATIVE_EXIF_TAGS.end() != find( NATIVE_EXIF_TAGS.begin(), NATIVE_EXIF_TAGS.end(), tag ) )
+    {
+        isNativeRead = GC_OK == ReadExifTags( filepath, tags );
+    }
+    GC_STATUS retVal = GetTagValue( filepath, isNativeRead, tags, tag, data );
+    return retVal;
+}
 // exifTimestamp example: 2012:09:30 15:38:49
 // isoTimeStamp example:  2019-09-15T20:08:12
 string MetaData::ConvertToLocalTimestamp( const string exifTimestamp )
@@ -220,36 +554,39 @@ GC_STATUS MetaData::GetImageData( const string filepath, ExifFeatures &exifFeat
         {
             string data;
             exifFeat.clear();
-            retVal = GetExifData( filepath, "ImageWidth", data );
+
+            map< string, string > tags;
+            bool isNativeRead = GC_OK == ReadExifTags( filepath, tags );
+            retVal = GetTagValue( filepath, isNativeRead, tags, "ImageWidth", data );
             if ( GC_OK == retVal )
             {
                 exifFeat.imageDims.width = stoi( data );
-                retVal = GetExifData( filepath, "ImageHeight", data );
+                retVal = GetTagValue( filepath, isNativeRead, tags, "ImageHeight", data );
                 if ( GC_OK == retVal )
                 {
                     exifFeat.imageDims.height = stoi( data );
                 }
-                retVal = GetExifData( filepath, "DateTimeOriginal", data );
+                retVal = GetTagValue( filepath, isNativeRead, tags, "DateTimeOriginal", data );
                 if ( GC_OK == retVal )
                 {
                     exifFeat.captureTime = ConvertToLocalTimestamp( data );
                 }
-                retVal = GetExifData( filepath, "FNumber", data );
+                retVal = GetTagValue( filepath, isNativeRead, tags, "FNumber", data );
                 if ( GC_OK == retVal )
                 {
                     exifFeat.fNumber = stod( data );
                 }
-                retVal = GetExifData( filepath, "ExposureTime", data );
+                retVal = GetTagValue( filepath, isNativeRead, tags, "ExposureTime", data );
                 if ( GC_OK == retVal )
                 {
                     exifFeat.exposureTime = stod( data );
                 }
-                retVal = GetExifData( filepath, "ShutterSpeed", data );
+                retVal = GetTagValue( filepath, isNativeRead, tags, "ShutterSpeed", data );
                 if ( GC_OK == retVal )
                 {
                     exifFeat.shutterSpeed = stod( data );
                 }
-                retVal = GetExifData( filepath, "ISO", data );
+                retVal = GetTagValue( filepath, isNativeRead, tags, "ISO", data );
                 if ( GC_OK == retVal )
                 {
                     exifFeat.isoSpeedRating = stoi( data );
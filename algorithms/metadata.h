@@ -27,6 +27,7 @@
 #define METADATA_H
 
 #include "gc_types.h"
+#include <map>
 #include <boost/property_tree/ptree.hpp>
 #include "featuredata.h"
 
@@ -79,6 +80,12 @@ public:
 
     /**
      * @brief Retrieve the metadata for a specific tag from an image file
+     *
+     * The tags used by GaugeCam (ImageWidth, ImageHeight, DateTimeOriginal, CreateDate, ModifyDate,
+     * FNumber, ExposureTime, ShutterSpeed, ISO) are read directly from the jpeg, png, or tiff file
+     * header. Any other tag, a tag the header does not hold, or a file whose header cannot be parsed,
+     * is retrieved with exiftool.
+     *
      * @param filepath The filepath of the image file from which to retrieve the metadata
      * @param tag Name of tag to be retrieved
      * @param data String to hold the retrieved metadata
@@ -86,8 +93,19 @@ public:
      */
     GC_STATUS GetExifData( const std::string filepath, const std::string tag, std::string &data );
 
+    /**
+     * @brief Read all the natively supported exif tags from an image file in one pass over its header
+     * @param filepath The filepath of the jpeg, png, or tiff image file from which to retrieve the metadata
+     * @param tags Map of exiftool tag name to value (formatted as exiftool -n would format it)
+     * @return GC_OK=Success, GC_FAIL=Failure, GC_EXCEPT=Exception thrown
+     */
+    static GC_STATUS ReadExifTags( const std::string filepath, std::map< std::string, std::string > &tags );
+
 private:
     std::string ConvertToLocalTimestamp( const std::string exifTimestamp );
+    GC_STATUS GetExifDataExifTool( const std::string filepath, const std::string tag, std::string &data );
+    GC_STATUS GetTagValue( const std::string filepath, const bool isNativeRead, const std::map< std::string, std::string > &tags,
+                           const std::string tag, std::string &data );
 };
 
 } // namespace gc
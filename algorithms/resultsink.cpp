@@ -0,0 +1,411 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+   Copyright 2021 Kenneth W. Chapman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include "log.h"
+#include "resultsink.h"
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace cv;
+using namespace std;
+
+// Appends a value formatted as printf( "%.3f" ) (and std::fixed, std::setprecision( 3 )) does.
+// The value times 1000 is rounded to the nearest integer (ties to even) using fma() to decide on
+// which side of each rounding boundary the exact value lies. Values too large to scale exactly,
+// infinities, and nans are passed to snprintf().
+static void AppendFixed3( string &buf, const double value )
+{
+    double mag = fabs( value );
+    if ( !( mag < 1.0e12 ) )
+    {
+        char text[ 512 ];
+        int len = snprintf( text, sizeof( text ), "%.3f", value );
+        buf.append( text, static_cast< size_t >( len ) );
+        return;
+    }
+
+    double whole = floor( mag * 1000.0 );
+    if ( 0.0 > fma( mag, 1000.0, -whole ) )
+        whole -= 1.0;
+    else if ( 0.0 <= fma( mag, 1000.0, -( whole + 1.0 ) ) )
+        whole += 1.0;
+    double rem = fma( mag, 1000.0, -( whole + 0.5 ) );
+    unsigned long long scaled = static_cast< unsigned long long >( whole );
+    if ( 0.0 < rem || ( 0.0 == rem && ( scaled & 1 ) ) )
+        ++scaled;
+
+    char text[ 32 ];
+    char *pos = text + sizeof( text );
+    for ( int i = 0; i < 3; ++i )
+    {
+        *--pos = static_cast< char >( '0' + scaled % 10 );
+        scaled /= 10;
+    }
+    *--pos = '.';
+    do
+    {
+        *--pos = static_cast< char >( '0' + scaled % 10 );
+        scaled /= 10;
+    } while ( 0 < scaled );
+    if ( signbit( value ) )
+        *--pos = '-';
+    buf.append( pos, static_cast< size_t >( text + sizeof( text ) - pos ) );
+}
+static void AppendPointSet( string &buf, const gc::FindPointSet &ptSet )
+{
+    const Point2d *pts[ 6 ] = { &ptSet.lftPixel, &ptSet.ctrPixel, &ptSet.rgtPixel,
+                                &ptSet.lftWorld, &ptSet.ctrWorld, &ptSet.rgtWorld };
+    AppendFixed3( buf, ptSet.angleWorld );
+    buf += ',';
+    for ( int i = 0; i < 6; ++i )
+    {
+        AppendFixed3( buf, pts[ i ]->x );
+        buf += ',';
+        AppendFixed3( buf, pts[ i ]->y );
+        buf += ',';
+    }
+}
+
+namespace gc
+{
+
+ResultSink::ResultSink() :
+    m_file( nullptr ),
+    m_withFiltered( false ),
+    m_syncRows( 0 ),
+    m_syncSeconds( 0.0 ),
+    m_rowsSinceSync( 0 )
+{
+}
+ResultSink::~ResultSink()
+{
+    Close();
+}
+GC_STATUS ResultSink::Open( const string csvFilepath, const bool overwrite, const bool withFiltered )
+{
+    GC_STATUS retVal = Close();
+    if ( GC_OK == retVal && !overwrite )
+    {
+        retVal = CheckHeader( csvFilepath, withFiltered );
+    }
+    if ( GC_OK == retVal )
+    {
+        try
+        {
+            m_file = fopen( csvFilepath.c_str(), overwrite ? "w" : "a" );
+            if ( nullptr == m_file )
+            {
+                FILE_LOG( logERROR ) << "[ResultSink::Open] Could not open to write " << csvFilepath;
+                retVal = GC_ERR;
+            }
+            else
+            {
+                // rows are gathered in m_buffer, so the stream itself does not need to buffer them
+                setvbuf( m_file, nullptr, _IONBF, 0 );
+                m_filepath = csvFilepath;
+                m_withFiltered = withFiltered;
+                m_buffer.clear();
+                m_buffer.reserve( RESULT_SINK_BLOCK_SIZE + 4096 );
+                m_rowsSinceSync = 0;
+                m_lastSync = chrono::steady_clock::now();
+
+                fseek( m_file, 0, SEEK_END );
+                if ( 0 == ftell( m_file ) )
+                {
+                    m_buffer = Header( m_withFiltered );
+                    m_buffer += '\n';
+                    retVal = Flush();
+                }
+            }
+        }
+        catch( std::exception &e )
+        {
+            FILE_LOG( logERROR ) << "[ResultSink::Open] " << e.what();
+            retVal = GC_EXCEPT;
+        }
+    }
+
+    return retVal;
+}
+GC_STATUS ResultSink::CheckHeader( const string csvFilepath, const bool withFiltered )
+{
+    GC_STATUS retVal = GC_OK;
+    try
+    {
+        // a file that does not exist or is empty gets the header when it is opened
+        ifstream csvFile( csvFilepath, ios::binary );
+        string header;
+        if ( csvFile.is_open() && getline( csvFile, header ) )
+        {
+            if ( !header.empty() && '\r' == header.back() )
+                header.pop_back();
+            if ( Header( withFiltered ) != header )
+            {
+                FILE_LOG( logERROR ) << "[ResultSink::CheckHeader] The columns of " << csvFilepath <<
+                                        " do not match the current result columns" << ( withFiltered ? " with" : " without" ) <<
+                                        " the filtered level, write the results to a new csv file";
+                retVal = GC_ERR;
+            }
+        }
+    }
+    catch( std::exception &e )
+    {
+        FILE_LOG( logERROR ) << "[ResultSink::CheckHeader] " << e.what();
+        retVal = GC_EXCEPT;
+    }
+    return retVal;
+}
+GC_STATUS ResultSink::SetSyncPolicy( const size_t syncRows, const double syncSeconds )
+{
+    GC_STATUS retVal = GC_OK;
+    if ( 0.0 > syncSeconds )
+    {
+        FILE_LOG( logERROR ) << "[ResultSink::SetSyncPolicy] Sync seconds cannot be negative";
+        retVal = GC_ERR;
+    }
+    else
+    {
+        m_syncRows = syncRows;
+        m_syncSeconds = syncSeconds;
+    }
+    return retVal;
+}
+GC_STATUS ResultSink::Write( const string &imgPath, const FindLineResult &result )
+{
+    GC_STATUS retVal = GC_OK;
+    if ( nullptr == m_file )
+    {
+        FILE_LOG( logERROR ) << "[ResultSink::Write] No csv file open";
+        retVal = GC_ERR;
+    }
+    else
+    {
+        try
+        {
+            AppendRow( imgPath, result, m_withFiltered, m_buffer );
+            m_buffer += '\n';
+            retVal = RowAdded();
+        }
+        catch( std::exception &e )
+        {
+            FILE_LOG( logERROR ) << "[ResultSink::Write] " << e.what();
+            retVal = GC_EXCEPT;
+        }
+    }
+    return retVal;
+}
+GC_STATUS ResultSink::WriteRow( const string &row )
+{
+    GC_STATUS retVal = GC_OK;
+    if ( nullptr == m_file )
+    {
+        FILE_LOG( logERROR ) << "[ResultSink::WriteRow] No csv file open";
+        retVal = GC_ERR;
+    }
+    else
+    {
+        try
+        {
+            m_buffer += row;
+            m_buffer += '\n';
+            retVal = RowAdded();
+        }
+        catch( std::exception &e )
+        {
+            FILE_LOG( logERROR ) << "[ResultSink::WriteRow] " << e.what();
+            retVal = GC_EXCEPT;
+        }
+    }
+    return retVal;
+}
+GC_STATUS ResultSink::Flush( const bool sync )
+{
+    GC_STATUS retVal = GC_OK;
+    if ( nullptr != m_file )
+    {
+        if ( !m_buffer.empty() )
+        {
+            size_t written = fwrite( m_buffer.data(), 1, m_buffer.size(), m_file );
+            if ( written != m_buffer.size() )
+            {
+                FILE_LOG( logERROR ) << "[ResultSink::Flush] Could not write to " << m_filepath;
+                retVal = GC_ERR;
+            }
+            m_buffer.clear();
+        }
+        if ( sync && GC_OK == retVal )
+        {
+#ifdef _WIN32
+            int ret = _commit( _fileno( m_file ) );
+#else
+            int ret = fsync( fileno( m_file ) );
+#endif
+            if ( 0 != ret )
+            {
+                FILE_LOG( logERROR ) << "[ResultSink::Flush] Could not sync " << m_filepath;
+                retVal = GC_ERR;
+            }
+            m_rowsSinceSync = 0;
+            m_lastSync = chrono::steady_clock::now();
+        }
+    }
+    return retVal;
+}
+GC_STATUS ResultSink::Close()
+{
+    GC_STATUS retVal = GC_OK;
+    if ( nullptr != m_file )
+    {
+        retVal = Flush( 0 < m_syncRows || 0.0 < m_syncSeconds );
+        if ( 0 != fclose( m_file ) )
+        {
+            FILE_LOG( logERROR ) << "[ResultSink::Close] Could not close " << m_filepath;
+            retVal = GC_ERR;
+        }
+        m_file = nullptr;
+        m_filepath.clear();
+        m_buffer.clear();
+    }
+    return retVal;
+}
+GC_STATUS ResultSink::RowAdded()
+{
+    GC_STATUS retVal = GC_OK;
+    ++m_rowsSinceSync;
+    bool sync = 0 < m_syncRows && m_syncRows <= m_rowsSinceSync;
+    if ( !sync && 0.0 < m_syncSeconds )
+    {
+        sync = m_syncSeconds <= chrono::duration< double >( chrono::steady_clock::now() - m_lastSync ).count();
+    }
+    if ( sync || RESULT_SINK_BLOCK_SIZE <= m_buffer.size() )
+    {
+        retVal = Flush( sync );
+    }
+    return retVal;
+}
+string ResultSink::Header( const bool withFiltered )
+{
+    stringstream csvFile;
+    csvFile << "imgPath,";
+    csvFile << "findSuccess,";
+
+    csvFile << "waterLevel,";
+    csvFile << "waterLevelAdjusted,";
+
+    csvFile << "calcLinePts-angle,";
+    csvFile << "calcLinePts-lftPixel-x,"; csvFile << "calcLinePts-lftPixel-y,";
+    csvFile << "calcLinePts-ctrPixel-x,"; csvFile << "calcLinePts-ctrPixel-y,";
+    csvFile << "calcLinePts-rgtPixel-x,"; csvFile << "calcLinePts-rgtPixel-y,";
+    csvFile << "calcLinePts-lftWorld-x,"; csvFile << "calcLinePts-lftWorld-y,";
+    csvFile << "calcLinePts-ctrWorld-x,"; csvFile << "calcLinePts-ctrWorld-y,";
+    csvFile << "calcLinePts-rgtWorld-x,"; csvFile << "calcLinePts-rgtWorld-y,";
+
+    csvFile << "refMovePts-angle,";
+    csvFile << "refMovePts-lftPixel-x,"; csvFile << "refMovePts-lftPixel-y,";
+    csvFile << "refMovePts-ctrPixel-x,"; csvFile << "refMovePts-ctrPixel-y,";
+    csvFile << "refMovePts-rgtPixel-x,"; csvFile << "refMovePts-rgtPixel-y,";
+    csvFile << "refMovePts-lftWorld-x,"; csvFile << "refMovePts-lftWorld-y,";
+    csvFile << "refMovePts-ctrWorld-x,"; csvFile << "refMovePts-ctrWorld-y,";
+    csvFile << "refMovePts-rgtWorld-x,"; csvFile << "refMovePts-rgtWorld-y,";
+
+    csvFile << "foundMovePts-angle,";
+    csvFile << "foundMovePts-lftPixel-x,"; csvFile << "foundMovePts-lftPixel-y,";
+    csvFile << "foundMovePts-ctrPixel-x,"; csvFile << "foundMovePts-ctrPixel-y,";
+    csvFile << "foundMovePts-rgtPixel-x,"; csvFile << "foundMovePts-rgtPixel-y,";
+    csvFile << "foundMovePts-lftWorld-x,"; csvFile << "foundMovePts-lftWorld-y,";
+    csvFile << "foundMovePts-ctrWorld-x,"; csvFile << "foundMovePts-ctrWorld-y,";
+    csvFile << "foundMovePts-rgtWorld-x,"; csvFile << "foundMovePts-rgtWorld-y,";
+
+    csvFile << "offsetMovePts-angle,";
+    csvFile << "offsetMovePts-lftPixel-x,"; csvFile << "offsetMovePts-lftPixel-y,";
+    csvFile << "offsetMovePts-ctrPixel-x,"; csvFile << "offsetMovePts-ctrPixel-y,";
+    csvFile << "offsetMovePts-rgtPixel-x,"; csvFile << "offsetMovePts-rgtPixel-y,";
+    csvFile << "offsetMovePts-lftWorld-x,"; csvFile << "offsetMovePts-lftWorld-y,";
+    csvFile << "offsetMovePts-ctrWorld-x,"; csvFile << "offsetMovePts-ctrWorld-y,";
+    csvFile << "offsetMovePts-rgtWorld-x,"; csvFile << "offsetMovePts-rgtWorld-y,";
+
+    if ( withFiltered )
+        csvFile << "waterLevelFiltered,";
+
+    csvFile << "foundPts[0]-x,"; csvFile << "foundPts[0]-y,"; csvFile << "foundPts[1]-x,"; csvFile << "foundPts[1]-y,";
+    csvFile << "foundPts[2]-x,"; csvFile << "foundPts[2]-y,"; csvFile << "foundPts[3]-x,"; csvFile << "foundPts[3]-y,";
+    csvFile << "foundPts[4]-x,"; csvFile << "foundPts[4]-y,"; csvFile << "foundPts[5]-x,"; csvFile << "foundPts[5]-y,";
+    csvFile << "foundPts[6]-x,"; csvFile << "foundPts[6]-y,"; csvFile << "foundPts[7]-x,"; csvFile << "foundPts[7]-y,";
+    csvFile << "foundPts[8]-x,"; csvFile << "foundPts[8]-y,"; csvFile << "foundPts[9]-x,"; csvFile << "foundPts[9]-y,";
+    csvFile << "...";
+    return csvFile.str();
+}
+GC_STATUS ResultSink::FormatRow( const string &imgPath, const FindLineResult &result, string &row, const bool withFiltered )
+{
+    GC_STATUS retVal = GC_OK;
+    try
+    {
+        row.clear();
+        AppendRow( imgPath, result, withFiltered, row );
+    }
+    catch( std::exception &e )
+    {
+        FILE_LOG( logERROR ) << "[ResultSink::FormatRow] " << e.what();
+        retVal = GC_EXCEPT;
+    }
+
+    return retVal;
+}
+void ResultSink::AppendRow( const string &imgPath, const FindLineResult &result, const bool withFiltered, string &buf )
+{
+    buf += imgPath;
+    buf += ',';
+    buf += result.findSuccess ? "true," : "false,";
+
+    AppendFixed3( buf, result.calcLinePts.ctrWorld.y );
+    buf += ',';
+
+    // the adjusted level is written the way operator<<( ostream, Point2d ) writes it
+    buf += '[';
+    AppendFixed3( buf, result.waterLevelAdjusted.x );
+    buf += ", ";
+    AppendFixed3( buf, result.waterLevelAdjusted.y );
+    buf += "],";
+
+    AppendPointSet( buf, result.calcLinePts );
+    AppendPointSet( buf, result.refMovePts );
+    AppendPointSet( buf, result.foundMovePts );
+    AppendPointSet( buf, result.offsetMovePts );
+
+    // GC_UNSET_FILTERED_LEVEL when the level of a run with the Kalman stage could not be filtered
+    if ( withFiltered )
+    {
+        AppendFixed3( buf, result.waterLevelFiltered );
+        buf += ',';
+    }
+
+    for ( size_t i = 0; i < result.foundPoints.size(); ++i )
+    {
+        AppendFixed3( buf, result.foundPoints[ i ].x );
+        buf += ',';
+        AppendFixed3( buf, result.foundPoints[ i ].y );
+        if ( result.foundPoints.size() - 1 > i )
+            buf += ',';
+    }
+}
+
+} // namespace gc
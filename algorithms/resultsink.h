@@ -0,0 +1,160 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+   Copyright 2021 Kenneth W. Chapman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/** \file resultsink.h
+ * @brief A class to write line find results to a csv file
+ *
+ * This file holds a class that keeps a csv result file open while line find results are
+ * added to it. Rows are formatted into a reusable buffer and written to the file in blocks,
+ * with optional periodic syncs to disk so a crash loses a bounded number of rows.
+ *
+ * \author Kenneth W. Chapman
+ * \copyright Copyright (C) 2010-2021, Kenneth W. Chapman <coffeesig@gmail.com>, all rights reserved.\n
+ * This project is released under the Apache License, Version 2.0.
+ * \bug No known bugs.
+ */
+
+#ifndef RESULTSINK_H
+#define RESULTSINK_H
+
+#include "gc_types.h"
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+namespace gc
+{
+
+static const size_t RESULT_SINK_BLOCK_SIZE = 65536;    ///< Buffered bytes that trigger a write to the csv file
+
+/**
+ * @brief Buffered writer of line find results to a csv file that stays open between rows
+ */
+class ResultSink
+{
+public:
+    /**
+     * @brief Constructor
+     */
+    ResultSink();
+
+    /**
+     * @brief Destructor, writes any buffered rows and closes the file
+     */
+    ~ResultSink();
+
+    /**
+     * @brief Open a csv file for writing, the header row is written if the file is new or empty
+     *
+     * An existing file is only appended when its header row matches Header() for the same
+     * withFiltered value, so rows are never added under the columns of another result format.
+     *
+     * @param csvFilepath Filepath of the csv file to be created or appended
+     * @param overwrite true=overwrite the csv file destroying what was previously there
+     * false=append the data to the file if exists and create a new one if it does not
+     * @param withFiltered true=rows hold the Kalman filtered level column, false=rows without it
+     * @return GC_OK=Success, GC_FAIL=Failure, GC_EXCEPT=Exception thrown
+     */
+    GC_STATUS Open( const std::string csvFilepath, const bool overwrite = false, const bool withFiltered = false );
+
+    /**
+     * @brief Set how often buffered rows are written and synced to disk
+     *
+     * The file is synced when either limit is reached, a value of zero disables that limit. When
+     * both are zero (the default) rows are written in blocks and syncing is left to the operating system.
+     *
+     * @param syncRows Number of rows after which the file is synced
+     * @param syncSeconds Number of seconds after which the file is synced (checked when a row is added)
+     * @return GC_OK=Success, GC_FAIL=Failure, GC_EXCEPT=Exception thrown
+     */
+    GC_STATUS SetSyncPolicy( const size_t syncRows, const double syncSeconds );
+
+    /**
+     * @brief Add the results of a waterlevel calculation as a row of the csv file
+     * @param imgPath Filepath of the image to which the results apply
+     * @param result The results of the waterlevel calculation
+     * @return GC_OK=Success, GC_FAIL=Failure, GC_EXCEPT=Exception thrown
+     */
+    GC_STATUS Write( const std::string &imgPath, const FindLineResult &result );
+
+    /**
+     * @brief Add an already formatted row (see FormatRow()) to the csv file
+     * @param row The row to add (without a line ending)
+     * @return GC_OK=Success, GC_FAIL=Failure, GC_EXCEPT=Exception thrown
+     */
+    GC_STATUS WriteRow( const std::string &row );
+
+    /**
+     * @brief Write the buffered rows to the file
+     * @param sync true=Also sync the file to disk
+     * @return GC_OK=Success, GC_FAIL=Failure, GC_EXCEPT=Exception thrown
+     */
+    GC_STATUS Flush( const bool sync = false );
+
+    /**
+     * @brief Write the buffered rows, sync the file to disk if a sync policy is set, and close it
+     * @return GC_OK=Success, GC_FAIL=Failure, GC_EXCEPT=Exception thrown
+     */
+    GC_STATUS Close();
+
+    /**
+     * @brief Get whether a csv file is open
+     * @return true=A file is open, false=No file is open
+     */
+    bool IsOpen() const { return nullptr != m_file; }
+
+    /**
+     * @brief Get the filepath of the open csv file
+     * @return Filepath of the open file, empty if no file is open
+     */
+    std::string Filepath() const { return m_filepath; }
+
+    /**
+     * @brief Retrieve the header row of the find line result csv file
+     * @param withFiltered true=Include the Kalman filtered level column after the fixed columns
+     * @return The header row (without a line ending)
+     */
+    static std::string Header( const bool withFiltered = false );
+
+    /**
+     * @brief Format a find line result as a csv row
+     * @param imgPath Filepath of the image to which the results apply
+     * @param result The results of the waterlevel calculation to be formatted
+     * @param row String to hold the formatted row (without a line ending), its capacity is reused
+     * @param withFiltered true=Include the Kalman filtered level column after the fixed columns
+     * @return GC_OK=Success, GC_FAIL=Failure, GC_EXCEPT=Exception thrown
+     */
+    static GC_STATUS FormatRow( const std::string &imgPath, const FindLineResult &result, std::string &row,
+                                const bool withFiltered = false );
+
+private:
+    FILE *m_file;
+    std::string m_filepath;
+    std::string m_buffer;
+    bool m_withFiltered;
+    size_t m_syncRows;
+    double m_syncSeconds;
+    size_t m_rowsSinceSync;
+    std::chrono::steady_clock::time_point m_lastSync;
+
+    GC_STATUS RowAdded();
+    static GC_STATUS CheckHeader( const std::string csvFilepath, const bool withFiltered );
+    static void AppendRow( const std::string &imgPath, const FindLineResult &result, const bool withFiltered, std::string &buf );
+};
+
+} // namespace gc
+
+#endif // RESULTSINK_H
@@ -0,0 +1,576 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+   Copyright 2021 Kenneth W. Chapman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include "log.h"
+#include "resultstore.h"
+#include "timestampconvert.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <boost/filesystem.hpp>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace cv;
+using namespace std;
+namespace fs = boost::filesystem;
+
+static const char RESULT_STORE_MAGIC[ 8 ] = { 'G', 'C', 'R', 'S', 'T', 'O', 'R', '\0' };
+static const char RESULT_STORE_INDEX_MAGIC[ 8 ] = { 'G', 'C', 'R', 'S', 'I', 'D', 'X', '\0' };
+static const uint32_t RESULT_STORE_VERSION = 1;
+static const size_t RESULT_STORE_MAX_POINTS_PER_ROW = 255;
+
+// Store file header, blocks follow it back to back
+struct ResultStoreHeader
+{
+    char magic[ 8 ];
+    uint32_t version;
+    uint32_t pointsPerRow;
+    uint32_t blockRows;
+    uint32_t reserved[ 11 ];
+};
+static_assert( sizeof( ResultStoreHeader ) == 64, "Result store header layout changed" );
+
+// Index file header, ResultStoreBlockIndex entries follow it
+struct ResultStoreIndexHeader
+{
+    char magic[ 8 ];
+    uint32_t version;
+    uint32_t reserved;
+};
+static_assert( sizeof( ResultStoreIndexHeader ) == 16, "Result store index header layout changed" );
+static_assert( sizeof( gc::ResultStoreBlockIndex ) == 32, "Result store index entry layout changed" );
+
+// Block columns in the order they are stored, each starts on an 8 byte boundary
+enum RESULT_STORE_COLUMN
+{
+    COL_TIMESTAMP = 0,
+    COL_FIND_SUCCESS,
+    COL_WATER_LEVEL,
+    COL_WATER_LEVEL_ADJUSTED,
+    COL_WATER_LEVEL_FILTERED,
+    COL_MOVE_OFFSET_X,
+    COL_MOVE_OFFSET_Y,
+    COL_MOVE_OFFSET_WORLD_X,
+    COL_MOVE_OFFSET_WORLD_Y,
+    COL_FOUND_POINT_COUNT,
+    COL_FOUND_POINTS,
+    COL_COUNT
+};
+
+// Calculates the offset of each column from the start of a block and returns the block size
+static size_t BlockLayout( const size_t rowCount, const size_t pointsPerRow, size_t offsets[ COL_COUNT ] )
+{
+    const size_t widths[ COL_COUNT ] = { sizeof( int64_t ), sizeof( uint8_t ), sizeof( double ), sizeof( double ),
+                                         sizeof( double ), sizeof( double ), sizeof( double ), sizeof( double ),
+                                         sizeof( double ), sizeof( uint8_t ), 2 * pointsPerRow * sizeof( double ) };
+    size_t size = 0;
+    for ( int i = 0; i < COL_COUNT; ++i )
+    {
+        offsets[ i ] = size;
+        size += ( widths[ i ] * rowCount + 7 ) & ~static_cast< size_t >( 7 );
+    }
+    return size;
+}
+
+namespace gc
+{
+
+GC_STATUS ResultStoreRow::Set( const FindLineResult &result )
+{
+    long long secsFromEpoch;
+    GC_STATUS retVal = GcTimestampConvert::ISOTimestampToSeconds( result.timestamp, secsFromEpoch );
+    if ( GC_OK == retVal )
+    {
+        timestamp = static_cast< int64_t >( secsFromEpoch );
+        findSuccess = result.findSuccess;
+        waterLevel = result.calcLinePts.ctrWorld.y;
+        waterLevelAdjusted = result.waterLevelAdjusted.y;
+        waterLevelFiltered = result.hasFilteredLevel() ? result.waterLevelFiltered : numeric_limits< double >::quiet_NaN();
+        moveOffset = result.offsetMovePts.ctrPixel;
+        moveOffsetWorld = result.offsetMovePts.ctrWorld;
+        foundPoints = result.foundPoints;
+    }
+    return retVal;
+}
+
+ResultStoreWriter::ResultStoreWriter() :
+    m_dataFile( nullptr ),
+    m_indexFile( nullptr ),
+    m_pointsPerRow( RESULT_STORE_POINTS_PER_ROW ),
+    m_dataSize( 0 )
+{
+}
+ResultStoreWriter::~ResultStoreWriter()
+{
+    Close();
+}
+GC_STATUS ResultStoreWriter::Open( const string storeFilepath, const size_t pointsPerRow )
+{
+    GC_STATUS retVal = Close();
+    if ( GC_OK != retVal )
+    {
+        return retVal;
+    }
+    if ( 0 == pointsPerRow || RESULT_STORE_MAX_POINTS_PER_ROW < pointsPerRow )
+    {
+        FILE_LOG( logERROR ) << "[ResultStoreWriter::Open] Points per row must be 1 to " << RESULT_STORE_MAX_POINTS_PER_ROW;
+        return GC_ERR;
+    }
+
+    try
+    {
+        string indexFilepath = storeFilepath + RESULT_STORE_INDEX_EXTENSION;
+        if ( !fs::exists( storeFilepath ) || 0 == fs::file_size( storeFilepath ) )
+        {
+            ResultStoreHeader header;
+            memset( &header, 0, sizeof( header ) );
+            memcpy( header.magic, RESULT_STORE_MAGIC, sizeof( RESULT_STORE_MAGIC ) );
+            header.version = RESULT_STORE_VERSION;
+            header.pointsPerRow = static_cast< uint32_t >( pointsPerRow );
+            header.blockRows = static_cast< uint32_t >( RESULT_STORE_BLOCK_ROWS );
+
+            ResultStoreIndexHeader indexHeader;
+            memset( &indexHeader, 0, sizeof( indexHeader ) );
+            memcpy( indexHeader.magic, RESULT_STORE_INDEX_MAGIC, sizeof( RESULT_STORE_INDEX_MAGIC ) );
+            indexHeader.version = RESULT_STORE_VERSION;
+
+            ofstream dataStream( storeFilepath, ios::out | ios::binary | ios::trunc );
+            ofstream indexStream( indexFilepath, ios::out | ios::binary | ios::trunc );
+            dataStream.write( reinterpret_cast< const char * >( &header ), sizeof( header ) );
+            indexStream.write( reinterpret_cast< const char * >( &indexHeader ), sizeof( indexHeader ) );
+            if ( !dataStream.good() || !indexStream.good() )
+            {
+                FILE_LOG( logERROR ) << "[ResultStoreWriter::Open] Could not create " << storeFilepath;
+                retVal = GC_ERR;
+            }
+            m_pointsPerRow = pointsPerRow;
+            m_dataSize = sizeof( header );
+        }
+        else
+        {
+            ResultStoreHeader header;
+            ResultStoreIndexHeader indexHeader;
+            ifstream dataStream( storeFilepath, ios::in | ios::binary );
+            ifstream indexStream( indexFilepath, ios::in | ios::binary );
+            dataStream.read( reinterpret_cast< char * >( &header ), sizeof( header ) );
+            indexStream.read( reinterpret_cast< char * >( &indexHeader ), sizeof( indexHeader ) );
+            if ( !dataStream.good() || !indexStream.good() ||
+                 0 != memcmp( header.magic, RESULT_STORE_MAGIC, sizeof( RESULT_STORE_MAGIC ) ) ||
+                 0 != memcmp( indexHeader.magic, RESULT_STORE_INDEX_MAGIC, sizeof( RESULT_STORE_INDEX_MAGIC ) ) ||
+                 RESULT_STORE_VERSION != header.version || RESULT_STORE_VERSION != indexHeader.version ||
+                 0 == header.pointsPerRow || RESULT_STORE_MAX_POINTS_PER_ROW < header.pointsPerRow )
+            {
+                FILE_LOG( logERROR ) << "[ResultStoreWriter::Open] Not a valid result store: " << storeFilepath;
+                retVal = GC_ERR;
+            }
+            else
+            {
+                // keep the blocks the index accounts for, anything after them was left by an interrupted write
+                m_pointsPerRow = header.pointsPerRow;
+                m_dataSize = sizeof( header );
+                uintmax_t fileSize = fs::file_size( storeFilepath );
+                size_t entryCount = 0;
+                size_t offsets[ COL_COUNT ];
+                ResultStoreBlockIndex entry;
+                while ( indexStream.read( reinterpret_cast< char * >( &entry ), sizeof( entry ) ) )
+                {
+                    uint64_t blockEnd = entry.offset + BlockLayout( entry.rowCount, m_pointsPerRow, offsets );
+                    if ( entry.offset != m_dataSize || fileSize < blockEnd )
+                        break;
+                    m_dataSize = blockEnd;
+                    ++entryCount;
+                }
+                dataStream.close();
+                indexStream.close();
+                fs::resize_file( storeFilepath, m_dataSize );
+                fs::resize_file( indexFilepath, sizeof( indexHeader ) + entryCount * sizeof( entry ) );
+            }
+        }
+
+        if ( GC_OK == retVal )
+        {
+            m_dataFile = fopen( storeFilepath.c_str(), "ab" );
+            m_indexFile = fopen( indexFilepath.c_str(), "ab" );
+            if ( nullptr == m_dataFile || nullptr == m_indexFile )
+            {
+                FILE_LOG( logERROR ) << "[ResultStoreWriter::Open] Could not open to write " << storeFilepath;
+                if ( nullptr != m_dataFile )
+                    fclose( m_dataFile );
+                if ( nullptr != m_indexFile )
+                    fclose( m_indexFile );
+                m_dataFile = nullptr;
+                m_indexFile = nullptr;
+                retVal = GC_ERR;
+            }
+            else
+            {
+                m_filepath = storeFilepath;
+                m_rows.clear();
+                m_rows.reserve( RESULT_STORE_BLOCK_ROWS );
+            }
+        }
+    }
+    catch( std::exception &e )
+    {
+        FILE_LOG( logERROR ) << "[ResultStoreWriter::Open] " << e.what();
+        retVal = GC_EXCEPT;
+    }
+
+    return retVal;
+}
+GC_STATUS ResultStoreWriter::Append( const FindLineResult &result )
+{
+    ResultStoreRow row;
+    GC_STATUS retVal = row.Set( result );
+    if ( GC_OK == retVal )
+    {
+        retVal = Append( row );
+    }
+    return retVal;
+}
+GC_STATUS ResultStoreWriter::Append( const ResultStoreRow &row )
+{
+    GC_STATUS retVal = GC_OK;
+    if ( nullptr == m_dataFile )
+    {
+        FILE_LOG( logERROR ) << "[ResultStoreWriter::Append] No result store open";
+        retVal = GC_ERR;
+    }
+    else
+    {
+        m_rows.push_back( row );
+        if ( RESULT_STORE_BLOCK_ROWS <= m_rows.size() )
+        {
+            retVal = Flush();
+        }
+    }
+    return retVal;
+}
+GC_STATUS ResultStoreWriter::Flush()
+{
+    GC_STATUS retVal = GC_OK;
+    if ( nullptr != m_dataFile && !m_rows.empty() )
+    {
+        try
+        {
+            stable_sort( m_rows.begin(), m_rows.end(),
+                         []( const ResultStoreRow &a, const ResultStoreRow &b ) { return a.timestamp < b.timestamp; } );
+
+            size_t rowCount = m_rows.size();
+            size_t offsets[ COL_COUNT ];
+            size_t blockSize = BlockLayout( rowCount, m_pointsPerRow, offsets );
+            m_block.assign( blockSize, 0 );
+
+            char *block = m_block.data();
+            const double nanVal = numeric_limits< double >::quiet_NaN();
+            for ( size_t i = 0; i < rowCount; ++i )
+            {
+                const ResultStoreRow &row = m_rows[ i ];
+                uint8_t isFound = row.findSuccess ? 1 : 0;
+                uint8_t pointCount = static_cast< uint8_t >( std::min( row.foundPoints.size(), m_pointsPerRow ) );
+                memcpy( block + offsets[ COL_TIMESTAMP ] + i * sizeof( int64_t ), &row.timestamp, sizeof( int64_t ) );
+                memcpy( block + offsets[ COL_FIND_SUCCESS ] + i, &isFound, sizeof( uint8_t ) );
+                memcpy( block + offsets[ COL_WATER_LEVEL ] + i * sizeof( double ), &row.waterLevel, sizeof( double ) );
+                memcpy( block + offsets[ COL_WATER_LEVEL_ADJUSTED ] + i * sizeof( double ), &row.waterLevelAdjusted, sizeof( double ) );
+                memcpy( block + offsets[ COL_WATER_LEVEL_FILTERED ] + i * sizeof( double ), &row.waterLevelFiltered, sizeof( double ) );
+                memcpy( block + offsets[ COL_MOVE_OFFSET_X ] + i * sizeof( double ), &row.moveOffset.x, sizeof( double ) );
+                memcpy( block + offsets[ COL_MOVE_OFFSET_Y ] + i * sizeof( double ), &row.moveOffset.y, sizeof( double ) );
+                memcpy( block + offsets[ COL_MOVE_OFFSET_WORLD_X ] + i * sizeof( double ), &row.moveOffsetWorld.x, sizeof( double ) );
+                memcpy( block + offsets[ COL_MOVE_OFFSET_WORLD_Y ] + i * sizeof( double ), &row.moveOffsetWorld.y, sizeof( double ) );
+                memcpy( block + offsets[ COL_FOUND_POINT_COUNT ] + i, &pointCount, sizeof( uint8_t ) );
+
+                char *points = block + offsets[ COL_FOUND_POINTS ] + i * 2 * m_pointsPerRow * sizeof( double );
+                for ( size_t j = 0; j < m_pointsPerRow; ++j )
+                {
+                    double xy[ 2 ] = { nanVal, nanVal };
+                    if ( j < pointCount )
+                    {
+                        xy[ 0 ] = row.foundPoints[ j ].x;
+                        xy[ 1 ] = row.foundPoints[ j ].y;
+                    }
+                    memcpy( points + j * sizeof( xy ), xy, sizeof( xy ) );
+                }
+            }
+
+            ResultStoreBlockIndex entry;
+            memset( &entry, 0, sizeof( entry ) );
+            entry.offset = m_dataSize;
+            entry.rowCount = static_cast< uint32_t >( rowCount );
+            entry.minTime = m_rows.front().timestamp;
+            entry.maxTime = m_rows.back().timestamp;
+
+            // the block is written before its index entry so a reader never sees an entry without its block
+            if ( blockSize != fwrite( block, 1, blockSize, m_dataFile ) || 0 != fflush( m_dataFile ) )
+            {
+                FILE_LOG( logERROR ) << "[ResultStoreWriter::Flush] Could not write block to " << m_filepath;
+                retVal = GC_ERR;
+            }
+            else if ( 1 != fwrite( &entry, sizeof( entry ), 1, m_indexFile ) || 0 != fflush( m_indexFile ) )
+            {
+                FILE_LOG( logERROR ) << "[ResultStoreWriter::Flush] Could not write index of " << m_filepath;
+                retVal = GC_ERR;
+            }
+
+            if ( GC_OK == retVal )
+            {
+                m_dataSize += blockSize;
+                m_rows.clear();
+            }
+            else
+            {
+                // the block or its index entry may be partly written, so the store is reopened, which cuts
+                // it back to the blocks its index accounts for, and the rows are kept to be written again
+                // unless the block turned out to be complete
+                uint64_t dataSize = m_dataSize;
+                string filepath = m_filepath;
+                vector< ResultStoreRow > rows;
+                rows.swap( m_rows );
+                fclose( m_dataFile );
+                fclose( m_indexFile );
+                m_dataFile = nullptr;
+                m_indexFile = nullptr;
+                if ( GC_OK != Open( filepath, m_pointsPerRow ) )
+                {
+                    FILE_LOG( logERROR ) << "[ResultStoreWriter::Flush] Could not reopen " << filepath << ", " << rows.size() << " rows were dropped";
+                }
+                else if ( dataSize == m_dataSize )
+                {
+                    m_rows.swap( rows );
+                }
+            }
+        }
+        catch( std::exception &e )
+        {
+            FILE_LOG( logERROR ) << "[ResultStoreWriter::Flush] " << e.what();
+            retVal = GC_EXCEPT;
+        }
+    }
+    return retVal;
+}
+GC_STATUS ResultStoreWriter::Close()
+{
+    GC_STATUS retVal = GC_OK;
+    if ( nullptr != m_dataFile )
+    {
+        // a failed flush can leave the store closed if it could not be reopened
+        retVal = Flush();
+        if ( nullptr != m_dataFile )
+        {
+            fclose( m_dataFile );
+            fclose( m_indexFile );
+            m_dataFile = nullptr;
+            m_indexFile = nullptr;
+        }
+        m_filepath.clear();
+        m_rows.clear();
+    }
+    return retVal;
+}
+
+ResultStoreReader::ResultStoreReader() :
+    m_data( nullptr ),
+    m_dataSize( 0 ),
+#ifdef _WIN32
+    m_fileHandle( nullptr ),
+    m_mapHandle( nullptr ),
+#else
+    m_fileDesc( -1 ),
+#endif
+    m_pointsPerRow( 0 ),
+    m_rowCount( 0 )
+{
+}
+ResultStoreReader::~ResultStoreReader()
+{
+    Close();
+}
+GC_STATUS ResultStoreReader::Open( const string storeFilepath )
+{
+    Close();
+
+    GC_STATUS retVal = GC_OK;
+    try
+    {
+        if ( !fs::exists( storeFilepath ) || sizeof( ResultStoreHeader ) > fs::file_size( storeFilepath ) )
+        {
+            FILE_LOG( logERROR ) << "[ResultStoreReader::Open] Not a valid result store: " << storeFilepath;
+            return GC_ERR;
+        }
+
+#ifdef _WIN32
+        m_fileHandle = CreateFileA( storeFilepath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                                    nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr );
+        if ( INVALID_HANDLE_VALUE == m_fileHandle )
+        {
+            m_fileHandle = nullptr;
+        }
+        else
+        {
+            LARGE_INTEGER fileSize;
+            if ( GetFileSizeEx( m_fileHandle, &fileSize ) )
+            {
+                m_mapHandle = CreateFileMappingA( m_fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr );
+                if ( nullptr != m_mapHandle )
+                {
+                    m_data = static_cast< const char * >( MapViewOfFile( m_mapHandle, FILE_MAP_READ, 0, 0, 0 ) );
+                    m_dataSize = static_cast< size_t >( fileSize.QuadPart );
+                }
+            }
+        }
+#else
+        m_fileDesc = open( storeFilepath.c_str(), O_RDONLY );
+        if ( 0 <= m_fileDesc )
+        {
+            struct stat fileStat;
+            if ( 0 == fstat( m_fileDesc, &fileStat ) )
+            {
+                void *mapped = mmap( nullptr, static_cast< size_t >( fileStat.st_size ), PROT_READ, MAP_SHARED, m_fileDesc, 0 );
+                if ( MAP_FAILED != mapped )
+                {
+                    m_data = static_cast< const char * >( mapped );
+                    m_dataSize = static_cast< size_t >( fileStat.st_size );
+                }
+            }
+        }
+#endif
+        if ( nullptr == m_data )
+        {
+            FILE_LOG( logERROR ) << "[ResultStoreReader::Open] Could not map " << storeFilepath;
+            retVal = GC_ERR;
+        }
+        else
+        {
+            ResultStoreHeader header;
+            memcpy( &header, m_data, sizeof( header ) );
+
+            ResultStoreIndexHeader indexHeader;
+            ifstream indexStream( storeFilepath + RESULT_STORE_INDEX_EXTENSION, ios::in | ios::binary );
+            indexStream.read( reinterpret_cast< char * >( &indexHeader ), sizeof( indexHeader ) );
+            if ( !indexStream.good() ||
+                 0 != memcmp( header.magic, RESULT_STORE_MAGIC, sizeof( RESULT_STORE_MAGIC ) ) ||
+                 0 != memcmp( indexHeader.magic, RESULT_STORE_INDEX_MAGIC, sizeof( RESULT_STORE_INDEX_MAGIC ) ) ||
+                 RESULT_STORE_VERSION != header.version || RESULT_STORE_VERSION != indexHeader.version ||
+                 0 == header.pointsPerRow || RESULT_STORE_MAX_POINTS_PER_ROW < header.pointsPerRow )
+            {
+                FILE_LOG( logERROR ) << "[ResultStoreReader::Open] Not a valid result store: " << storeFilepath;
+                retVal = GC_ERR;
+            }
+            else
+            {
+                // blocks the map does not hold completely (still being written) are left out
+                m_pointsPerRow = header.pointsPerRow;
+                size_t offsets[ COL_COUNT ];
+                ResultStoreBlockIndex entry;
+                while ( indexStream.read( reinterpret_cast< char * >( &entry ), sizeof( entry ) ) )
+                {
+                    if ( m_dataSize < entry.offset + BlockLayout( entry.rowCount, m_pointsPerRow, offsets ) )
+                        break;
+                    m_index.push_back( entry );
+                    m_rowCount += entry.rowCount;
+                }
+            }
+        }
+    }
+    catch( std::exception &e )
+    {
+        FILE_LOG( logERROR ) << "[ResultStoreReader::Open] " << e.what();
+        retVal = GC_EXCEPT;
+    }
+
+    if ( GC_OK != retVal )
+    {
+        Close();
+    }
+    return retVal;
+}
+void ResultStoreReader::Close()
+{
+#ifdef _WIN32
+    if ( nullptr != m_data )
+        UnmapViewOfFile( m_data );
+    if ( nullptr != m_mapHandle )
+        CloseHandle( m_mapHandle );
+    if ( nullptr != m_fileHandle )
+        CloseHandle( m_fileHandle );
+    m_mapHandle = nullptr;
+    m_fileHandle = nullptr;
+#else
+    if ( nullptr != m_data )
+        munmap( const_cast< char * >( m_data ), m_dataSize );
+    if ( 0 <= m_fileDesc )
+        close( m_fileDesc );
+    m_fileDesc = -1;
+#endif
+    m_data = nullptr;
+    m_dataSize = 0;
+    m_pointsPerRow = 0;
+    m_rowCount = 0;
+    m_index.clear();
+}
+GC_STATUS ResultStoreReader::Query( const int64_t startTime, const int64_t endTime, vector< ResultStoreSpan > &spans ) const
+{
+    GC_STATUS retVal = GC_OK;
+    spans.clear();
+    if ( nullptr == m_data )
+    {
+        FILE_LOG( logERROR ) << "[ResultStoreReader::Query] No result store open";
+        retVal = GC_ERR;
+    }
+    else
+    {
+        size_t offsets[ COL_COUNT ];
+        for ( size_t i = 0; i < m_index.size(); ++i )
+        {
+            const ResultStoreBlockIndex &entry = m_index[ i ];
+            if ( entry.maxTime < startTime || entry.minTime > endTime )
+                continue;
+
+            BlockLayout( entry.rowCount, m_pointsPerRow, offsets );
+            const char *block = m_data + entry.offset;
+            const int64_t *times = reinterpret_cast< const int64_t * >( block + offsets[ COL_TIMESTAMP ] );
+            size_t first = static_cast< size_t >( lower_bound( times, times + entry.rowCount, startTime ) - times );
+            size_t last = static_cast< size_t >( upper_bound( times, times + entry.rowCount, endTime ) - times );
+            if ( first < last )
+            {
+                ResultStoreSpan span;
+                span.rowCount = last - first;
+                span.pointsPerRow = m_pointsPerRow;
+                span.timestamps = times + first;
+                span.findSuccess = reinterpret_cast< const uint8_t * >( block + offsets[ COL_FIND_SUCCESS ] ) + first;
+                span.waterLevel = reinterpret_cast< const double * >( block + offsets[ COL_WATER_LEVEL ] ) + first;
+                span.waterLevelAdjusted = reinterpret_cast< const double * >( block + offsets[ COL_WATER_LEVEL_ADJUSTED ] ) + first;
+                span.waterLevelFiltered = reinterpret_cast< const double * >( block + offsets[ COL_WATER_LEVEL_FILTERED ] ) + first;
+                span.moveOffsetX = reinterpret_cast< const double * >( block + offsets[ COL_MOVE_OFFSET_X ] ) + first;
+                span.moveOffsetY = reinterpret_cast< const double * >( block + offsets[ COL_MOVE_OFFSET_Y ] ) + first;
+                span.moveOffsetWorldX = reinterpret_cast< const double * >( block + offsets[ COL_MOVE_OFFSET_WORLD_X ] ) + first;
+                span.moveOffsetWorldY = reinterpret_cast< const double * >( block + offsets[ COL_MOVE_OFFSET_WORLD_Y ] ) + first;
+                span.foundPointCount = reinterpret_cast< const uint8_t * >( block + offsets[ COL_FOUND_POINT_COUNT ] ) + first;
+                span.foundPoints = reinterpret_cast< const double * >( block + offsets[ COL_FOUND_POINTS ] ) + first * 2 * m_pointsPerRow;
+                spans.push_back( span );
+            }
+        }
+    }
+    return retVal;
+}
+
+} // namespace gc
@@ -0,0 +1,286 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+   Copyright 2021 Kenneth W. Chapman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/** \file resultstore.h
+ * @brief Classes to write and read line find result time series in a columnar binary store
+ *
+ * A result store holds the main values of line find results in fixed width columns so long
+ * time series can be queried by time without parsing text. The store is append only. Rows
+ * are gathered into blocks, each block holds its rows sorted by time with every column
+ * stored contiguously, and a small index file holds the time range and file offset of each
+ * block. The reader memory maps the store and returns pointers straight into the mapped
+ * columns.
+ *
+ * \author Kenneth W. Chapman
+ * \copyright Copyright (C) 2010-2021, Kenneth W. Chapman <coffeesig@gmail.com>, all rights reserved.\n
+ * This project is released under the Apache License, Version 2.0.
+ * \bug No known bugs.
+ */
+
+#ifndef RESULTSTORE_H
+#define RESULTSTORE_H
+
+#include "gc_types.h"
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+
+namespace gc
+{
+
+static const size_t RESULT_STORE_BLOCK_ROWS = 4096;            ///< Maximum number of rows in a result store block
+static const size_t RESULT_STORE_POINTS_PER_ROW = 10;          ///< Default number of found line points held per row
+static const size_t RESULT_STORE_WATCH_FLUSH_ROWS = 64;        ///< Rows a folder watch buffers before it writes a block
+static const double RESULT_STORE_WATCH_FLUSH_SECS = 300.0;     ///< Longest time a folder watch holds buffered rows
+static const std::string RESULT_STORE_INDEX_EXTENSION = ".idx";   ///< Appended to the store filepath for its index file
+
+/**
+ * @brief The values of one line find result held by a result store
+ */
+class ResultStoreRow
+{
+public:
+    /**
+     * @brief Constructor sets the values to an unfound state
+     */
+    ResultStoreRow() :
+        timestamp( 0 ),
+        findSuccess( false ),
+        waterLevel( std::numeric_limits< double >::quiet_NaN() ),
+        waterLevelAdjusted( std::numeric_limits< double >::quiet_NaN() ),
+        waterLevelFiltered( std::numeric_limits< double >::quiet_NaN() ),
+        moveOffset( std::numeric_limits< double >::quiet_NaN(), std::numeric_limits< double >::quiet_NaN() ),
+        moveOffsetWorld( std::numeric_limits< double >::quiet_NaN(), std::numeric_limits< double >::quiet_NaN() )
+    {}
+
+    /**
+     * @brief Set the row from a line find result
+     * @param result Line find result, its timestamp must be an ISO timestamp (yyyy-mm-ddTHH:MM:SS)
+     * @return GC_OK=Success, GC_FAIL=Failure, GC_EXCEPT=Exception thrown
+     */
+    GC_STATUS Set( const FindLineResult &result );
+
+    int64_t timestamp;                          ///< Image capture time in seconds from the epoch (UTC)
+    bool findSuccess;                           ///< true=Successful find, false=Failed find
+    double waterLevel;                          ///< World coordinate water level
+    double waterLevelAdjusted;                  ///< World coordinate water level adjusted for target movement
+    double waterLevelFiltered;                  ///< Kalman filtered adjusted water level, nan when not filtered
+    cv::Point2d moveOffset;                     ///< Pixel offset of the move targets from their calibration position
+    cv::Point2d moveOffsetWorld;                ///< World offset of the move targets from their calibration position
+    std::vector< cv::Point2d > foundPoints;     ///< Water line points used to calculate the found water level line
+};
+
+/**
+ * @brief Pointers to the rows of one block of a result store that fall within a time range
+ *
+ * The pointers point into the memory mapped store and are valid until the reader is closed.
+ */
+class ResultStoreSpan
+{
+public:
+    /**
+     * @brief Constructor
+     */
+    ResultStoreSpan() :
+        rowCount( 0 ),
+        pointsPerRow( 0 ),
+        timestamps( nullptr ),
+        findSuccess( nullptr ),
+        waterLevel( nullptr ),
+        waterLevelAdjusted( nullptr ),
+        waterLevelFiltered( nullptr ),
+        moveOffsetX( nullptr ),
+        moveOffsetY( nullptr ),
+        moveOffsetWorldX( nullptr ),
+        moveOffsetWorldY( nullptr ),
+        foundPointCount( nullptr ),
+        foundPoints( nullptr )
+    {}
+
+    size_t rowCount;                    ///< Number of rows in the span
+    size_t pointsPerRow;                ///< Number of found point slots per row
+    const int64_t *timestamps;          ///< Capture times in seconds from the epoch in ascending order
+    const uint8_t *findSuccess;         ///< 1=Successful find, 0=Failed find
+    const double *waterLevel;           ///< World coordinate water levels
+    const double *waterLevelAdjusted;   ///< World coordinate water levels adjusted for target movement
+    const double *waterLevelFiltered;   ///< Kalman filtered adjusted water levels, nan where not filtered
+    const double *moveOffsetX;          ///< Pixel x offsets of the move targets
+    const double *moveOffsetY;          ///< Pixel y offsets of the move targets
+    const double *moveOffsetWorldX;     ///< World x offsets of the move targets
+    const double *moveOffsetWorldY;     ///< World y offsets of the move targets
+    const uint8_t *foundPointCount;     ///< Number of found points held for each row
+    const double *foundPoints;          ///< pointsPerRow x,y pairs per row, unused slots are nan
+};
+
+/**
+ * @brief Index file entry that locates a block of a result store
+ */
+class ResultStoreBlockIndex
+{
+public:
+    uint64_t offset;        ///< Offset of the block from the start of the store file
+    uint32_t rowCount;      ///< Number of rows in the block
+    uint32_t reserved;      ///< Unused, zero
+    int64_t minTime;        ///< Earliest capture time in the block
+    int64_t maxTime;        ///< Latest capture time in the block
+};
+
+/**
+ * @brief Appends line find results to a result store
+ */
+class ResultStoreWriter
+{
+public:
+    /**
+     * @brief Constructor
+     */
+    ResultStoreWriter();
+
+    /**
+     * @brief Destructor, writes any buffered rows and closes the store
+     */
+    ~ResultStoreWriter();
+
+    /**
+     * @brief Open a result store to append rows, the store is created if it does not exist
+     *
+     * A block that was partly written when a previous writer was interrupted is discarded.
+     *
+     * @param storeFilepath Filepath of the store (its index is the filepath with .idx appended)
+     * @param pointsPerRow Number of found points held per row when the store is created
+     * @return GC_OK=Success, GC_FAIL=Failure, GC_EXCEPT=Exception thrown
+     */
+    GC_STATUS Open( const std::string storeFilepath, const size_t pointsPerRow = RESULT_STORE_POINTS_PER_ROW );
+
+    /**
+     * @brief Append a line find result to the store
+     * @param result Line find result, its timestamp must be an ISO timestamp (yyyy-mm-ddTHH:MM:SS)
+     * @return GC_OK=Success, GC_FAIL=Failure, GC_EXCEPT=Exception thrown
+     */
+    GC_STATUS Append( const FindLineResult &result );
+
+    /**
+     * @brief Append a row to the store, rows are written to the store in blocks
+     * @param row The row to append (found points beyond the store points per row are dropped)
+     * @return GC_OK=Success, GC_FAIL=Failure, GC_EXCEPT=Exception thrown
+     */
+    GC_STATUS Append( const ResultStoreRow &row );
+
+    /**
+     * @brief Write the buffered rows to the store as a block and add it to the index
+     *
+     * When the write fails the store is cut back to its last complete block and the rows stay
+     * buffered for the next flush. If the store cannot be reopened it is left closed.
+     *
+     * @return GC_OK=Success, GC_FAIL=Failure, GC_EXCEPT=Exception thrown
+     */
+    GC_STATUS Flush();
+
+    /**
+     * @brief Write the buffered rows and close the store
+     * @return GC_OK=Success, GC_FAIL=Failure, GC_EXCEPT=Exception thrown
+     */
+    GC_STATUS Close();
+
+    /**
+     * @brief Get whether a store is open
+     * @return true=A store is open, false=No store is open
+     */
+    bool IsOpen() const { return nullptr != m_dataFile; }
+
+private:
+    FILE *m_dataFile;
+    FILE *m_indexFile;
+    std::string m_filepath;
+    size_t m_pointsPerRow;
+    uint64_t m_dataSize;
+    std::vector< ResultStoreRow > m_rows;
+    std::vector< char > m_block;
+};
+
+/**
+ * @brief Reads time ranges of a result store through a read only memory map
+ */
+class ResultStoreReader
+{
+public:
+    /**
+     * @brief Constructor
+     */
+    ResultStoreReader();
+
+    /**
+     * @brief Destructor, unmaps the store
+     */
+    ~ResultStoreReader();
+
+    /**
+     * @brief Map a result store and read its index
+     * @param storeFilepath Filepath of the store
+     * @return GC_OK=Success, GC_FAIL=Failure, GC_EXCEPT=Exception thrown
+     */
+    GC_STATUS Open( const std::string storeFilepath );
+
+    /**
+     * @brief Unmap the store, spans from Query() are no longer valid
+     */
+    void Close();
+
+    /**
+     * @brief Get the rows of the store that fall within a time range
+     *
+     * One span is returned for each block of the store that holds rows within the range, in the
+     * order the blocks were written. Rows within each span are in ascending time order.
+     *
+     * @param startTime First time of the range in seconds from the epoch
+     * @param endTime Last time of the range in seconds from the epoch (inclusive)
+     * @param spans Vector of spans of the rows within the range
+     * @return GC_OK=Success, GC_FAIL=Failure, GC_EXCEPT=Exception thrown
+     */
+    GC_STATUS Query( const int64_t startTime, const int64_t endTime, std::vector< ResultStoreSpan > &spans ) const;
+
+    /**
+     * @brief Get the number of rows in the store
+     * @return Number of rows
+     */
+    size_t RowCount() const { return m_rowCount; }
+
+    /**
+     * @brief Get the number of found point slots per row of the store
+     * @return Number of found point slots
+     */
+    size_t PointsPerRow() const { return m_pointsPerRow; }
+
+private:
+    const char *m_data;
+    size_t m_dataSize;
+#ifdef _WIN32
+    void *m_fileHandle;
+    void *m_mapHandle;
+#else
+    int m_fileDesc;
+#endif
+    size_t m_pointsPerRow;
+    size_t m_rowCount;
+    std::vector< ResultStoreBlockIndex > m_index;
+};
+
+} // namespace gc
+
+#endif // RESULTSTORE_H
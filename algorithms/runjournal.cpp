@@ -0,0 +1,356 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+   Copyright 2021 Kenneth W. Chapman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include "log.h"
+#include "runjournal.h"
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <boost/filesystem.hpp>
+#include <boost/exception/diagnostic_information.hpp>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace std;
+using namespace boost;
+namespace fs = boost::filesystem;
+
+static const std::string RUN_JOURNAL_MAGIC = "grime2 run journal";
+
+namespace gc
+{
+
+RunJournal::RunJournal() :
+    m_file( nullptr ),
+    m_csvBytes( -1 )
+{
+}
+RunJournal::~RunJournal()
+{
+    Close();
+}
+GC_STATUS RunJournal::Open( const string journalFilepath, const string paramsKey )
+{
+    GC_STATUS retVal = Close();
+    try
+    {
+        m_done.clear();
+        m_pending.clear();
+        m_csvBytes = -1;
+        m_filepath = journalFilepath;
+
+        if ( !fs::exists( journalFilepath ) || 0 == fs::file_size( journalFilepath ) )
+        {
+            m_file = fopen( journalFilepath.c_str(), "wb" );
+            if ( nullptr == m_file )
+            {
+                FILE_LOG( logERROR ) << "[RunJournal::Open] Could not create " << journalFilepath;
+                retVal = GC_ERR;
+            }
+            else
+            {
+                stringstream header;
+                header << RUN_JOURNAL_MAGIC << '\t' << RUN_JOURNAL_VERSION << '\n' << "params\t" << Clean( paramsKey ) << '\n';
+                string text = header.str();
+                if ( text.size() != fwrite( text.c_str(), 1, text.size(), m_file ) || 0 != fflush( m_file ) )
+                {
+                    FILE_LOG( logERROR ) << "[RunJournal::Open] Could not write header to " << journalFilepath;
+                    retVal = GC_ERR;
+                }
+            }
+        }
+        else
+        {
+            long long committedBytes = 0;
+            retVal = Load( Clean( paramsKey ), committedBytes );
+            if ( GC_OK == retVal )
+            {
+                // records after the last commit belong to images whose csv rows may not have been written
+                if ( static_cast< uintmax_t >( committedBytes ) < fs::file_size( journalFilepath ) )
+                {
+                    FILE_LOG( logWARNING ) << "[RunJournal::Open] Dropping uncommitted records of " << journalFilepath;
+                    fs::resize_file( journalFilepath, static_cast< uintmax_t >( committedBytes ) );
+                }
+                m_file = fopen( journalFilepath.c_str(), "ab" );
+                if ( nullptr == m_file )
+                {
+                    FILE_LOG( logERROR ) << "[RunJournal::Open] Could not open to append " << journalFilepath;
+                    retVal = GC_ERR;
+                }
+            }
+        }
+
+        if ( GC_OK != retVal )
+        {
+            if ( nullptr != m_file )
+            {
+                fclose( m_file );
+                m_file = nullptr;
+            }
+            m_done.clear();
+            m_csvBytes = -1;
+        }
+    }
+    catch( boost::exception &e )
+    {
+        FILE_LOG( logERROR ) << "[RunJournal::Open] " << diagnostic_information( e );
+        retVal = GC_EXCEPT;
+    }
+    catch( std::exception &e )
+    {
+        FILE_LOG( logERROR ) << "[RunJournal::Open] " << e.what();
+        retVal = GC_EXCEPT;
+    }
+
+    return retVal;
+}
+GC_STATUS RunJournal::Close()
+{
+    GC_STATUS retVal = GC_OK;
+    if ( nullptr != m_file )
+    {
+        if ( !m_pending.empty() )
+        {
+            FILE_LOG( logWARNING ) << "[RunJournal::Close] " << m_pending.size() << " uncommitted images not recorded in " << m_filepath;
+            m_pending.clear();
+        }
+        if ( 0 != fclose( m_file ) )
+        {
+            FILE_LOG( logERROR ) << "[RunJournal::Close] Could not close " << m_filepath;
+            retVal = GC_ERR;
+        }
+        m_file = nullptr;
+    }
+    return retVal;
+}
+bool RunJournal::IsDone( const string &imagePath, RunJournalEntry *entry ) const
+{
+    bool isDone = false;
+    auto found = m_done.find( imagePath );
+    if ( m_done.end() != found )
+    {
+        uintmax_t fileSize;
+        time_t modTime;
+        isDone = ImageKey( imagePath, fileSize, modTime ) &&
+                 fileSize == found->second.fileSize && modTime == found->second.modTime;
+        if ( isDone && nullptr != entry )
+            *entry = found->second;
+    }
+    return isDone;
+}
+GC_STATUS RunJournal::Add( const string &imagePath, const GC_STATUS status, const string &result )
+{
+    GC_STATUS retVal = GC_OK;
+    if ( nullptr == m_file )
+    {
+        FILE_LOG( logERROR ) << "[RunJournal::Add] Journal not open";
+        retVal = GC_ERR;
+    }
+    else
+    {
+        try
+        {
+            RunJournalEntry entry;
+            if ( !ImageKey( imagePath, entry.fileSize, entry.modTime ) )
+            {
+                FILE_LOG( logWARNING ) << "[RunJournal::Add] Could not read the size and time of " << imagePath;
+            }
+            entry.imagePath = imagePath;
+            entry.status = status;
+            entry.result = Clean( result );
+            m_pending.push_back( entry );
+        }
+        catch( std::exception &e )
+        {
+            FILE_LOG( logERROR ) << "[RunJournal::Add] " << e.what();
+            retVal = GC_EXCEPT;
+        }
+    }
+    return retVal;
+}
+GC_STATUS RunJournal::Commit( const long long csvBytes )
+{
+    GC_STATUS retVal = GC_OK;
+    if ( nullptr == m_file )
+    {
+        FILE_LOG( logERROR ) << "[RunJournal::Commit] Journal not open";
+        retVal = GC_ERR;
+    }
+    else
+    {
+        try
+        {
+            stringstream records;
+            for ( size_t i = 0; i < m_pending.size(); ++i )
+            {
+                const RunJournalEntry &entry = m_pending[ i ];
+                records << "image\t" << entry.fileSize << '\t' << static_cast< long long >( entry.modTime ) << '\t'
+                        << static_cast< int >( entry.status ) << '\t' << Clean( entry.imagePath ) << '\t' << entry.result << '\n';
+            }
+            records << "commit\t" << csvBytes << '\n';
+
+            // the records and their commit line are synced together, a partial write is dropped by the next Open()
+            string text = records.str();
+            if ( text.size() != fwrite( text.c_str(), 1, text.size(), m_file ) || 0 != fflush( m_file ) )
+            {
+                FILE_LOG( logERROR ) << "[RunJournal::Commit] Could not write to " << m_filepath;
+                retVal = GC_ERR;
+            }
+            else
+            {
+#ifdef _WIN32
+                int ret = _commit( _fileno( m_file ) );
+#else
+                int ret = fsync( fileno( m_file ) );
+#endif
+                if ( 0 != ret )
+                {
+                    FILE_LOG( logERROR ) << "[RunJournal::Commit] Could not sync " << m_filepath;
+                    retVal = GC_ERR;
+                }
+                for ( size_t i = 0; i < m_pending.size(); ++i )
+                    m_done[ m_pending[ i ].imagePath ] = m_pending[ i ];
+                m_pending.clear();
+                m_csvBytes = csvBytes;
+            }
+        }
+        catch( std::exception &e )
+        {
+            FILE_LOG( logERROR ) << "[RunJournal::Commit] " << e.what();
+            retVal = GC_EXCEPT;
+        }
+    }
+    return retVal;
+}
+string RunJournal::ParamsKey( const FindLineParams &params )
+{
+    stringstream key;
+    key << "calib=" << params.calibFilepath;
+    uintmax_t fileSize = 0;
+    time_t modTime = 0;
+    if ( ImageKey( params.calibFilepath, fileSize, modTime ) )
+        key << " calib_size=" << fileSize << " calib_time=" << static_cast< long long >( modTime );
+    key << " timestamp_type=" << static_cast< int >( params.timeStampType )
+        << " timestamp_pos=" << params.timeStampStartPos
+        << " timestamp_format=" << params.timeStampFormat
+        << " csv=" << params.resultCSVPath;
+    return key.str();
+}
+GC_STATUS RunJournal::Load( const string &paramsKey, long long &committedBytes )
+{
+    GC_STATUS retVal = GC_OK;
+
+    ifstream file( m_filepath, ios::in | ios::binary );
+    stringstream contents;
+    contents << file.rdbuf();
+    string text = contents.str();
+
+    // the parse stops at the first line that is incomplete or malformed, everything from there on is uncommitted
+    vector< RunJournalEntry > pending;
+    string line, field;
+    size_t lineNum = 0;
+    size_t pos = 0;
+    for ( size_t end = text.find( '\n' ); string::npos != end; pos = end + 1, end = text.find( '\n', pos ) )
+    {
+        line = text.substr( pos, end - pos );
+        if ( 0 == lineNum )
+        {
+            stringstream expected;
+            expected << RUN_JOURNAL_MAGIC << '\t' << RUN_JOURNAL_VERSION;
+            if ( expected.str() != line )
+            {
+                FILE_LOG( logERROR ) << "[RunJournal::Load] " << m_filepath << " is not a version " << RUN_JOURNAL_VERSION << " run journal";
+                retVal = GC_ERR;
+                break;
+            }
+        }
+        else if ( 1 == lineNum )
+        {
+            if ( "params\t" + paramsKey != line )
+            {
+                FILE_LOG( logERROR ) << "[RunJournal::Load] " << m_filepath << " was written by a run with other parameters, "
+                                        "remove it to start the run over: " << line.substr( std::min( line.size(), static_cast< size_t >( 7 ) ) );
+                retVal = GC_ERR;
+                break;
+            }
+            committedBytes = static_cast< long long >( end + 1 );
+        }
+        else
+        {
+            vector< string > fields;
+            stringstream lineStream( line );
+            while ( 5 > fields.size() && getline( lineStream, field, '\t' ) )
+                fields.push_back( field );
+            if ( getline( lineStream, field ) )
+                fields.push_back( field );
+
+            if ( 2 == fields.size() && "commit" == fields[ 0 ] )
+            {
+                for ( size_t i = 0; i < pending.size(); ++i )
+                    m_done[ pending[ i ].imagePath ] = pending[ i ];
+                pending.clear();
+                m_csvBytes = strtoll( fields[ 1 ].c_str(), nullptr, 10 );
+                committedBytes = static_cast< long long >( end + 1 );
+            }
+            else if ( 5 <= fields.size() && "image" == fields[ 0 ] )
+            {
+                RunJournalEntry entry;
+                entry.fileSize = static_cast< uintmax_t >( strtoull( fields[ 1 ].c_str(), nullptr, 10 ) );
+                entry.modTime = static_cast< time_t >( strtoll( fields[ 2 ].c_str(), nullptr, 10 ) );
+                entry.status = static_cast< GC_STATUS >( atoi( fields[ 3 ].c_str() ) );
+                entry.imagePath = fields[ 4 ];
+                if ( 6 == fields.size() )
+                    entry.result = fields[ 5 ];
+                pending.push_back( entry );
+            }
+            else
+            {
+                break;
+            }
+        }
+        ++lineNum;
+    }
+    if ( GC_OK == retVal && 2 > lineNum )
+    {
+        FILE_LOG( logERROR ) << "[RunJournal::Load] " << m_filepath << " has no run journal header";
+        retVal = GC_ERR;
+    }
+
+    return retVal;
+}
+bool RunJournal::ImageKey( const string &imagePath, uintmax_t &fileSize, time_t &modTime )
+{
+    boost::system::error_code ec;
+    fileSize = fs::file_size( imagePath, ec );
+    if ( !ec )
+        modTime = fs::last_write_time( imagePath, ec );
+    return !ec;
+}
+string RunJournal::Clean( const string &text )
+{
+    string cleaned = text;
+    for ( size_t i = 0; i < cleaned.size(); ++i )
+    {
+        if ( '\t' == cleaned[ i ] || '\n' == cleaned[ i ] || '\r' == cleaned[ i ] )
+            cleaned[ i ] = ' ';
+    }
+    return cleaned;
+}
+
+} // namespace gc
@@ -0,0 +1,181 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+   Copyright 2021 Kenneth W. Chapman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/** \file runjournal.h
+ * @brief A class to record the progress of a folder run so an interrupted run can be resumed
+ *
+ * This file holds an append only journal of the images a folder run has finished. Restarting a
+ * run with the same journal and parameters skips the images already done and truncates the csv
+ * result file to the rows the journal vouches for, so only new rows are appended.
+ *
+ * \author Kenneth W. Chapman
+ * \copyright Copyright (C) 2010-2021, Kenneth W. Chapman <coffeesig@gmail.com>, all rights reserved.\n
+ * This project is released under the Apache License, Version 2.0.
+ * \bug No known bugs.
+ */
+
+#ifndef RUNJOURNAL_H
+#define RUNJOURNAL_H
+
+#include "gc_types.h"
+#include <ctime>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace gc
+{
+
+static const size_t RUN_JOURNAL_DEFAULT_COMMIT_ROWS = 100;     ///< Default number of images between journal commits
+static const int RUN_JOURNAL_VERSION = 1;                      ///< Version of the journal file format
+
+/**
+ * @brief An image recorded as done in a run journal
+ */
+class RunJournalEntry
+{
+public:
+    /**
+     * @brief Constructor
+     */
+    RunJournalEntry() :
+        fileSize( 0 ),
+        modTime( 0 ),
+        status( GC_OK )
+    {}
+
+    std::string imagePath;      ///< Filepath of the image
+    uintmax_t fileSize;         ///< Size of the image file when it was processed
+    time_t modTime;             ///< Modification time of the image file when it was processed
+    GC_STATUS status;           ///< Return status of the processing of the image
+    std::string result;         ///< Result row of the image (e.g. its csv row), may be empty
+};
+
+/**
+ * @brief Append only journal of the images finished by a folder run
+ *
+ * Images are keyed by filepath, file size and modification time, so an image that is replaced
+ * is processed again. Finished images are added to the journal in memory and written to it by
+ * Commit(), which also records the size of the csv result file at that point. The caller flushes
+ * the csv file before each commit, so every committed image has its row in the csv file. On
+ * Open() records after the last commit are dropped, and the caller truncates the csv file to the
+ * committed size so rows written after the last commit are neither lost nor duplicated.
+ */
+class RunJournal
+{
+public:
+    /**
+     * @brief Constructor
+     */
+    RunJournal();
+
+    /**
+     * @brief Destructor, closes the journal (images added since the last commit are not recorded)
+     */
+    ~RunJournal();
+
+    RunJournal( const RunJournal & ) = delete;
+    RunJournal &operator=( const RunJournal & ) = delete;
+
+    /**
+     * @brief Opens a journal, creating it if it does not exist, and loads its committed images
+     * @param journalFilepath Filepath of the journal
+     * @param paramsKey Parameters of the run (see ParamsKey()), must match those the journal was created with
+     * @return GC_OK=Success, GC_ERR=Failure or parameter mismatch, GC_EXCEPT=Exception thrown
+     */
+    GC_STATUS Open( const std::string journalFilepath, const std::string paramsKey );
+
+    /**
+     * @brief Closes the journal, images added since the last commit are not recorded
+     * @return GC_OK=Success, GC_FAIL=Failure, GC_EXCEPT=Exception thrown
+     */
+    GC_STATUS Close();
+
+    /**
+     * @brief Get whether a journal is open
+     * @return true=A journal is open, false=No journal is open
+     */
+    bool IsOpen() const { return nullptr != m_file; }
+
+    /**
+     * @brief Get whether an image was committed as done and has not changed since
+     * @param imagePath Filepath of the image
+     * @param entry Optional pointer to receive the journal entry of the image
+     * @return true=The image is done, false=The image has to be processed
+     */
+    bool IsDone( const std::string &imagePath, RunJournalEntry *entry = nullptr ) const;
+
+    /**
+     * @brief Adds a finished image to the journal, it is recorded by the next Commit()
+     * @param imagePath Filepath of the image
+     * @param status Return status of the processing of the image
+     * @param result Result row of the image (must not hold line endings)
+     * @return GC_OK=Success, GC_FAIL=Failure, GC_EXCEPT=Exception thrown
+     */
+    GC_STATUS Add( const std::string &imagePath, const GC_STATUS status, const std::string &result );
+
+    /**
+     * @brief Writes the images added since the last commit to the journal and syncs it to disk
+     * @param csvBytes Size of the csv result file after its rows for the added images were flushed, -1 if there is none
+     * @return GC_OK=Success, GC_FAIL=Failure, GC_EXCEPT=Exception thrown
+     */
+    GC_STATUS Commit( const long long csvBytes );
+
+    /**
+     * @brief Get the size of the csv result file at the last commit
+     * @return Size in bytes, -1 if nothing has been committed or there was no csv file
+     */
+    long long CommittedCSVBytes() const { return m_csvBytes; }
+
+    /**
+     * @brief Get the number of images committed as done
+     * @return Number of images
+     */
+    size_t DoneCount() const { return m_done.size(); }
+
+    /**
+     * @brief Get the number of images added since the last commit
+     * @return Number of images
+     */
+    size_t PendingCount() const { return m_pending.size(); }
+
+    /**
+     * @brief Builds the key of the find line parameters that change the results of a run
+     *
+     * The key holds the calibration filepath with the size and modification time of the file, the
+     * timestamp settings and the csv result filepath.
+     *
+     * @param params Find line parameters of the run
+     * @return Parameter key
+     */
+    static std::string ParamsKey( const FindLineParams &params );
+
+private:
+    FILE *m_file;
+    std::string m_filepath;
+    long long m_csvBytes;
+    std::vector< RunJournalEntry > m_pending;
+    std::unordered_map< std::string, RunJournalEntry > m_done;
+
+    GC_STATUS Load( const std::string &paramsKey, long long &committedBytes );
+    static bool ImageKey( const std::string &imagePath, uintmax_t &fileSize, time_t &modTime );
+    static std::string Clean( const std::string &text );
+};
+
+} // namespace gc
+
+#endif // RUNJOURNAL_H
@@ -0,0 +1,269 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+   Copyright 2021 Kenneth W. Chapman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include "log.h"
+#include "templatematchdft.h"
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+#include <opencv2/imgproc.hpp>
+
+using namespace cv;
+using namespace std;
+
+namespace gc
+{
+
+GC_STATUS TemplateMatchDFT::SetTemplates( const vector< Mat > &templates )
+{
+    GC_STATUS retVal = GC_OK;
+    if ( templates.empty() )
+    {
+        FILE_LOG( logERROR ) << "[TemplateMatchDFT::SetTemplates] No templates to set";
+        retVal = GC_ERR;
+    }
+    else
+    {
+        try
+        {
+            m_templates.clear();
+            m_templateSums.clear();
+            m_templateSqSums.clear();
+            {
+                lock_guard< mutex > lock( m_spectraMutex );
+                m_spectraCache.clear();
+            }
+
+            for ( size_t i = 0; i < templates.size(); ++i )
+            {
+                if ( templates[ i ].empty() || CV_8UC1 != templates[ i ].type() )
+                {
+                    FILE_LOG( logERROR ) << "[TemplateMatchDFT::SetTemplates] Template " << i << " is empty or not 8-bit gray";
+                    retVal = GC_ERR;
+                    break;
+                }
+                m_templateSums.push_back( cv::sum( templates[ i ] )[ 0 ] );
+                m_templateSqSums.push_back( templates[ i ].dot( templates[ i ] ) );
+                m_templates.push_back( templates[ i ].clone() );
+            }
+            if ( GC_OK != retVal )
+            {
+                m_templates.clear();
+                m_templateSums.clear();
+                m_templateSqSums.clear();
+            }
+        }
+        catch( Exception &e )
+        {
+            FILE_LOG( logERROR ) << "[TemplateMatchDFT::SetTemplates] " << e.what();
+            retVal = GC_EXCEPT;
+        }
+    }
+    return retVal;
+}
+GC_STATUS TemplateMatchDFT::SetImage( const Mat &img, DFTSearchImage &searchImg ) const
+{
+    GC_STATUS retVal = GC_OK;
+    if ( m_templates.empty() )
+    {
+        FILE_LOG( logERROR ) << "[TemplateMatchDFT::SetImage] Templates not set";
+        retVal = GC_ERR;
+    }
+    else if ( img.empty() || CV_8UC1 != img.type() )
+    {
+        FILE_LOG( logERROR ) << "[TemplateMatchDFT::SetImage] Image is empty or not 8-bit gray";
+        retVal = GC_ERR;
+    }
+    else
+    {
+        try
+        {
+            for ( size_t i = 0; i < m_templates.size(); ++i )
+            {
+                if ( m_templates[ i ].cols > img.cols || m_templates[ i ].rows > img.rows )
+                {
+                    FILE_LOG( logERROR ) << "[TemplateMatchDFT::SetImage] Template " << i << " is larger than the search image";
+                    retVal = GC_ERR;
+                    break;
+                }
+            }
+            if ( GC_OK == retVal )
+            {
+                Size dftSize( getOptimalDFTSize( img.cols ), getOptimalDFTSize( img.rows ) );
+                retVal = GetTemplateSpectra( dftSize, searchImg.templateSpectra );
+                if ( GC_OK == retVal )
+                {
+                    searchImg.imgSize = img.size();
+                    integral( img, searchImg.sum, searchImg.sqSum, CV_64F, CV_64F );
+
+                    // the image mean is removed to keep the float spectrum precise, the templates are zero mean
+                    // so the correlation of every full overlap position is unchanged
+                    Mat matPadded = Mat::zeros( dftSize, CV_32FC1 );
+                    Mat matPaddedROI = matPadded( Rect( 0, 0, img.cols, img.rows ) );
+                    img.convertTo( matPaddedROI, CV_32F, 1.0, -mean( img )[ 0 ] );
+                    dft( matPadded, searchImg.spectrum, 0, img.rows );
+                }
+            }
+        }
+        catch( Exception &e )
+        {
+            FILE_LOG( logERROR ) << "[TemplateMatchDFT::SetImage] " << e.what();
+            retVal = GC_EXCEPT;
+        }
+    }
+    if ( GC_OK != retVal )
+    {
+        searchImg = DFTSearchImage();
+    }
+    return retVal;
+}
+GC_STATUS TemplateMatchDFT::Match( const DFTSearchImage &searchImg, const size_t index, const int method, Mat &matchSpace ) const
+{
+    GC_STATUS retVal = GC_OK;
+    if ( m_templates.size() <= index )
+    {
+        FILE_LOG( logERROR ) << "[TemplateMatchDFT::Match] Invalid template index=" << index;
+        retVal = GC_ERR;
+    }
+    else if ( TM_CCORR_NORMED != method && TM_CCOEFF_NORMED != method )
+    {
+        FILE_LOG( logERROR ) << "[TemplateMatchDFT::Match] Only TM_CCORR_NORMED and TM_CCOEFF_NORMED are supported";
+        retVal = GC_ERR;
+    }
+    else if ( searchImg.spectrum.empty() || nullptr == searchImg.templateSpectra ||
+              searchImg.templateSpectra->size() != m_templates.size() )
+    {
+        FILE_LOG( logERROR ) << "[TemplateMatchDFT::Match] No image set to search";
+        retVal = GC_ERR;
+    }
+    else
+    {
+        try
+        {
+            const Mat &matTemplate = m_templates[ index ];
+            Size matchSize( searchImg.imgSize.width - matTemplate.cols + 1, searchImg.imgSize.height - matTemplate.rows + 1 );
+
+            bool isCoeff = TM_CCOEFF_NORMED == method;
+            double area = static_cast< double >( matTemplate.total() );
+            double templMean = m_templateSums[ index ] / area;
+            double templNorm = m_templateSqSums[ index ];
+            if ( isCoeff )
+                templNorm -= m_templateSums[ index ] * templMean;
+            templNorm = sqrt( std::max( templNorm, 0.0 ) );
+
+            // cv::matchTemplate() scores every position of a flat template as a perfect match
+            if ( isCoeff && DBL_EPSILON > templNorm )
+            {
+                matchSpace.create( matchSize, CV_32FC1 );
+                matchSpace.setTo( 1.0 );
+            }
+            else
+            {
+                Mat corrSpectrum, corr;
+                mulSpectrums( searchImg.spectrum, ( *searchImg.templateSpectra )[ index ], corrSpectrum, 0, true );
+                idft( corrSpectrum, corr, DFT_REAL_OUTPUT | DFT_SCALE, matchSize.height );
+
+                // normalize as cv::matchTemplate() does, corr holds the correlation with the zero mean template
+                double num, wndSum, wndSum2, diff2, t;
+                matchSpace.create( matchSize, CV_32FC1 );
+                for ( int row = 0; row < matchSize.height; ++row )
+                {
+                    const double *pSumTop = searchImg.sum.ptr< double >( row );
+                    const double *pSumBot = searchImg.sum.ptr< double >( row + matTemplate.rows );
+                    const double *pSqSumTop = searchImg.sqSum.ptr< double >( row );
+                    const double *pSqSumBot = searchImg.sqSum.ptr< double >( row + matTemplate.rows );
+                    const float *pCorr = corr.ptr< float >( row );
+                    float *pMatch = matchSpace.ptr< float >( row );
+                    for ( int col = 0; col < matchSize.width; ++col )
+                    {
+                        wndSum = pSumBot[ col + matTemplate.cols ] - pSumBot[ col ] - pSumTop[ col + matTemplate.cols ] + pSumTop[ col ];
+                        wndSum2 = pSqSumBot[ col + matTemplate.cols ] - pSqSumBot[ col ] - pSqSumTop[ col + matTemplate.cols ] + pSqSumTop[ col ];
+                        num = static_cast< double >( pCorr[ col ] );
+                        if ( isCoeff )
+                        {
+                            diff2 = std::max( wndSum2 - wndSum * wndSum / area, 0.0 );
+                        }
+                        else
+                        {
+                            num += templMean * wndSum;
+                            diff2 = std::max( wndSum2, 0.0 );
+                        }
+
+                        t = diff2 <= std::min( 0.5, 10.0 * FLT_EPSILON * wndSum2 ) ? 0.0 : sqrt( diff2 ) * templNorm;
+                        if ( fabs( num ) < t )
+                            num /= t;
+                        else if ( fabs( num ) < t * 1.125 )
+                            num = 0.0 < num ? 1.0 : -1.0;
+                        else
+                            num = 0.0;
+                        pMatch[ col ] = static_cast< float >( num );
+                    }
+                }
+            }
+        }
+        catch( Exception &e )
+        {
+            FILE_LOG( logERROR ) << "[TemplateMatchDFT::Match] " << e.what();
+            retVal = GC_EXCEPT;
+        }
+    }
+    return retVal;
+}
+GC_STATUS TemplateMatchDFT::GetTemplateSpectra( const Size dftSize, shared_ptr< const vector< Mat > > &spectra ) const
+{
+    GC_STATUS retVal = GC_OK;
+    try
+    {
+        // the spectra are calculated under the lock, so threads that search images of a new size
+        // at the same time calculate them once
+        lock_guard< mutex > lock( m_spectraMutex );
+        auto found = find_if( m_spectraCache.begin(), m_spectraCache.end(),
+                              [ &dftSize ]( const pair< Size, shared_ptr< const vector< Mat > > > &item )
+        {
+            return dftSize == item.first;
+        } );
+        if ( m_spectraCache.end() != found )
+        {
+            // most recently used sizes are kept at the front
+            m_spectraCache.splice( m_spectraCache.begin(), m_spectraCache, found );
+        }
+        else
+        {
+            shared_ptr< vector< Mat > > spectraNew = make_shared< vector< Mat > >();
+            for ( size_t i = 0; i < m_templates.size(); ++i )
+            {
+                Mat matPadded = Mat::zeros( dftSize, CV_32FC1 );
+                Mat matPaddedROI = matPadded( Rect( 0, 0, m_templates[ i ].cols, m_templates[ i ].rows ) );
+                m_templates[ i ].convertTo( matPaddedROI, CV_32F, 1.0, -m_templateSums[ i ] / static_cast< double >( m_templates[ i ].total() ) );
+                spectraNew->push_back( Mat() );
+                dft( matPadded, spectraNew->back(), 0, m_templates[ i ].rows );
+            }
+
+            m_spectraCache.push_front( make_pair( dftSize, shared_ptr< const vector< Mat > >( spectraNew ) ) );
+            while ( DFT_SPECTRA_CACHE_SIZE < m_spectraCache.size() )
+                m_spectraCache.pop_back();
+        }
+        spectra = m_spectraCache.front().second;
+    }
+    catch( Exception &e )
+    {
+        FILE_LOG( logERROR ) << "[TemplateMatchDFT::GetTemplateSpectra] " << e.what();
+        retVal = GC_EXCEPT;
+    }
+    return retVal;
+}
+
+} // namespace gc
@@ -0,0 +1,132 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+   Copyright 2021 Kenneth W. Chapman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/** \file templatematchdft.h
+ * @brief A class to match a fixed set of templates against images in the frequency domain
+ *
+ * This file holds a template matching engine that caches the spectra of a set of
+ * templates at the size of the images to be searched. The spectrum of each searched
+ * image is calculated once and reused for every template of the set.
+ *
+ * \author Kenneth W. Chapman
+ * \copyright Copyright (C) 2010-2021, Kenneth W. Chapman <coffeesig@gmail.com>, all rights reserved.\n
+ * This project is released under the Apache License, Version 2.0.
+ * \bug No known bugs.
+ */
+
+#ifndef TEMPLATEMATCHDFT_H
+#define TEMPLATEMATCHDFT_H
+
+#include "gc_types.h"
+#include <list>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <opencv2/core.hpp>
+
+namespace gc
+{
+
+static const size_t DFT_SPECTRA_CACHE_SIZE = 4;     /**< Number of DFT sizes for which the template spectra are kept */
+
+/**
+ * @brief Data class that holds the spectrum and window sums of one image to be searched
+ *
+ * It is filled by TemplateMatchDFT::SetImage() and is owned by the caller, so several
+ * images may be searched at once with the same engine.
+ */
+class DFTSearchImage
+{
+public:
+    /**
+     * @brief Constructor
+     */
+    DFTSearchImage() {}
+
+    cv::Size imgSize;       /**< Size of the searched image */
+    cv::Mat spectrum;       /**< Spectrum of the zero mean image at the DFT size */
+    cv::Mat sum;            /**< Integral image of the image */
+    cv::Mat sqSum;          /**< Integral image of the squared image */
+    std::shared_ptr< const std::vector< cv::Mat > > templateSpectra; /**< Template spectra at the DFT size */
+};
+
+/**
+ * @brief Template matching by DFT correlation with cached template spectra
+ *
+ * Produces the same match spaces as cv::matchTemplate() for the TM_CCORR_NORMED and
+ * TM_CCOEFF_NORMED methods. The template spectra are calculated the first time an image
+ * of a given DFT size is set and are kept for the last DFT_SPECTRA_CACHE_SIZE sizes.
+ * SetImage() and Match() may be called from several threads at once, SetTemplates()
+ * may not.
+ */
+class TemplateMatchDFT
+{
+public:
+    /**
+     * @brief Constructor
+     */
+    TemplateMatchDFT() {}
+
+    /**
+     * @brief Destructor
+     */
+    ~TemplateMatchDFT() {}
+
+    /**
+     * @brief Sets the 8-bit, single channel templates to be matched (discards cached spectra)
+     * @param templates Vector of templates to be matched
+     * @return GC_OK=Success, GC_FAIL=Failure, GC_EXCEPT=Exception thrown
+     */
+    GC_STATUS SetTemplates( const std::vector< cv::Mat > &templates );
+
+    /**
+     * @brief Calculates the spectrum of an 8-bit, single channel image to be searched by Match()
+     * @param img Image to be searched (must be at least as large as every template)
+     * @param searchImg Spectrum and window sums of the image
+     * @return GC_OK=Success, GC_FAIL=Failure, GC_EXCEPT=Exception thrown
+     */
+    GC_STATUS SetImage( const cv::Mat &img, DFTSearchImage &searchImg ) const;
+
+    /**
+     * @brief Matches a template against an image set with SetImage()
+     * @param searchImg Spectrum and window sums of the image to search
+     * @param index Index of the template to match
+     * @param method cv::TM_CCORR_NORMED or cv::TM_CCOEFF_NORMED
+     * @param matchSpace CV_32FC1 match space of the same size and values as cv::matchTemplate() creates
+     * @return GC_OK=Success, GC_FAIL=Failure, GC_EXCEPT=Exception thrown
+     */
+    GC_STATUS Match( const DFTSearchImage &searchImg, const size_t index, const int method, cv::Mat &matchSpace ) const;
+
+    /**
+     * @brief Get the number of templates set
+     * @return Number of templates
+     */
+    size_t TemplateCount() const { return m_templates.size(); }
+
+private:
+    std::vector< cv::Mat > m_templates;
+    std::vector< double > m_templateSums;
+    std::vector< double > m_templateSqSums;
+
+    mutable std::mutex m_spectraMutex;
+    mutable std::list< std::pair< cv::Size, std::shared_ptr< const std::vector< cv::Mat > > > > m_spectraCache;
+
+    GC_STATUS GetTemplateSpectra( const cv::Size dftSize, std::shared_ptr< const std::vector< cv::Mat > > &spectra ) const;
+};
+
+} // namespace gc
+
+#endif // TEMPLATEMATCHDFT_H
@@ -182,6 +182,38 @@ public:
         return std::string( buf );
     }
 
+    /**
+     * @brief Converts an ISO format timestamp string (as created by GetTimestampFromString()) to
+     * the number of seconds from the epoch, the timestamp is taken to be UTC
+     *
+     * @param isoTimestamp Timestamp string in the format yyyy-mm-ddTHH:MM:SS
+     * @param secsFromEpoch Variable to hold the calculated number of seconds from the epoch
+     * @return GC_OK=Success, GC_FAIL=Failure, GC_EXCEPT=Exception thrown
+     */
+    static GC_STATUS ISOTimestampToSeconds( const std::string isoTimestamp, long long &secsFromEpoch )
+    {
+        GC_STATUS retVal = GC_OK;
+        int year, month, day, hour, minute, second;
+        if ( 6 != sscanf( isoTimestamp.c_str(), "%d-%d-%dT%d:%d:%d", &year, &month, &day, &hour, &minute, &second ) ||
+             1 > month || 12 < month || 1 > day || 31 < day )
+        {
+            FILE_LOG( logERROR ) << "[GcTimestampConvert::ISOTimestampToSeconds] Invalid timestamp: " << isoTimestamp;
+            retVal = GC_ERR;
+        }
+        else
+        {
+            // days from 1970-01-01 of the proleptic Gregorian date (years start in March to put leap days last)
+            long long yearAdj = month <= 2 ? year - 1 : year;
+            long long era = ( 0 <= yearAdj ? yearAdj : yearAdj - 399 ) / 400;
+            long long yearOfEra = yearAdj - era * 400;
+            long long dayOfYear = ( 153 * ( month + ( 2 < month ? -3 : 9 ) ) + 2 ) / 5 + day - 1;
+            long long dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+            long long days = era * 146097 + dayOfEra - 719468;
+            secsFromEpoch = days * 86400 + hour * 3600 + minute * 60 + second;
+        }
+        return retVal;
+    }
+
 private:
     static int CalcDayOfYear( const GcTimestamp gcStamp )
     {
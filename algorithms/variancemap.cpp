@@ -16,6 +16,7 @@
 
 #include "log.h"
 #include "variancemap.h"
+#include <climits>
 #include <opencv2/imgproc/imgproc.hpp>
 
 namespace gc
@@ -30,8 +31,10 @@ GC_STATUS VarianceMap::Compute( const cv::Mat &image )
     GC_STATUS retVal = GC_OK;
     try
     {
-        image.copyTo( m_image );
-        cv::integral( m_image, m_integral, m_sq_integral );
+        // 32-bit integral sums are used only when the sum of the whole image fits in an int, so
+        // they never overflow and their window differences are exact
+        int sumDepth = 255.0 * static_cast< double >( image.total() ) > static_cast< double >( INT_MAX ) ? CV_64F : CV_32S;
+        cv::integral( image, m_integral, m_sq_integral, sumDepth, CV_64F );
     }
     catch( cv::Exception &e )
     {
@@ -41,35 +44,36 @@ GC_STATUS VarianceMap::Compute( const cv::Mat &image )
     return retVal;
 }
 
-float VarianceMap::CalcMean( cv::Rect r )
+template< typename SUM_TYPE >
+void VarianceMap::CalcVarianceRows( const cv::Range &rows, const int kernelSize, const cv::Mat &mask )
 {
-    int width = m_integral.cols;
-    // int height=_integral.rows;
-    unsigned int *ii1 = reinterpret_cast< unsigned int * >( m_integral.data );
-    int a = r.x + ( r.y * ( width ) );
-    int b = ( r.x + r.width ) + ( r.y * ( width ) );
-    int c = r.x + ( ( r.y + r.height ) * ( width ) );
-    int d = ( r.x + r.width ) + ( r.y + r.height ) * ( width );
-    float mx = static_cast< float >( ii1[ a ] + ii1[ d ] - ii1[ b ] - ii1[ c ] );
-    mx = mx / static_cast< float >( r.width * r.height );
-    return mx;
-}
+    const int kernSizeHalf = kernelSize >> 1;
+    const int cols = m_matVariance_32F.cols - 2 * kernSizeHalf;
+    const double invArea = 1.0 / static_cast< double >( kernelSize * kernelSize );
+    for ( int row = rows.start; row < rows.end; ++row )
+    {
+        // the kernel of output pixel (col + kernSizeHalf, row) spans integral rows top to bot and columns col to col + kernelSize
+        const SUM_TYPE *pSumTop = m_integral.ptr< SUM_TYPE >( row - kernSizeHalf );
+        const SUM_TYPE *pSumBot = m_integral.ptr< SUM_TYPE >( row - kernSizeHalf + kernelSize );
+        const double *pSqTop = m_sq_integral.ptr< double >( row - kernSizeHalf );
+        const double *pSqBot = m_sq_integral.ptr< double >( row - kernSizeHalf + kernelSize );
+        float *pVar = m_matVariance_32F.ptr< float >( row ) + kernSizeHalf;
+        const uchar *pMask = mask.empty() ? nullptr : mask.ptr< uchar >( row ) + kernSizeHalf;
 
-float VarianceMap::CalcVariance( cv::Rect r )
-{
-    int width = m_integral.cols;
-    // int height=_integral.rows;
-    int a = r.x + ( r.y * width );
-    int b = ( r.x + r.width ) + ( r.y * width );
-    int c = r.x + ( ( r.y + r.height ) * width );
-    int d = ( r.x + r.width ) + ( r.y + r.height ) * width;
-    float mx = CalcMean( r );
-    double *ii2 = reinterpret_cast< double * >( m_sq_integral.data );
-    // double *ii2 = ( double * )( _sq_integral.data );
-    float mx2 = static_cast< float >( ii2[ a ] + ii2[ d ] - ii2[ b ] - ii2[ c ] );
-    mx2 = mx2 / ( r.width * r.height );
-    mx2 = mx2 - ( mx * mx );
-    return mx2;
+        double mean, sq;
+        for ( int col = 0; col < cols; ++col )
+        {
+            mean = static_cast< double >( static_cast< SUM_TYPE >( pSumBot[ col + kernelSize ] - pSumBot[ col ] -
+                                                                   pSumTop[ col + kernelSize ] + pSumTop[ col ] ) ) * invArea;
+            sq = ( pSqBot[ col + kernelSize ] - pSqBot[ col ] - pSqTop[ col + kernelSize ] + pSqTop[ col ] ) * invArea;
+            pVar[ col ] = static_cast< float >( sq - mean * mean );
+        }
+        if ( nullptr != pMask )
+        {
+            for ( int col = 0; col < cols; ++col )
+                pVar[ col ] *= static_cast< float >( 0 != pMask[ col ] );
+        }
+    }
 }
 GC_STATUS VarianceMap::CreateMap( const cv::Mat &src, cv::Mat &dst, const int kernSize, double floatscale )
 {
@@ -82,7 +86,12 @@ GC_STATUS VarianceMap::CreateMap( const cv::Mat &src, cv::Mat &dst, const int ke
     GC_STATUS retVal = GC_OK;
     try
     {
-        if ( 3 > kernSize || src.rows < kernSize || src.cols < kernSize )
+        if ( src.empty() || CV_8UC1 != src.type() || ( !mask.empty() && ( CV_8UC1 != mask.type() || mask.size() != src.size() ) ) )
+        {
+            FILE_LOG( logERROR ) << "[CreateMap][" << __func__ << "] Image must be 8-bit gray with an optional 8-bit mask of the same size";
+            retVal = GC_ERR;
+        }
+        else if ( 3 > kernSize || src.rows < kernSize || src.cols < kernSize )
         {
             FILE_LOG( logERROR ) << "[CreateMap][" << __func__ << "] Invalid kernels size=" << kernSize << " (must be greater than 5, odd, and smaller than the image dimensions)";
             retVal = GC_ERR;
@@ -97,33 +106,15 @@ GC_STATUS VarianceMap::CreateMap( const cv::Mat &src, cv::Mat &dst, const int ke
                 m_matVariance_32F.create( src.size(), CV_32F );
                 m_matVariance_32F.setTo( 0.0 );
 
-                int col, row;
-                float *pPixf;
-                uchar *pPixMask = mask.data + kernSizeHalf * static_cast< int >( mask.step );
-                if ( mask.empty() )
-                {
-                    for ( row = kernSizeHalf; row < m_matVariance_32F.rows - kernSizeHalf; ++row )
-                    {
-                        pPixf = &m_matVariance_32F.at< float >( cv::Point( 0, row ) );
-                        for ( col = kernSizeHalf; col < m_matVariance_32F.cols - kernSizeHalf; ++col )
-                        {
-                            pPixf[ col ] = CalcVariance( cv::Rect( col - kernSizeHalf, row - kernSizeHalf, kernelSize, kernelSize ) );
-                        }
-                    }
-                }
-                else
+                // bands of rows are calculated in parallel, with the sum depth Compute() chose
+                bool isSum64 = CV_64F == m_integral.depth();
+                cv::parallel_for_( cv::Range( kernSizeHalf, m_matVariance_32F.rows - kernSizeHalf ), [ & ]( const cv::Range &range )
                 {
-                    for ( row = kernSizeHalf; row < m_matVariance_32F.rows - kernSizeHalf; ++row )
-                    {
-                        pPixf = &m_matVariance_32F.at< float >( cv::Point( 0, row ) );
-                        for ( col = kernSizeHalf; col < m_matVariance_32F.cols - kernSizeHalf; ++col )
-                        {
-                            if ( 0 != pPixMask[ col ] )
-                                pPixf[ col ] = CalcVariance( cv::Rect( col - kernSizeHalf, row - kernSizeHalf, kernelSize, kernelSize ) );
-                        }
-                        pPixMask += static_cast< int >( mask.step );
-                    }
-                }
+                    if ( isSum64 )
+                        CalcVarianceRows< double >( range, kernelSize, mask );
+                    else
+                        CalcVarianceRows< unsigned int >( range, kernelSize, mask );
+                } );
 
 				double dMin, dMax;
                 cv::minMaxIdx( m_matVariance_32F, &dMin, &dMax );
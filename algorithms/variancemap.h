@@ -31,19 +31,16 @@ public:
     GC_STATUS CreateMap( const cv::Mat &src, cv::Mat &dst, const int kernSize, const cv::Mat &mask, double floatscale = -1.0 );
 
 private:
-    cv::Mat m_image;
     cv::Mat m_integral;
     cv::Mat m_sq_integral;
     cv::Mat m_matVariance_32F;
 
-    //function to compute integral image
+    //function to compute integral image, 64-bit sums when the image could overflow 32-bit ones
     GC_STATUS Compute( const cv::Mat &image );
 
-    //function to compute mean value of a patch
-    float CalcMean( cv::Rect r );
-
-    //function to compute variance of a patch
-    float CalcVariance( cv::Rect r );
+    //function to compute the variance of every kernel of a band of rows
+    template< typename SUM_TYPE >
+    void CalcVarianceRows( const cv::Range &rows, const int kernelSize, const cv::Mat &mask );
 };
 
 } // namespace gc
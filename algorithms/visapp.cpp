@@ -18,6 +18,8 @@
 #include "visapp.h"
 #include <cstdio>
 #include <fstream>
+#include <sstream>
+#include <iomanip>
 #include <mutex>
 #include <algorithm>
 #include <opencv2/imgcodecs.hpp>
@@ -26,6 +28,7 @@
 #include <boost/algorithm/algorithm.hpp>
 #include <boost/exception/diagnostic_information.hpp>
 #include "animate.h"
+#include "imageloader.h"
 #include "timestampconvert.h"
 
 using namespace cv;
@@ -33,8 +36,6 @@ using namespace std;
 using namespace boost;
 namespace fs = boost::filesystem;
 
-static const double MIN_BOWTIE_FIND_SCORE = 0.55;
-
 #ifdef DEBUG_BOWTIE_FIND
 #undef DEBUG_BOWTIE_FIND
 #ifdef _WIN32
@@ -47,8 +48,8 @@ static const double MIN_BOWTIE_FIND_SCORE = 0.55;
 namespace gc
 {
 
-VisApp::VisApp() :
-    m_calibFilepath( "" )
+// the debug folder is created once for the process rather than by every VisApp
+static void CreateDebugFolder()
 {
     try
     {
@@ -68,6 +69,16 @@ VisApp::VisApp() :
     {
         FILE_LOG( logERROR ) << "[VisApp::VisApp] Creating debug folder" << diagnostic_information( e );
     }
+}
+VisApp::VisApp() :
+    m_calibFilepath( "" ),
+    m_calib( std::make_shared< Calib >() ),
+    m_calibCache( std::make_shared< CalibCache >() )
+{
+    static std::once_flag debugFolderFlag;
+    std::call_once( debugFolderFlag, CreateDebugFolder );
+
+    // both searches share the process wide bowtie template bank, only the first VisApp builds it
     GC_STATUS retVal = m_findLine.InitBowtieSearch( GC_BOWTIE_TEMPLATE_DIM, Size( GC_IMAGE_SIZE_WIDTH, GC_IMAGE_SIZE_HEIGHT ) );
     if ( GC_OK != retVal )
     {
@@ -88,7 +99,10 @@ GC_STATUS VisApp::LoadCalib( const std::string calibJson )
 
     try
     {
-        retVal = m_calib.Load( calibJson );
+        std::shared_ptr< Calib > calib = std::make_shared< Calib >();
+        retVal = calib->Load( calibJson );
+        m_calib = calib;
+        SetCalibSource( GC_OK == retVal ? calibJson : "" );
     }
     catch( std::exception &e )
     {
@@ -99,6 +113,30 @@ GC_STATUS VisApp::LoadCalib( const std::string calibJson )
 
     return retVal;
 }
+void VisApp::SetCalib( const Calib &calib, const std::string calibJson )
+{
+    m_calib = std::make_shared< Calib >( calib );
+    SetCalibSource( calibJson );
+}
+void VisApp::SetCalibCache( std::shared_ptr< CalibCache > calibCache )
+{
+    if ( nullptr == calibCache )
+    {
+        FILE_LOG( logERROR ) << "[VisApp::SetCalibCache] Cannot set a null calibration cache";
+    }
+    else
+    {
+        m_calibCache = calibCache;
+        SetCalibSource( "" );
+    }
+}
+// A calibration set directly (LoadCalib(), SetCalib(), Calibrate()) is used as is by line finds for the
+// file set here. For any other file, or when this is cleared, every line find gets the calibration from
+// the cache, which checks the json file modification time and size and loads it again if it changed.
+void VisApp::SetCalibSource( const std::string calibJson )
+{
+    m_calibFilepath = calibJson;
+}
 GC_STATUS VisApp::Calibrate( const string imgFilepath, const string worldCoordsCsv, const string calibJson, const string resultImagepath )
 {
     GC_STATUS retVal = GC_OK;
@@ -178,11 +216,15 @@ GC_STATUS VisApp::Calibrate( const string imgFilepath, const string worldCoordsC
                                     worldPtArray.push_back( worldCoords[ i ][ j ] );
                                 }
                             }
-                            retVal = m_calib.Calibrate( pixPtArray, worldPtArray, Size( 2, 4 ), img.size(), img, imgOut, drawCalib, drawMoveROIs );
+                            // the calibration in use may be shared with the cache, so it is changed as a copy
+                            std::shared_ptr< Calib > calib = std::make_shared< Calib >( *m_calib );
+                            retVal = calib->Calibrate( pixPtArray, worldPtArray, Size( 2, 4 ), img.size(), img, imgOut, drawCalib, drawMoveROIs );
                             if ( GC_OK == retVal )
                             {
-                                retVal = m_calib.Save( calibJson );
+                                retVal = calib->Save( calibJson );
                             }
+                            m_calib = calib;
+                            SetCalibSource( GC_OK == retVal ? calibJson : "" );
                         }
                     }
                 }
@@ -255,7 +297,7 @@ GC_STATUS VisApp::CalcLine( const Mat &img, const string timestamp )
         }
         else
         {
-            retVal = m_findLine.Find( img, m_calib.SearchLines(), result );
+            retVal = m_findLine.Find( img, m_calib->SearchLines(), m_calib->SwathTable(), result );
             if ( GC_OK != retVal )
             {
                 FILE_LOG( logERROR ) << "[VisApp::CalcLine] Could not calc line in image";
@@ -276,14 +318,14 @@ GC_STATUS VisApp::CalcLine( const Mat &img, const string timestamp )
                 }
                 else
                 {
-                    retVal = m_findLine.SetMoveTargetROI( img, m_calib.MoveSearchROI( true ), true );
+                    retVal = m_findLine.SetMoveTargetROI( img, m_calib->MoveSearchROI( true ), true );
                     if ( GC_OK != retVal )
                     {
                         result.msgs.push_back( "Could not set left move target search region" );
                     }
                     else
                     {
-                        retVal = m_findLine.SetMoveTargetROI( img, m_calib.MoveSearchROI( false ), false );
+                        retVal = m_findLine.SetMoveTargetROI( img, m_calib->MoveSearchROI( false ), false );
                         if ( GC_OK != retVal )
                         {
                             result.msgs.push_back( "Could not set right move target search region" );
@@ -291,8 +333,8 @@ GC_STATUS VisApp::CalcLine( const Mat &img, const string timestamp )
                         else
                         {
                             FindPointSet offsetPts;
-                            result.refMovePts.lftPixel = m_calib.MoveRefPoint( true );
-                            result.refMovePts.rgtPixel = m_calib.MoveRefPoint( false );
+                            result.refMovePts.lftPixel = m_calib->MoveRefPoint( true );
+                            result.refMovePts.rgtPixel = m_calib->MoveRefPoint( false );
                             result.refMovePts.ctrPixel = Point2d( ( result.refMovePts.lftPixel.x + result.refMovePts.rgtPixel.x ) / 2.0,
                                                                   ( result.refMovePts.lftPixel.y + result.refMovePts.rgtPixel.y ) / 2.0 );
                             retVal = PixelToWorld( result.refMovePts );
@@ -409,6 +451,8 @@ GC_STATUS VisApp::CalcLine( const FindLineParams params, FindLineResult &result,
             ss << "\"timestamp\": \"" << result.timestamp << "\",";
             ss << "\"waterLevelAdjusted_x\": " << result.waterLevelAdjusted.x << ",";
             ss << "\"waterLevelAdjusted_y\": " << result.waterLevelAdjusted.x << ",";
+            if ( result.hasFilteredLevel() )
+                ss << "\"waterLevelFiltered\": " << result.waterLevelFiltered << ",";
 
             string json;
             retVal = FindPtSet2JsonString( result.calcLinePts, "calc_line_pts", json );
@@ -461,10 +505,23 @@ GC_STATUS VisApp::CalcLine( const FindLineParams params, FindLineResult &result,
     return retVal;
 }
 GC_STATUS VisApp::CalcLine( const FindLineParams params, FindLineResult &result )
+{
+    string csvRow;
+    GC_STATUS retVal = CalcLineDeferCSV( params, result, csvRow );
+    if ( !csvRow.empty() )
+    {
+        GC_STATUS retCSV = WriteCSVRow( params.resultCSVPath, csvRow );
+        if ( GC_OK != retCSV )
+            retVal = retCSV;
+    }
+    return retVal;
+}
+GC_STATUS VisApp::CalcLineDeferCSV( const FindLineParams params, FindLineResult &result, string &csvRow )
 {
     GC_STATUS retVal = GC_OK;
     try
     {
+        csvRow.clear();
         result.clear();
         cv::Mat img = imread( params.imagePath, IMREAD_GRAYSCALE );
         if ( img.empty() )
@@ -473,6 +530,32 @@ GC_STATUS VisApp::CalcLine( const FindLineParams params, FindLineResult &result
             retVal = GC_ERR;
         }
         else
+        {
+            retVal = CalcLineDeferCSV( img, params, result, csvRow );
+        }
+    }
+    catch( Exception &e )
+    {
+        FILE_LOG( logERROR ) << "[VisApp::CalcLine] " << e.what();
+        FILE_LOG( logERROR ) << "Image=" << params.imagePath << " calib=" << params.calibFilepath;
+        retVal = GC_EXCEPT;
+    }
+
+    return retVal;
+}
+GC_STATUS VisApp::CalcLineDeferCSV( const cv::Mat &img, const FindLineParams params, FindLineResult &result, string &csvRow )
+{
+    GC_STATUS retVal = GC_OK;
+    try
+    {
+        csvRow.clear();
+        result.clear();
+        if ( img.empty() )
+        {
+            FILE_LOG( logERROR ) << "[VisApp::CalcLine] Empty image=" << params.imagePath ;
+            retVal = GC_ERR;
+        }
+        else
         {
             if ( FROM_FILENAME == params.timeStampType )
             {
@@ -496,32 +579,27 @@ GC_STATUS VisApp::CalcLine( const FindLineParams params, FindLineResult &result
             }
             if ( GC_OK == retVal )
             {
-                bool isOK = true;
-                if ( ( params.imagePath != params.resultImagePath ) && !params.resultImagePath.empty() )
+                // the cache stats the json file on every call and hands back the calibration it holds unless the
+                // file changed, so a calibration edited during a long watch is used from the next image on
+                if ( params.calibFilepath != m_calibFilepath )
                 {
-                    isOK = imwrite( params.resultImagePath, img );
-                    if ( !isOK )
-                    {
-                        result.msgs.push_back( "Could not save result image to " + params.resultImagePath );
-                        FILE_LOG( logERROR ) << "[VisApp::CalcLine] Could not save result image to " << params.resultImagePath;
-                        retVal = GC_ERR;
-                    }
-                }
-                if ( params.calibFilepath != m_calibFilepath && GC_OK == retVal )
-                {
-                    retVal = m_calib.Load( params.calibFilepath );
+                    std::shared_ptr< const Calib > calib;
+                    retVal = m_calibCache->Get( params.calibFilepath, calib );
                     if ( GC_OK != retVal )
                     {
                         result.msgs.push_back( "Could not load calibration" );
                         FILE_LOG( logERROR ) << "[VisApp::CalcLine] Could not load calibration=" << params.calibFilepath ;
                         retVal = GC_ERR;
                     }
+                    else
+                    {
+                        m_calib = calib;
+                        SetCalibSource( "" );
+                    }
                 }
                 if ( GC_OK == retVal)
                 {
-                    m_calibFilepath = params.calibFilepath;
-
-                    retVal = m_findLine.Find( img, m_calib.SearchLines(), result );
+                    retVal = m_findLine.Find( img, m_calib->SearchLines(), m_calib->SwathTable(), result );
                     if ( GC_OK != retVal )
                     {
                         m_findLineResult = result;
@@ -537,14 +615,14 @@ GC_STATUS VisApp::CalcLine( const FindLineParams params, FindLineResult &result
                         }
                         else
                         {
-                            retVal = m_findLine.SetMoveTargetROI( img, m_calib.MoveSearchROI( true ), true );
+                            retVal = m_findLine.SetMoveTargetROI( img, m_calib->MoveSearchROI( true ), true );
                             if ( GC_OK != retVal )
                             {
                                 result.msgs.push_back( "Could not set left move target search region" );
                             }
                             else
                             {
-                                retVal = m_findLine.SetMoveTargetROI( img, m_calib.MoveSearchROI( false ), false );
+                                retVal = m_findLine.SetMoveTargetROI( img, m_calib->MoveSearchROI( false ), false );
                                 if ( GC_OK != retVal )
                                 {
                                     result.msgs.push_back( "Could not set right move target search region" );
@@ -552,8 +630,8 @@ GC_STATUS VisApp::CalcLine( const FindLineParams params, FindLineResult &result
                                 else
                                 {
                                     FindPointSet offsetPts;
-                                    result.refMovePts.lftPixel = m_calib.MoveRefPoint( true );
-                                    result.refMovePts.rgtPixel = m_calib.MoveRefPoint( false );
+                                    result.refMovePts.lftPixel = m_calib->MoveRefPoint( true );
+                                    result.refMovePts.rgtPixel = m_calib->MoveRefPoint( false );
                                     result.refMovePts.ctrPixel = Point2d( ( result.refMovePts.lftPixel.x + result.refMovePts.rgtPixel.x ) / 2.0,
                                                                           ( result.refMovePts.lftPixel.y + result.refMovePts.rgtPixel.y ) / 2.0 );
                                     retVal = PixelToWorld( result.refMovePts );
@@ -607,10 +685,16 @@ GC_STATUS VisApp::CalcLine( const FindLineParams params, FindLineResult &result
                             }
                         }
                     }
+                    if ( nullptr != m_kalmanStations && GC_OK == m_kalmanStations->Update( params.calibFilepath, result ) )
+                    {
+                        char buffer[ 256 ];
+                        snprintf( buffer, 256, "Level (filtered): %.3f", result.waterLevelFiltered );
+                        result.msgs.push_back( buffer );
+                    }
                     m_findLineResult = result;
                     if ( !params.resultCSVPath.empty() )
                     {
-                        retVal = WriteFindlineResultToCSV( params.resultCSVPath, params.imagePath, result );
+                        retVal = FindlineResultToCSVRow( params.imagePath, result, csvRow, nullptr != m_kalmanStations );
                     }
                     if ( !params.resultImagePath.empty() )
                     {
@@ -641,19 +725,18 @@ GC_STATUS VisApp::CalcLine( const FindLineParams params, FindLineResult &result
 }
 GC_STATUS VisApp::WorldToPixel( const Point2d worldPt, Point2d &pixelPt )
 {
-    GC_STATUS retVal = m_calib.WorldToPixel( worldPt, pixelPt );
+    GC_STATUS retVal = m_calib->WorldToPixel( worldPt, pixelPt );
     return retVal;
 }
 GC_STATUS VisApp::PixelToWorld( FindPointSet &ptSet )
 {
-    GC_STATUS retVal = m_calib.PixelToWorld( ptSet.ctrPixel, ptSet.ctrWorld );
+    Point2d pts[ 3 ] = { ptSet.ctrPixel, ptSet.lftPixel, ptSet.rgtPixel };
+    GC_STATUS retVal = m_calib->PixelToWorld( pts, pts, 3 );
     if ( GC_OK == retVal )
     {
-        retVal = m_calib.PixelToWorld( ptSet.lftPixel, ptSet.lftWorld );
-        if ( GC_OK == retVal )
-        {
-            retVal = m_calib.PixelToWorld( ptSet.rgtPixel, ptSet.rgtWorld );
-        }
+        ptSet.ctrWorld = pts[ 0 ];
+        ptSet.lftWorld = pts[ 1 ];
+        ptSet.rgtWorld = pts[ 2 ];
     }
     return retVal;
 }
@@ -706,9 +789,13 @@ GC_STATUS VisApp::DrawCalibOverlay( const cv::Mat matIn, cv::Mat &imgMatOut,
     GC_STATUS retVal = GC_OK;
     try
     {
-        CalibModel model = m_calib.GetModel();
-        retVal = m_calib.Calibrate( model.pixelPoints, model.worldPoints, model.gridSize, matIn.size(),
-                                    matIn, imgMatOut, drawCalib, drawMoveROIs, drawSearchROI );
+        CalibModel model = m_calib->GetModel();
+        std::shared_ptr< Calib > calib = std::make_shared< Calib >( *m_calib );
+        retVal = calib->Calibrate( model.pixelPoints, model.worldPoints, model.gridSize, matIn.size(),
+                                   matIn, imgMatOut, drawCalib, drawMoveROIs, drawSearchROI );
+        m_calib = calib;
+        if ( GC_OK != retVal )
+            SetCalibSource( "" );
     }
     catch( Exception &e )
     {
@@ -736,127 +823,38 @@ GC_STATUS VisApp::DrawLineFindOverlay( const cv::Mat &img, cv::Mat &imgOut, cons
 GC_STATUS VisApp::WriteFindlineResultToCSV( const std::string resultCSV, const string imgPath,
                                             const FindLineResult &result, const bool overwrite )
 {
-    GC_STATUS retVal = GC_OK;
-    try
+    string row;
+    GC_STATUS retVal = FindlineResultToCSVRow( imgPath, result, row, nullptr != m_kalmanStations );
+    if ( GC_OK == retVal )
     {
-        bool addHeader = fs::exists( resultCSV ) ? false : true;
-        ofstream csvFile;
-        if ( overwrite )
-            csvFile.open( resultCSV, ofstream::out );
-        else
-            csvFile.open( resultCSV, ofstream::out | ofstream::app );
-
-        if ( !csvFile.is_open() )
-        {
-            FILE_LOG( logERROR ) << "[VisApp::WriteFindlineResultToCSV] Could not open to write" << resultCSV;
-            retVal = GC_ERR;
-        }
-        else
-        {
-            if ( addHeader )
-            {
-                csvFile << "imgPath,";
-                csvFile << "findSuccess,";
-
-                csvFile << "waterLevel,";
-                csvFile << "waterLevelAdjusted,";
-
-                csvFile << "calcLinePts-angle,";
-                csvFile << "calcLinePts-lftPixel-x,"; csvFile << "calcLinePts-lftPixel-y,";
-                csvFile << "calcLinePts-ctrPixel-x,"; csvFile << "calcLinePts-ctrPixel-y,";
-                csvFile << "calcLinePts-rgtPixel-x,"; csvFile << "calcLinePts-rgtPixel-y,";
-                csvFile << "calcLinePts-lftWorld-x,"; csvFile << "calcLinePts-lftWorld-y,";
-                csvFile << "calcLinePts-ctrWorld-x,"; csvFile << "calcLinePts-ctrWorld-y,";
-                csvFile << "calcLinePts-rgtWorld-x,"; csvFile << "calcLinePts-rgtWorld-y,";
-
-                csvFile << "refMovePts-angle,";
-                csvFile << "refMovePts-lftPixel-x,"; csvFile << "refMovePts-lftPixel-y,";
-                csvFile << "refMovePts-ctrPixel-x,"; csvFile << "refMovePts-ctrPixel-y,";
-                csvFile << "refMovePts-rgtPixel-x,"; csvFile << "refMovePts-rgtPixel-y,";
-                csvFile << "refMovePts-lftWorld-x,"; csvFile << "refMovePts-lftWorld-y,";
-                csvFile << "refMovePts-ctrWorld-x,"; csvFile << "refMovePts-ctrWorld-y,";
-                csvFile << "refMovePts-rgtWorld-x,"; csvFile << "refMovePts-rgtWorld-y,";
-
-                csvFile << "foundMovePts-angle,";
-                csvFile << "foundMovePts-lftPixel-x,"; csvFile << "foundMovePts-lftPixel-y,";
-                csvFile << "foundMovePts-ctrPixel-x,"; csvFile << "foundMovePts-ctrPixel-y,";
-                csvFile << "foundMovePts-rgtPixel-x,"; csvFile << "foundMovePts-rgtPixel-y,";
-                csvFile << "foundMovePts-lftWorld-x,"; csvFile << "foundMovePts-lftWorld-y,";
-                csvFile << "foundMovePts-ctrWorld-x,"; csvFile << "foundMovePts-ctrWorld-y,";
-                csvFile << "foundMovePts-rgtWorld-x,"; csvFile << "foundMovePts-rgtWorld-y,";
-
-                csvFile << "offsetMovePts-angle,";
-                csvFile << "offsetMovePts-lftPixel-x,"; csvFile << "offsetMovePts-lftPixel-y,";
-                csvFile << "offsetMovePts-ctrPixel-x,"; csvFile << "offsetMovePts-ctrPixel-y,";
-                csvFile << "offsetMovePts-rgtPixel-x,"; csvFile << "offsetMovePts-rgtPixel-y,";
-                csvFile << "offsetMovePts-lftWorld-x,"; csvFile << "offsetMovePts-lftWorld-y,";
-                csvFile << "offsetMovePts-ctrWorld-x,"; csvFile << "offsetMovePts-ctrWorld-y,";
-                csvFile << "offsetMovePts-rgtWorld-x,"; csvFile << "offsetMovePts-rgtWorld-y,";
-
-                csvFile << "foundPts[0]-x,"; csvFile << "foundPts[0]-y,"; csvFile << "foundPts[1]-x,"; csvFile << "foundPts[1]-y,";
-                csvFile << "foundPts[2]-x,"; csvFile << "foundPts[2]-y,"; csvFile << "foundPts[3]-x,"; csvFile << "foundPts[3]-y,";
-                csvFile << "foundPts[4]-x,"; csvFile << "foundPts[4]-y,"; csvFile << "foundPts[5]-x,"; csvFile << "foundPts[5]-y,";
-                csvFile << "foundPts[6]-x,"; csvFile << "foundPts[6]-y,"; csvFile << "foundPts[7]-x,"; csvFile << "foundPts[7]-y,";
-                csvFile << "foundPts[8]-x,"; csvFile << "foundPts[8]-y,"; csvFile << "foundPts[9]-x,"; csvFile << "foundPts[9]-y,";
-                csvFile << "...";
-                csvFile << endl;
-            }
-            csvFile << imgPath << ",";
-            csvFile << ( result.findSuccess ? "true" : "false" ) << ",";
-
-            csvFile << fixed << setprecision( 3 );
-            csvFile << result.calcLinePts.ctrWorld.y << ",";
-            csvFile << result.waterLevelAdjusted << ",";
-
-            csvFile << result.calcLinePts.angleWorld << ",";
-            csvFile << result.calcLinePts.lftPixel.x << ","; csvFile << result.calcLinePts.lftPixel.y << ",";
-            csvFile << result.calcLinePts.ctrPixel.x << ","; csvFile << result.calcLinePts.ctrPixel.y << ",";
-            csvFile << result.calcLinePts.rgtPixel.x << ","; csvFile << result.calcLinePts.rgtPixel.y << ",";
-            csvFile << result.calcLinePts.lftWorld.x << ","; csvFile << result.calcLinePts.lftWorld.y << ",";
-            csvFile << result.calcLinePts.ctrWorld.x << ","; csvFile << result.calcLinePts.ctrWorld.y << ",";
-            csvFile << result.calcLinePts.rgtWorld.x << ","; csvFile << result.calcLinePts.rgtWorld.y << ",";
-
-            csvFile << result.refMovePts.angleWorld << ",";
-            csvFile << result.refMovePts.lftPixel.x << ","; csvFile << result.refMovePts.lftPixel.y << ",";
-            csvFile << result.refMovePts.ctrPixel.x << ","; csvFile << result.refMovePts.ctrPixel.y << ",";
-            csvFile << result.refMovePts.rgtPixel.x << ","; csvFile << result.refMovePts.rgtPixel.y << ",";
-            csvFile << result.refMovePts.lftWorld.x << ","; csvFile << result.refMovePts.lftWorld.y << ",";
-            csvFile << result.refMovePts.ctrWorld.x << ","; csvFile << result.refMovePts.ctrWorld.y << ",";
-            csvFile << result.refMovePts.rgtWorld.x << ","; csvFile << result.refMovePts.rgtWorld.y << ",";
-
-            csvFile << result.foundMovePts.angleWorld << ",";
-            csvFile << result.foundMovePts.lftPixel.x << ","; csvFile << result.foundMovePts.lftPixel.y << ",";
-            csvFile << result.foundMovePts.ctrPixel.x << ","; csvFile << result.foundMovePts.ctrPixel.y << ",";
-            csvFile << result.foundMovePts.rgtPixel.x << ","; csvFile << result.foundMovePts.rgtPixel.y << ",";
-            csvFile << result.foundMovePts.lftWorld.x << ","; csvFile << result.foundMovePts.lftWorld.y << ",";
-            csvFile << result.foundMovePts.ctrWorld.x << ","; csvFile << result.foundMovePts.ctrWorld.y << ",";
-            csvFile << result.foundMovePts.rgtWorld.x << ","; csvFile << result.foundMovePts.rgtWorld.y << ",";
-
-            csvFile << result.offsetMovePts.angleWorld << ",";
-            csvFile << result.offsetMovePts.lftPixel.x << ","; csvFile << result.offsetMovePts.lftPixel.y << ",";
-            csvFile << result.offsetMovePts.ctrPixel.x << ","; csvFile << result.offsetMovePts.ctrPixel.y << ",";
-            csvFile << result.offsetMovePts.rgtPixel.x << ","; csvFile << result.offsetMovePts.rgtPixel.y << ",";
-            csvFile << result.offsetMovePts.lftWorld.x << ","; csvFile << result.offsetMovePts.lftWorld.y << ",";
-            csvFile << result.offsetMovePts.ctrWorld.x << ","; csvFile << result.offsetMovePts.ctrWorld.y << ",";
-            csvFile << result.offsetMovePts.rgtWorld.x << ","; csvFile << result.offsetMovePts.rgtWorld.y << ",";
-
-            for ( size_t i = 0; i < result.foundPoints.size(); ++i )
-            {
-                csvFile << result.foundPoints[ i ].x << ","; csvFile << result.foundPoints[ i ].y;
-                if ( result.foundPoints.size() - 1 > i )
-                    csvFile << ",";
-            }
-            csvFile << endl;
-        }
+        retVal = WriteCSVRow( resultCSV, row, overwrite );
     }
-    catch( Exception &e )
+    return retVal;
+}
+GC_STATUS VisApp::WriteCSVRow( const std::string resultCSV, const std::string row, const bool overwrite )
+{
+    // the rows of a VisApp with the Kalman stage hold the filtered level column
+    ResultSink sink;
+    GC_STATUS retVal = sink.Open( resultCSV, overwrite, nullptr != m_kalmanStations );
+    if ( GC_OK == retVal )
     {
-        FILE_LOG( logERROR ) << "[VisApp::CreateCalibOverlayImage] " << e.what();
-        retVal = GC_EXCEPT;
+        retVal = sink.WriteRow( row );
+        if ( GC_OK == retVal )
+        {
+            retVal = sink.Close();
+        }
     }
 
     return retVal;
 }
+string VisApp::FindlineCSVHeader( const bool withFiltered )
+{
+    return ResultSink::Header( withFiltered );
+}
+GC_STATUS VisApp::FindlineResultToCSVRow( const string imgPath, const FindLineResult &result, string &row, const bool withFiltered )
+{
+    return ResultSink::FormatRow( imgPath, result, row, withFiltered );
+}
 GC_STATUS VisApp::CreateAnimation( const std::string imageFolder, const std::string animationFilepath, const double fps, const double scale )
 {
     GC_STATUS retVal = GC_OK;
@@ -889,15 +887,21 @@ GC_STATUS VisApp::CreateAnimation( const std::string imageFolder, const std::str
             {
                 sort( images.begin(), images.end() );
 
+                images.resize( std::min( static_cast< size_t >( 1000 ), images.size() ) );
+
                 Animate animate;
+                ImageLoader loader;
                 retVal = animate.CreateCacheFolder();
+                if ( GC_OK == retVal )
+                    retVal = loader.Start( images, IMREAD_ANYCOLOR );
                 if ( GC_OK == retVal )
                 {
                     Mat img;
+                    size_t i;
                     char buffer[ 512 ];
-                    for ( size_t i = 0; i < static_cast< size_t >( std::min( 1000, static_cast< int >( images.size() ) ) ); ++i )
+                    GC_STATUS retLoad = loader.Next( i, img );
+                    for ( ; GC_OK == retLoad || GC_ERR == retLoad; retLoad = loader.Next( i, img ) )
                     {
-                        img = imread( images[ i ], IMREAD_ANYCOLOR );
                         if ( img.empty() )
                         {
                             FILE_LOG( logWARNING ) << "Could not read frame: " << images[ i ] << " for animation";
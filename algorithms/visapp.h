@@ -30,9 +30,13 @@
 #define VISAPP_H
 
 #include "calib.h"
+#include "calibcache.h"
 #include "findline.h"
 #include "findcalibgrid.h"
+#include "kalman.h"
 #include "metadata.h"
+#include "resultsink.h"
+#include <memory>
 
 //! GaugeCam classes, functions and variables
 namespace gc
@@ -118,6 +122,44 @@ public:
      */
     GC_STATUS LoadCalib( const std::string calibJson );
 
+    /**
+     * @brief Set the current calibration from an already loaded calibration object
+     *
+     * Lets several VisApp instances (e.g. one per worker thread) use one calibration that
+     * was loaded once, rather than each of them parsing the calibration json file.
+     *
+     * @param calib The loaded calibration to copy into this object
+     * @param calibJson The filepath from which the calibration was loaded
+     */
+    void SetCalib( const Calib &calib, const std::string calibJson );
+
+    /**
+     * @brief Set the cache from which line finds get the calibrations named in their parameters
+     *
+     * Each VisApp creates its own cache. Several VisApp instances (e.g. one per worker thread)
+     * can be given the same cache so each calibration is loaded once between all of them.
+     *
+     * @param calibCache The calibration cache to use
+     */
+    void SetCalibCache( std::shared_ptr< CalibCache > calibCache );
+
+    /**
+     * @brief Retrieve the hit, miss, and eviction counters of the calibration cache
+     * @return The counters
+     */
+    CalibCacheStats CalibCacheStatistics() { return m_calibCache->Stats(); }
+
+    /**
+     * @brief Set the online Kalman filter stage that smooths the levels found by CalcLine()
+     *
+     * Each successful line find passes its adjusted water level to the stage, keyed by the
+     * calibration filepath, and gets the filtered level back in result.waterLevelFiltered.
+     * Several VisApp instances can share one stage. Pass nullptr to stop filtering.
+     *
+     * @param kalmanStations The filter stage to use
+     */
+    void SetKalmanStations( std::shared_ptr< KalmanStations > kalmanStations ) { m_kalmanStations = kalmanStations; }
+
     /**
      * @brief Draw the currently loaded calibration onto an overlay image
      * @param imgMatOut OpenCV Mat of the input image onto which the calibration will be written
@@ -131,13 +173,13 @@ public:
      * @brief Retrieve the current calibration model to a CalibModel object
      * @return The CalibModel
      */
-    CalibModel GetCalibModel() { return m_calib.GetModel(); }
+    CalibModel GetCalibModel() { return m_calib->GetModel(); }
 
     /**
      * @brief Retrieve the current calibration model settings as a json string
      * @return The json string
      */
-    std::string CalibString() { return m_calib.ModelJsonString(); }
+    std::string CalibString() { return m_calib->ModelJsonString(); }
 
     // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
     // Findline methods
@@ -176,6 +218,35 @@ public:
      */
     GC_STATUS CalcLine( const FindLineParams params, FindLineResult &result, string &resultJson );
 
+    /**
+     * @brief Find the water level in an image, returning the csv result row rather than writing it
+     *
+     * Performs the same calculation as CalcLine(), but does not write to params.resultCSVPath. The
+     * row that CalcLine() would have appended is returned so that a caller running several VisApp
+     * objects in parallel can write the rows in a deterministic order.
+     *
+     * @param params Holds the filepaths and all other parameters need to perform a line find calculation
+     * @param result Holds the results of the line find calculation
+     * @param csvRow The csv row (without a line ending) for the result, empty if no row would have been written
+     * @return GC_OK=Success, GC_FAIL=Failure, GC_EXCEPT=Exception thrown
+     */
+    GC_STATUS CalcLineDeferCSV( const FindLineParams params, FindLineResult &result, std::string &csvRow );
+
+    /**
+     * @brief Find the water level in an already decoded image, returning the csv result row rather than writing it
+     *
+     * The image is not read from params.imagePath (which is only used for the timestamp and the csv row),
+     * so a caller that already holds the decoded image does not pay for a second decode. The overlay
+     * result image, if params.resultImagePath is set, is the only image encoded.
+     *
+     * @param img 8-bit grayscale image to search for the waterline
+     * @param params Holds the filepaths and all other parameters need to perform a line find calculation
+     * @param result Holds the results of the line find calculation
+     * @param csvRow The csv row (without a line ending) for the result, empty if no row would have been written
+     * @return GC_OK=Success, GC_FAIL=Failure, GC_EXCEPT=Exception thrown
+     */
+    GC_STATUS CalcLineDeferCSV( const cv::Mat &img, const FindLineParams params, FindLineResult &result, std::string &csvRow );
+
     /**
      * @brief Get image exif data used by GaugeCam as a human readable string
      * @param filepath Filepath of the image from which to retrieve the exif dat
@@ -270,6 +341,24 @@ public:
     GC_STATUS WriteFindlineResultToCSV( const std::string resultCSV, const std::string imgPath,
                                         const FindLineResult &result, const bool overwrite = false );
 
+    /**
+     * @brief Retrieve the header row of the find line result csv file
+     * @param withFiltered true=Include the Kalman filtered level column
+     * @return The header row (without a line ending)
+     */
+    static std::string FindlineCSVHeader( const bool withFiltered = false );
+
+    /**
+     * @brief Format a find line result as a csv row in the format written by WriteFindlineResultToCSV()
+     * @param imgPath Filepath of the image to which the results apply
+     * @param result The results of the waterlevel calculation to be formatted
+     * @param row String to hold the formatted row (without a line ending)
+     * @param withFiltered true=Include the Kalman filtered level column
+     * @return GC_OK=Success, GC_FAIL=Failure, GC_EXCEPT=Exception thrown
+     */
+    static GC_STATUS FindlineResultToCSVRow( const std::string imgPath, const FindLineResult &result, std::string &row,
+                                             const bool withFiltered = false );
+
     /**
      * @brief Draw both calibration model and line find overlays on a line find image based on its metadata
      * @param imageFilepathIn Input image filepath of the line find image that holds metadata
@@ -279,15 +368,19 @@ public:
     GC_STATUS DrawBothOverlays( const std::string imageFilepathIn, const std::string imageFilepathOut );
 
 private:
-    std::string m_calibFilepath;
+    std::string m_calibFilepath;                    ///< Calibration json file of a calibration set directly, empty when the cache supplies it
 
-    Calib m_calib;
+    std::shared_ptr< const Calib > m_calib;         ///< Calibration in use, shared with the cache when it came from it
+    std::shared_ptr< CalibCache > m_calibCache;
+    std::shared_ptr< KalmanStations > m_kalmanStations;
     FindLine m_findLine;
     FindLineResult m_findLineResult;
     FindCalibGrid m_findCalibGrid;
     MetaData m_metaData;
 
+    void SetCalibSource( const std::string calibJson );
     GC_STATUS PixelToWorld( FindPointSet &ptSet );
+    GC_STATUS WriteCSVRow( const std::string resultCSV, const std::string row, const bool overwrite = false );
     GC_STATUS ReadWorldCoordsFromCSV( const std::string csvFilepath, std::vector< std::vector< cv::Point2d > > &worldCoords );
     GC_STATUS FindPtSet2JsonString( const FindPointSet set, const string set_type, string &json );
 };
@@ -30,6 +30,11 @@ DEFINES += QT_DEPRECATED_WARNINGS
 # defines
 # ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 DEFINES += BOOST_ALL_NO_LIB BOOST_BIND_GLOBAL_PLACEHOLDERS
+
+# qmake CONFIG+=debug_find_line writes line find diagnostic images to /var/tmp/water/
+debug_find_line {
+    DEFINES += DEBUG_FIND_LINE
+}
 CONFIG += c++11
 
 win32 {
@@ -47,9 +52,17 @@ win32 {
 SOURCES += \
         ../algorithms/animate.cpp \
         ../algorithms/calib.cpp \
+        ../algorithms/calibcache.cpp \
+        ../algorithms/csvreader.cpp \
         ../algorithms/findcalibgrid.cpp \
         ../algorithms/findline.cpp \
+        ../algorithms/imageloader.cpp \
+        ../algorithms/kalman.cpp \
         ../algorithms/metadata.cpp \
+        ../algorithms/resultsink.cpp \
+        ../algorithms/resultstore.cpp \
+        ../algorithms/runjournal.cpp \
+        ../algorithms/templatematchdft.cpp \
         ../algorithms/visapp.cpp \
         guivisapp.cpp \
         main.cpp \
@@ -59,12 +72,19 @@ HEADERS += \
         ../algorithms/animate.h \
         ../algorithms/bresenham.h \
         ../algorithms/calib.h \
+        ../algorithms/calibcache.h \
         ../algorithms/csvreader.h \
         ../algorithms/findcalibgrid.h \
         ../algorithms/findline.h \
+        ../algorithms/imageloader.h \
+        ../algorithms/kalman.h \
         ../algorithms/gc_types.h \
         ../algorithms/log.h \
         ../algorithms/metadata.h \
+        ../algorithms/resultsink.h \
+        ../algorithms/resultstore.h \
+        ../algorithms/runjournal.h \
+        ../algorithms/templatematchdft.h \
         ../algorithms/timestampconvert.h \
         ../algorithms/visapp.h \
         ../algorithms/wincmd.h \
@@ -32,7 +32,9 @@
 #include <boost/uuid/uuid_io.hpp>
 #include <boost/exception/diagnostic_information.hpp>
 #include "../algorithms/timestampconvert.h"
+#include "../algorithms/imageloader.h"
 #include "../algorithms/kalman.h"
+#include "../algorithms/runjournal.h"
 #include "../algorithms/wincmd.h"
 
 using namespace cv;
@@ -836,18 +838,64 @@ GC_STATUS GuiVisApp::CalcLinesThreadFunc( const std::vector< std::string > &imag
             ofstream csvOut;
             string resultFolderAdj = params.resultImagePath;
 
+            // a journal beside the csv file records the images done, a run of the same images with the same
+            // parameters picks up where the last one stopped and appends to the csv file rather than replacing it
+            RunJournal journal;
+            vector< string > imagesToDo;
             if ( !params.resultCSVPath.empty() )
             {
-                csvOut.open( params.resultCSVPath );
-                if ( !csvOut.is_open() )
+                // the journal is started over when the parameters changed or the csv file lost rows it vouches for
+                string journalPath = params.resultCSVPath + ".journal";
+                retVal = journal.Open( journalPath, RunJournal::ParamsKey( params ) );
+                if ( GC_OK != retVal || ( 0 <= journal.CommittedCSVBytes() &&
+                                          ( !fs::exists( params.resultCSVPath ) ||
+                                            static_cast< uintmax_t >( journal.CommittedCSVBytes() ) > fs::file_size( params.resultCSVPath ) ) ) )
+                {
+                    journal.Close();
+                    FILE_LOG( logWARNING ) << "[GuiVisApp::CalcLinesThreadFunc] Starting over with a new journal " << journalPath;
+                    fs::remove( journalPath );
+                    retVal = journal.Open( journalPath, RunJournal::ParamsKey( params ) );
+                }
+                if ( GC_OK == retVal && 0 <= journal.CommittedCSVBytes() )
+                {
+                    uintmax_t committedBytes = static_cast< uintmax_t >( journal.CommittedCSVBytes() );
+                    if ( fs::file_size( params.resultCSVPath ) > committedBytes )
+                        fs::resize_file( params.resultCSVPath, committedBytes );
+                    csvOut.open( params.resultCSVPath, ios::app );
+                }
+                else if ( GC_OK == retVal )
+                {
+                    // the size of the new csv file is committed at once, so a run stopped before its first
+                    // full commit still has a size to cut the csv file back to
+                    csvOut.open( params.resultCSVPath );
+                    if ( csvOut.is_open() )
+                    {
+                        csvOut << "filename, timestamp, water level" << endl;
+                        retVal = journal.Commit( static_cast< long long >( fs::file_size( params.resultCSVPath ) ) );
+                        if ( GC_OK != retVal )
+                        {
+                            FILE_LOG( logERROR ) << "[GuiVisApp::CalcLinesThreadFunc] Could not commit run journal " << journalPath;
+                        }
+                    }
+                }
+                if ( GC_OK == retVal && !csvOut.is_open() )
                 {
                     FILE_LOG( logERROR ) << "[GuiVisApp::CalcLinesThreadFunc] Could not create CSV output file " << params.resultCSVPath;
                     retVal = GC_ERR;
                 }
+            }
+            RunJournalEntry doneEntry;
+            for ( size_t i = 0; i < images.size(); ++i )
+            {
+                if ( journal.IsOpen() && journal.IsDone( images[ i ], &doneEntry ) )
+                    sigTableAddRow( doneEntry.result );
                 else
-                {
-                    csvOut << "filename, timestamp, water level" << endl;
-                }
+                    imagesToDo.push_back( images[ i ] );
+            }
+            size_t doneCount = images.size() - imagesToDo.size();
+            if ( 0 < doneCount )
+            {
+                sigMessage( to_string( doneCount ) + " images already done in an earlier run were skipped" );
             }
             if ( !params.resultImagePath.empty() )
             {
@@ -877,11 +925,19 @@ GC_STATUS GuiVisApp::CalcLinesThreadFunc( const std::vector< std::string > &imag
                 findData.calibSettings = m_visApp.GetCalibModel();
                 findData.findlineParams = params;
 
+                // the next images are read and decoded while the line is found in the current one
+                ImageLoader loader;
+                GC_STATUS retLoad = loader.Start( imagesToDo, IMREAD_GRAYSCALE );
+                if ( GC_OK != retLoad )
+                    retVal = retLoad;
+
+                size_t imgIndex;
                 string tmStr, timestamp, resultString, graphData;
-                for ( size_t i = 0; i < images.size(); ++i )
+                for ( size_t i = 0; GC_OK == retLoad && i < imagesToDo.size(); ++i )
                 {
                     if ( !m_isRunning )
                     {
+                        loader.Stop();
                         sigMessage( "Folder run stopped" );
                         stopped = true;
                         break;
@@ -889,27 +945,27 @@ GC_STATUS GuiVisApp::CalcLinesThreadFunc( const std::vector< std::string > &imag
                     else
                     {
                         findData.findlineResult.clear();
-                        string filename = fs::path( images[ i ] ).filename().string();
+                        string filename = fs::path( imagesToDo[ i ] ).filename().string();
                         timestamp = "yyyy-mm-ddTHH:MM:SS";
                         if ( FROM_FILENAME == params.timeStampType )
                         {
-                            retVal = GcTimestampConvert::GetTimestampFromString( fs::path( images[ i ] ).filename().string(),
+                            retVal = GcTimestampConvert::GetTimestampFromString( fs::path( imagesToDo[ i ] ).filename().string(),
                                                                                  params.timeStampStartPos, params.timeStampFormat, timestamp );
                         }
                         else if ( FROM_EXIF == params.timeStampType )
                         {
                             string timestampTemp;
-                            retVal = m_visApp.GetImageTimestamp( images[ i ], timestampTemp );
+                            retVal = m_visApp.GetImageTimestamp( imagesToDo[ i ], timestampTemp );
                             if ( GC_OK == retVal )
                             {
                                 retVal = GcTimestampConvert::GetTimestampFromString( timestampTemp, params.timeStampStartPos,
                                                                                      params.timeStampFormat, timestamp );
                             }
                         }
-                        img = imread( images[ i ], IMREAD_GRAYSCALE );
+                        loader.Next( imgIndex, img );
                         if ( img.empty() )
                         {
-                            sigMessage( fs::path( images[ i ] ).filename().string() + " FAILURE: Could not open image" );
+                            sigMessage( fs::path( imagesToDo[ i ] ).filename().string() + " FAILURE: Could not open image" );
                         }
                         else
                         {
@@ -956,7 +1012,7 @@ GC_STATUS GuiVisApp::CalcLinesThreadFunc( const std::vector< std::string > &imag
                                 retVal = m_visApp.DrawLineFindOverlay( img, color, findData.findlineResult );
                                 if ( GC_OK == retVal )
                                 {
-                                    string resultFilepath = resultFolderAdj + fs::path( images[ i ] ).stem().string() + "_overlay.png";
+                                    string resultFilepath = resultFolderAdj + fs::path( imagesToDo[ i ] ).stem().string() + "_overlay.png";
                                     bool bRet = imwrite( resultFilepath, color );
                                     if ( !bRet )
                                     {
@@ -965,14 +1021,28 @@ GC_STATUS GuiVisApp::CalcLinesThreadFunc( const std::vector< std::string > &imag
                                 }
                             }
 
-                            findData.findlineParams.imagePath = images[ i ];
+                            if ( journal.IsOpen() )
+                            {
+                                GC_STATUS retJournal = journal.Add( imagesToDo[ i ], retVal, resultString );
+                                if ( GC_OK == retJournal && RUN_JOURNAL_DEFAULT_COMMIT_ROWS <= journal.PendingCount() )
+                                {
+                                    csvOut.flush();
+                                    retJournal = journal.Commit( static_cast< long long >( fs::file_size( params.resultCSVPath ) ) );
+                                }
+                                if ( GC_OK != retJournal )
+                                {
+                                    FILE_LOG( logERROR ) << "[GuiVisApp::CalcLinesThreadFunc] Could not record " << imagesToDo[ i ] << " in the run journal";
+                                }
+                            }
+
+                            findData.findlineParams.imagePath = imagesToDo[ i ];
                             retVal = LoadImageToApp( img );
                             sigMessage( "update image only" );
                             sigMessage( msg );
                             sigTableAddRow( resultString );
                         }
                     }
-                    progressVal = cvRound( 100.0 * static_cast< double >( i ) / static_cast< double >( images.size() ) ) + 1;
+                    progressVal = cvRound( 100.0 * static_cast< double >( doneCount + i ) / static_cast< double >( images.size() ) ) + 1;
                     sigProgress( progressVal );
                 }
                 if ( !stopped )
@@ -982,7 +1052,18 @@ GC_STATUS GuiVisApp::CalcLinesThreadFunc( const std::vector< std::string > &imag
                     m_isRunning = false;
                 }
                 if ( csvOut.is_open() )
+                {
+                    csvOut.flush();
+                    if ( journal.IsOpen() && 0 < journal.PendingCount() )
+                    {
+                        GC_STATUS retJournal = journal.Commit( static_cast< long long >( fs::file_size( params.resultCSVPath ) ) );
+                        if ( GC_OK != retJournal )
+                        {
+                            FILE_LOG( logERROR ) << "[GuiVisApp::CalcLinesThreadFunc] Could not commit the run journal of " << params.resultCSVPath;
+                        }
+                    }
                     csvOut.close();
+                }
             }
         }
     }
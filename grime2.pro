@@ -1,2 +1,7 @@
 TEMPLATE = subdirs
 SUBDIRS = grime2cli gcgui
+
+# qmake CONFIG+=tests also builds the checks and benchmarks in tests/
+tests {
+    SUBDIRS += tests
+}
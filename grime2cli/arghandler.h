@@ -5,19 +5,24 @@
 #include <boost/exception/diagnostic_information.hpp>
 #include <string>
 #include <iostream>
+#include <cstdlib>
+#include <climits>
 
 using namespace std;
 using namespace boost;
 namespace fs = boost::filesystem;
 static FILE *g_logFile = nullptr;
+static const int GRIME2_CLI_MAX_THREADS = 256;   ///< Largest number of images --threads processes concurrently
 
 bool IsExistingImagePath( const string imgPath );
+void PrintHelp();
 
 typedef enum GRIME2_CLI_OPERATIONS
 {
     CALIBRATE,
     FIND_LINE,
     RUN_FOLDER,
+    WATCH_FOLDER,
     MAKE_GIF,
     SHOW_METADATA,
     SHOW_VERSION,
@@ -33,7 +38,9 @@ public:
         timestamp_startPos( -1 ),
         timeStamp_length( -1 ),
         fps( 0.5 ),
-        scale( 1.0 )
+        scale( 1.0 ),
+        threads( 1 ),
+        csvSyncRows( 0 )
     {}
     void clear()
     {
@@ -43,12 +50,17 @@ public:
         csvPath.clear();
         calib_jsonPath.clear();
         result_imagePath.clear();
+        result_storePath.clear();
+        kalman_statePath.clear();
+        journalPath.clear();
         timestamp_format.clear();
         timestamp_type.clear();
         timestamp_startPos = -1;
         timeStamp_length = -1;
         fps = 0.5;
         scale = 1.0;
+        threads = 1;
+        csvSyncRows = 0;
     }
     bool verbose;
     GRIME2_CLI_OP opToPerform;
@@ -56,12 +68,17 @@ public:
     string csvPath;
     string calib_jsonPath;
     string result_imagePath;
+    string result_storePath;
+    string kalman_statePath;
+    string journalPath;
     string timestamp_format;
     string timestamp_type;
     int timestamp_startPos;
     int timeStamp_length;
     double fps;
     double scale;
+    int threads;
+    int csvSyncRows;
 };
 int GetArgs( int argc, char *argv[], Grime2CLIParams &params )
 {
@@ -128,6 +145,10 @@ int GetArgs( int argc, char *argv[], Grime2CLIParams &params )
                 {
                     params.opToPerform = RUN_FOLDER;
                 }
+                else if ( "watch" == string( argv[ i ] ).substr( 2 ) )
+                {
+                    params.opToPerform = WATCH_FOLDER;
+                }
                 else if ( "make_gif" == string( argv[ i ] ).substr( 2 ) )
                 {
                     params.opToPerform = MAKE_GIF;
@@ -170,6 +191,89 @@ int GetArgs( int argc, char *argv[], Grime2CLIParams &params )
                         break;
                     }
                 }
+                else if ( "threads" == string( argv[ i ] ).substr( 2 ) )
+                {
+                    if ( i + 1 < argc )
+                    {
+                        char *end = nullptr;
+                        long threads = strtol( argv[ ++i ], &end, 10 );
+                        if ( end == argv[ i ] || '\0' != *end || 1 > threads || GRIME2_CLI_MAX_THREADS < threads )
+                        {
+                            FILE_LOG( logERROR ) << "[ArgHandler] --threads must be a whole number from 1 to " << GRIME2_CLI_MAX_THREADS << ": " << argv[ i ];
+                            PrintHelp();
+                            retVal = -1;
+                            break;
+                        }
+                        params.threads = static_cast< int >( threads );
+                    }
+                    else
+                    {
+                        FILE_LOG( logERROR ) << "[ArgHandler] No value supplied on --threads request";
+                        retVal = -1;
+                        break;
+                    }
+                }
+                else if ( "result_store" == string( argv[ i ] ).substr( 2 ) )
+                {
+                    if ( i + 1 < argc )
+                    {
+                        params.result_storePath = string( argv[ ++i ] );
+                    }
+                    else
+                    {
+                        FILE_LOG( logERROR ) << "[ArgHandler] No value supplied on --result_store request";
+                        retVal = -1;
+                        break;
+                    }
+                }
+                else if ( "kalman_state" == string( argv[ i ] ).substr( 2 ) )
+                {
+                    if ( i + 1 < argc )
+                    {
+                        params.kalman_statePath = string( argv[ ++i ] );
+                    }
+                    else
+                    {
+                        FILE_LOG( logERROR ) << "[ArgHandler] No value supplied on --kalman_state request";
+                        retVal = -1;
+                        break;
+                    }
+                }
+                else if ( "journal" == string( argv[ i ] ).substr( 2 ) )
+                {
+                    if ( i + 1 < argc )
+                    {
+                        params.journalPath = string( argv[ ++i ] );
+                    }
+                    else
+                    {
+                        FILE_LOG( logERROR ) << "[ArgHandler] No value supplied on --journal request";
+                        retVal = -1;
+                        break;
+                    }
+                }
+                else if ( "csv_sync_rows" == string( argv[ i ] ).substr( 2 ) )
+                {
+                    if ( i + 1 < argc )
+                    {
+                        char *end = nullptr;
+                        long syncRows = strtol( argv[ ++i ], &end, 10 );
+                        if ( end == argv[ i ] || '\0' != *end || 0 > syncRows || INT_MAX < syncRows )
+                        {
+                            FILE_LOG( logERROR ) << "[ArgHandler] --csv_sync_rows must be a whole number from 0 to " << INT_MAX << ": " << argv[ i ];
+                            PrintHelp();
+                            retVal = -1;
+                            break;
+                        }
+                        params.csvSyncRows = static_cast< int >( syncRows );
+                    }
+                    else
+                    {
+                        FILE_LOG( logERROR ) << "[ArgHandler] No value supplied on --csv_sync_rows request";
+                        retVal = -1;
+                        break;
+                    }
+                }
                 else if ( "timestamp_from_exif" == string( argv[ i ] ).substr( 2 ) )
                 {
                     params.timestamp_type = "from_exif";
@@ -346,7 +450,8 @@ int GetArgs( int argc, char *argv[], Grime2CLIParams &params )
                     }
                 }
                 else if ( MAKE_GIF == params.opToPerform ||
-                          RUN_FOLDER == params.opToPerform )
+                          RUN_FOLDER == params.opToPerform ||
+                          WATCH_FOLDER == params.opToPerform )
                 {
                     if ( !fs::is_directory( params.src_imagePath ) )
                     {
@@ -420,9 +525,11 @@ void PrintHelp()
             "                  [Image path to be analyzed] --calib_json [Calibration json file path]" << endl <<
             "                  [--csv_file [Path of csv file to create or append with find line result] OPTIONAL]" << endl <<
             "                  [--result_image [Path of result overlay image] OPTIONAL]" << endl <<
+            "                  [--kalman_state [Path of Kalman filter checkpoint to read and update] OPTIONAL]" << endl <<
             "        Loads the specified image and calibration file, extracts the image using the specified" << endl <<
             "        timestamp parameters, calculates the line position, returns a json string with the find line" << endl <<
-            "        results to stdout, and creates the optional overlay result image if specified" << endl;
+            "        results to stdout, and creates the optional overlay result image if specified. With" << endl <<
+            "        --kalman_state the level is smoothed with the filter state of earlier runs" << endl;
     cout << "FORMAT: grime2cli --run_folder --timestamp_from_filename or --timestamp_from_exif " << endl <<
             "                   --timestamp_length [length in chars of the timestamp within the source string]" << endl <<
             "                   --timestamp_pos [position of the first timestamp char of source string]" << endl <<
@@ -430,9 +537,30 @@ void PrintHelp()
             "                   [Folder path of images to be analyzed] --calib_json [Calibration json file path]" << endl <<
             "                   [--csv_file [Path of csv file to create or append with find line results] OPTIONAL]" << endl <<
             "                   [--result_folder [Path of folder to hold result overlay images] OPTIONAL]" << endl <<
+            "                   [--threads [Number of images to process concurrently, 1 to 256] OPTIONAL default=1]" << endl <<
+            "                   [--csv_sync_rows [Number of csv rows between syncs to disk] OPTIONAL default=0 (no syncs)]" << endl <<
+            "                   [--result_store [Path of columnar result store to create or append] OPTIONAL]" << endl <<
+            "                   [--kalman_state [Path of Kalman filter checkpoint to read and update] OPTIONAL]" << endl <<
+            "                   [--journal [Path of run journal to create or resume] OPTIONAL]" << endl <<
             "        Loads the specified images and calibration file, extracts the timestamps using the specified" << endl <<
             "        timestamp parameters, calculates the line positions,  and creates the optional overlay result" << endl <<
-            "        image if specified" << endl;
+            "        image if specified. Images are processed in filename order and csv rows are written in that" << endl <<
+            "        order regardless of the number of threads. Csv rows are written in blocks, --csv_sync_rows" << endl <<
+            "        bounds the number of rows a crash can lose. With --journal the images done are recorded, and a" << endl <<
+            "        run restarted with the same journal and parameters skips them and appends only new csv rows" << endl;
+    cout << "FORMAT: grime2cli --watch --timestamp_from_filename or --timestamp_from_exif " << endl <<
+            "                   --timestamp_length [length in chars of the timestamp within the source string]" << endl <<
+            "                   --timestamp_pos [position of the first timestamp char of source string]" << endl <<
+            "                   --timestamp_format [y-m-d H:M format string for timestamp, e.g., yyyy-mm-ddTMM:HH]" << endl <<
+            "                   [Folder path to watch for new images] --calib_json [Calibration json file path]" << endl <<
+            "                   [--csv_file [Path of csv file to create or append with find line results] OPTIONAL]" << endl <<
+            "                   [--result_folder [Path of folder to hold result overlay images] OPTIONAL]" << endl <<
+            "                   [--result_store [Path of columnar result store to create or append] OPTIONAL]" << endl <<
+            "                   [--kalman_state [Path of Kalman filter checkpoint to read and update] OPTIONAL]" << endl <<
+            "                   [--journal [Path of run journal to create or resume] OPTIONAL]" << endl <<
+            "        Runs until interrupted, finding the line in each image written to the folder as soon as it is" << endl <<
+            "        complete. The calibration and search templates stay loaded between images. With --journal" << endl <<
+            "        the images already in the folder that the journal does not have as done are processed first" << endl;
     cout << "FORMAT: grime2cli --make_gif [Folder path of images] --result_image [File path of GIF to create]" << endl <<
             "                   [--fps [Animation frames per second] OPTIONAL default=0.5]" << endl <<
             "                   [--scale [Animation image scale from original] OPTIONAL default=1.0]" << endl <<
@@ -1,9 +1,14 @@
 TEMPLATE = app
-CONFIG += console c++11
+CONFIG += console c++11 thread
 CONFIG -= app_bundle
 CONFIG -= qt
 
 DEFINES += BOOST_ALL_NO_LIB BOOST_BIND_GLOBAL_PLACEHOLDERS
+
+# qmake CONFIG+=debug_find_line writes line find diagnostic images to /var/tmp/water/
+debug_find_line {
+    DEFINES += DEBUG_FIND_LINE
+}
 CONFIG += c++11
 
 win32 {
@@ -19,9 +24,18 @@ win32 {
 SOURCES += \
         ../algorithms/animate.cpp \
         ../algorithms/calib.cpp \
+        ../algorithms/calibcache.cpp \
+        ../algorithms/csvreader.cpp \
         ../algorithms/findcalibgrid.cpp \
         ../algorithms/findline.cpp \
+        ../algorithms/folderwatcher.cpp \
+        ../algorithms/imageloader.cpp \
+        ../algorithms/kalman.cpp \
         ../algorithms/metadata.cpp \
+        ../algorithms/resultsink.cpp \
+        ../algorithms/resultstore.cpp \
+        ../algorithms/runjournal.cpp \
+        ../algorithms/templatematchdft.cpp \
         ../algorithms/visapp.cpp \
         main.cpp
 
@@ -29,12 +43,20 @@ HEADERS += \
     ../algorithms/animate.h \
     ../algorithms/bresenham.h \
     ../algorithms/calib.h \
+    ../algorithms/calibcache.h \
     ../algorithms/csvreader.h \
     ../algorithms/findcalibgrid.h \
     ../algorithms/findline.h \
+    ../algorithms/folderwatcher.h \
+    ../algorithms/imageloader.h \
+    ../algorithms/kalman.h \
     ../algorithms/gc_types.h \
     ../algorithms/log.h \
     ../algorithms/metadata.h \
+    ../algorithms/resultsink.h \
+    ../algorithms/resultstore.h \
+    ../algorithms/runjournal.h \
+    ../algorithms/templatematchdft.h \
     ../algorithms/timestampconvert.h \
     ../algorithms/visapp.h \
     ../gcgui/wincmd.h \
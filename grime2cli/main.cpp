@@ -15,8 +15,20 @@
 ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 #include <string>
 #include <iostream>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <csignal>
+#include <chrono>
+#include <set>
 #include "arghandler.h"
 #include "../algorithms/visapp.h"
+#include "../algorithms/imageloader.h"
+#include "../algorithms/folderwatcher.h"
+#include "../algorithms/resultstore.h"
+#include "../algorithms/runjournal.h"
 
 using namespace std;
 using namespace gc;
@@ -33,6 +45,18 @@ using namespace gc;
 void ShowVersion();
 GC_STATUS FindWaterLevel( const Grime2CLIParams cliParams );
 GC_STATUS RunFolder( const Grime2CLIParams cliParams );
+GC_STATUS WatchFolder( const Grime2CLIParams cliParams );
+void SetFolderRunParams( const Grime2CLIParams &cliParams, FindLineParams &params, string &resultFolder );
+GC_STATUS ProcessWatchedImage( VisApp &visApp, const string &imagePath, FindLineParams &params, const string &resultFolder,
+                               ResultSink &csvSink, ResultStoreWriter &resultStore, size_t &storeRowsPending,
+                               RunJournal &journal );
+GC_STATUS RunFolderParallel( const vector< string > &images, const FindLineParams &paramsIn,
+                             const string resultFolder, const int threadCount, ResultSink &csvSink,
+                             ResultStoreWriter &resultStore, std::shared_ptr< KalmanStations > kalmanStations,
+                             RunJournal &journal );
+GC_STATUS OpenKalmanStations( const string statePath, std::shared_ptr< KalmanStations > &kalmanStations );
+GC_STATUS ResumeFromJournal( const RunJournal &journal, const string csvPath, vector< string > &images );
+GC_STATUS CommitJournal( RunJournal &journal, ResultSink &csvSink, const bool isFinal );
 
 /** \file main.cpp
  * @brief Holds the main() function for command line use of the h2o_cli libraries.
@@ -73,6 +97,10 @@ int main( int argc, char *argv[] )
             {
                 retVal = RunFolder( params );
             }
+            else if ( WATCH_FOLDER == params.opToPerform )
+            {
+                retVal = WatchFolder( params );
+            }
             else if ( MAKE_GIF == params.opToPerform )
             {
                 VisApp vis;
@@ -139,46 +167,710 @@ GC_STATUS RunFolder( const Grime2CLIParams cliParams )
             }
             else
             {
+                sort( images.begin(), images.end() );
+
                 FindLineParams params;
+                string result_folder;
+                SetFolderRunParams( cliParams, params, result_folder );
+
+                // a journal of an earlier run removes the images it finished and the csv rows written after its last commit
+                RunJournal journal;
+                if ( !cliParams.journalPath.empty() )
+                {
+                    retVal = journal.Open( cliParams.journalPath, RunJournal::ParamsKey( params ) );
+                    if ( GC_OK == retVal )
+                        retVal = ResumeFromJournal( journal, params.resultCSVPath, images );
+                }
+
+                // the csv file is held open for the whole run and its rows written in blocks
+                ResultSink csvSink;
+                if ( GC_OK != retVal )
+                {
+                    FILE_LOG( logERROR ) << "Could not resume from run journal " << cliParams.journalPath << endl;
+                }
+                else if ( !params.resultCSVPath.empty() )
+                {
+                    // the rows of a run with the Kalman stage hold the filtered level column
+                    retVal = csvSink.Open( params.resultCSVPath, false, !cliParams.kalman_statePath.empty() );
+                    if ( GC_OK == retVal )
+                        retVal = csvSink.SetSyncPolicy( static_cast< size_t >( std::max( 0, cliParams.csvSyncRows ) ), 0.0 );
+                    if ( GC_OK == retVal )
+                        retVal = CommitJournal( journal, csvSink, false );
+                }
+
+                ResultStoreWriter resultStore;
+                if ( GC_OK != retVal )
+                {
+                    if ( !params.resultCSVPath.empty() )
+                    {
+                        FILE_LOG( logERROR ) << "Could not open csv file " << params.resultCSVPath << endl;
+                    }
+                }
+                else if ( !cliParams.result_storePath.empty() )
+                {
+                    retVal = resultStore.Open( cliParams.result_storePath );
+                    if ( GC_OK != retVal )
+                    {
+                        FILE_LOG( logERROR ) << "Could not open result store " << cliParams.result_storePath << endl;
+                    }
+                }
 
-                params.calibFilepath = cliParams.calib_jsonPath;
-                params.resultCSVPath = cliParams.csvPath;
-                string result_folder = cliParams.result_imagePath;
-                if ( !result_folder.empty() )
+                std::shared_ptr< KalmanStations > kalmanStations;
+                if ( GC_OK == retVal )
                 {
-                    if ( '/' != result_folder[ result_folder.size() - 1 ] )
-                        result_folder += '/';
+                    retVal = OpenKalmanStations( cliParams.kalman_statePath, kalmanStations );
+                }
+
+                if ( GC_OK == retVal && 1 < cliParams.threads )
+                {
+                    retVal = RunFolderParallel( images, params, result_folder, cliParams.threads, csvSink, resultStore, kalmanStations, journal );
+                }
+                else if ( GC_OK == retVal )
+                {
+                    VisApp visApp;
+                    visApp.SetKalmanStations( kalmanStations );
+                    string resultJson;
+                    string csvRow;
+                    FindLineResult result;
+
+                    // the next images are read and decoded while the line is found in the current one
+                    ImageLoader loader;
+                    retVal = loader.Start( images, cv::IMREAD_GRAYSCALE );
+
+                    cv::Mat img;
+                    size_t i;
+                    GC_STATUS retLoad;
+                    bool isLoading = GC_OK == retVal;
+                    params.resultImagePath.clear();
+                    while ( isLoading )
+                    {
+                        // an image that could not be read comes back empty and fails like any other bad image
+                        retLoad = loader.Next( i, img );
+                        if ( GC_WARN == retLoad || GC_EXCEPT == retLoad )
+                        {
+                            if ( GC_EXCEPT == retLoad )
+                                retVal = retLoad;
+                            isLoading = false;
+                            continue;
+                        }
+                        if ( !result_folder.empty() )
+                        {
+                            params.resultImagePath = result_folder +
+                                    fs::path( images[ i ] ).stem().string() + "_result.png";
+                        }
+                        params.imagePath = images[ i ];
+                        retVal = visApp.CalcLineDeferCSV( img, params, result, csvRow );
+                        if ( csvSink.IsOpen() && !csvRow.empty() )
+                        {
+                            GC_STATUS retCSV = csvSink.WriteRow( csvRow );
+                            if ( GC_OK != retCSV )
+                                retVal = retCSV;
+                        }
+                        // an image that could not be read or timestamped has no capture time to store it by
+                        if ( resultStore.IsOpen() && result.hasTimestamp() )
+                        {
+                            GC_STATUS retStore = resultStore.Append( result );
+                            if ( GC_OK != retStore )
+                                retVal = retStore;
+                        }
+                        if ( journal.IsOpen() )
+                        {
+                            GC_STATUS retJournal = journal.Add( images[ i ], retVal, csvRow );
+                            if ( GC_OK == retJournal )
+                                retJournal = CommitJournal( journal, csvSink, false );
+                            if ( GC_OK != retJournal )
+                                retVal = retJournal;
+                        }
+                    }
                 }
-                params.timeStampFormat = cliParams.timestamp_format;
-                params.timeStampType = cliParams.timestamp_type == "from_filename" ? FROM_FILENAME : FROM_EXIF;
-                params.timeStampStartPos = cliParams.timestamp_startPos;
 
+                GC_STATUS retClose = CommitJournal( journal, csvSink, true );
+                if ( GC_OK == retVal )
+                    retVal = retClose;
+                retClose = csvSink.Close();
+                if ( GC_OK == retVal )
+                    retVal = retClose;
+                retClose = resultStore.Close();
+                if ( GC_OK == retVal )
+                    retVal = retClose;
+                retClose = journal.Close();
+                if ( GC_OK == retVal )
+                    retVal = retClose;
+                if ( nullptr != kalmanStations )
+                {
+                    retClose = kalmanStations->Save( cliParams.kalman_statePath );
+                    if ( GC_OK == retVal )
+                        retVal = retClose;
+                }
+            }
+        }
+    }
+    catch( const boost::exception &e )
+    {
+        FILE_LOG( logERROR ) << diagnostic_information( e );
+        retVal = GC_EXCEPT;
+    }
+
+    return retVal;
+}
+void SetFolderRunParams( const Grime2CLIParams &cliParams, FindLineParams &params, string &resultFolder )
+{
+    params.calibFilepath = cliParams.calib_jsonPath;
+    params.resultCSVPath = cliParams.csvPath;
+    resultFolder = cliParams.result_imagePath;
+    if ( !resultFolder.empty() )
+    {
+        if ( '/' != resultFolder[ resultFolder.size() - 1 ] )
+            resultFolder += '/';
+    }
+    params.timeStampFormat = cliParams.timestamp_format;
+    params.timeStampType = cliParams.timestamp_type == "from_filename" ? FROM_FILENAME : FROM_EXIF;
+    params.timeStampStartPos = cliParams.timestamp_startPos;
+}
+static volatile sig_atomic_t g_stopWatch = 0;
+static void StopWatchHandler( int )
+{
+    g_stopWatch = 1;
+}
+// The VisApp, and with it the calibration and the search templates, stays loaded for the whole watch
+// so each new image costs only its line find. The folder is watched before the images already in it
+// are listed, so an image written in between is not missed. That means an image can be both caught
+// up and reported by the watcher, and a rewritten image is reported again, so images the journal
+// already has done and images caught up before the first wait are skipped. Result store rows are
+// written in blocks of RESULT_STORE_WATCH_FLUSH_ROWS, or after RESULT_STORE_WATCH_FLUSH_SECS when
+// images are slow to arrive. The watch runs until SIGINT or SIGTERM.
+GC_STATUS WatchFolder( const Grime2CLIParams cliParams )
+{
+    GC_STATUS retVal = GC_OK;
+    try
+    {
+        FindLineParams params;
+        string result_folder;
+        SetFolderRunParams( cliParams, params, result_folder );
+
+        FolderWatcher watcher;
+        retVal = watcher.Open( cliParams.src_imagePath );
+
+        // with a journal the images that arrived while nothing was watching are caught up first
+        vector< string > images;
+        RunJournal journal;
+        if ( GC_OK == retVal && !cliParams.journalPath.empty() )
+        {
+            for ( auto& p: fs::directory_iterator( cliParams.src_imagePath ) )
+            {
+                if ( fs::is_regular_file( p.path() ) && FolderWatcher::IsImageFile( p.path().string() ) )
+                    images.push_back( p.path().string() );
+            }
+            sort( images.begin(), images.end() );
+
+            retVal = journal.Open( cliParams.journalPath, RunJournal::ParamsKey( params ) );
+            if ( GC_OK == retVal )
+                retVal = ResumeFromJournal( journal, params.resultCSVPath, images );
+        }
+
+        ResultSink csvSink;
+        if ( GC_OK == retVal && !params.resultCSVPath.empty() )
+        {
+            retVal = csvSink.Open( params.resultCSVPath, false, !cliParams.kalman_statePath.empty() );
+            if ( GC_OK == retVal )
+                retVal = csvSink.SetSyncPolicy( static_cast< size_t >( std::max( 0, cliParams.csvSyncRows ) ), 0.0 );
+            if ( GC_OK == retVal )
+                retVal = CommitJournal( journal, csvSink, false );
+        }
+        ResultStoreWriter resultStore;
+        if ( GC_OK == retVal && !cliParams.result_storePath.empty() )
+        {
+            retVal = resultStore.Open( cliParams.result_storePath );
+        }
+        std::shared_ptr< KalmanStations > kalmanStations;
+        if ( GC_OK == retVal )
+        {
+            retVal = OpenKalmanStations( cliParams.kalman_statePath, kalmanStations );
+        }
+
+        if ( GC_OK != retVal )
+        {
+            FILE_LOG( logERROR ) << "[WatchFolder] Could not start watching " << cliParams.src_imagePath;
+        }
+        else
+        {
+            VisApp visApp;
+            visApp.SetKalmanStations( kalmanStations );
+
+            g_stopWatch = 0;
+            signal( SIGINT, StopWatchHandler );
+            signal( SIGTERM, StopWatchHandler );
+            FILE_LOG( logINFO ) << "[WatchFolder] Watching " << cliParams.src_imagePath;
+
+            set< string > caughtUp;
+            bool isCatchUp = true;
+            size_t storeRowsPending = 0;
+            chrono::steady_clock::time_point lastStoreFlush = chrono::steady_clock::now();
+            while ( !g_stopWatch )
+            {
+                for ( size_t i = 0; i < images.size() && !g_stopWatch; ++i )
+                {
+                    if ( ( journal.IsOpen() && journal.IsDone( images[ i ] ) ) ||
+                         caughtUp.end() != caughtUp.find( images[ i ] ) )
+                    {
+                        FILE_LOG( logINFO ) << "[WatchFolder] Skipped " << images[ i ] << ", it was already processed";
+                        continue;
+                    }
+                    ProcessWatchedImage( visApp, images[ i ], params, result_folder, csvSink, resultStore, storeRowsPending, journal );
+                    if ( isCatchUp )
+                        caughtUp.insert( images[ i ] );
+                    if ( nullptr != kalmanStations && GC_OK != kalmanStations->Save( cliParams.kalman_statePath ) )
+                    {
+                        FILE_LOG( logERROR ) << "[WatchFolder] Could not save the Kalman filter state to " << cliParams.kalman_statePath;
+                    }
+                }
+                // the images caught up are only held until the watcher reports its first images
+                if ( !isCatchUp && !images.empty() )
+                    caughtUp.clear();
+                isCatchUp = false;
+
+                if ( 0 < storeRowsPending && ( RESULT_STORE_WATCH_FLUSH_ROWS <= storeRowsPending ||
+                     RESULT_STORE_WATCH_FLUSH_SECS <= chrono::duration< double >( chrono::steady_clock::now() - lastStoreFlush ).count() ) )
+                {
+                    if ( GC_OK != resultStore.Flush() )
+                    {
+                        FILE_LOG( logERROR ) << "[WatchFolder] Could not write the result store rows";
+                    }
+                    storeRowsPending = 0;
+                    lastStoreFlush = chrono::steady_clock::now();
+                }
+
+                retVal = watcher.Wait( FOLDER_WATCHER_WAIT_MSECS, images );
+                if ( GC_OK != retVal )
+                    break;
+            }
+
+            signal( SIGINT, SIG_DFL );
+            signal( SIGTERM, SIG_DFL );
+            FILE_LOG( logINFO ) << "[WatchFolder] Stopped watching " << cliParams.src_imagePath;
+        }
+
+        GC_STATUS retClose = CommitJournal( journal, csvSink, true );
+        if ( GC_OK == retVal )
+            retVal = retClose;
+        retClose = csvSink.Close();
+        if ( GC_OK == retVal )
+            retVal = retClose;
+        retClose = resultStore.Close();
+        if ( GC_OK == retVal )
+            retVal = retClose;
+        retClose = journal.Close();
+        if ( GC_OK == retVal )
+            retVal = retClose;
+    }
+    catch( const boost::exception &e )
+    {
+        FILE_LOG( logERROR ) << "[WatchFolder] " << diagnostic_information( e );
+        retVal = GC_EXCEPT;
+    }
+
+    return retVal;
+}
+// A watch has no end of run, so the csv row and the journal record of each image are written out
+// before the next image is waited for. The result store row is buffered and counted in
+// storeRowsPending so the caller can write the rows in blocks.
+GC_STATUS ProcessWatchedImage( VisApp &visApp, const string &imagePath, FindLineParams &params, const string &resultFolder,
+                               ResultSink &csvSink, ResultStoreWriter &resultStore, size_t &storeRowsPending,
+                               RunJournal &journal )
+{
+    params.imagePath = imagePath;
+    if ( resultFolder.empty() )
+        params.resultImagePath.clear();
+    else
+        params.resultImagePath = resultFolder + fs::path( imagePath ).stem().string() + "_result.png";
+
+    string csvRow;
+    FindLineResult result;
+    GC_STATUS retVal = visApp.CalcLineDeferCSV( params, result, csvRow );
+    if ( GC_OK == retVal )
+    {
+        if ( !result.hasFilteredLevel() )
+        {
+            FILE_LOG( logINFO ) << "[WatchFolder] " << imagePath << " level=" << result.waterLevelAdjusted.y;
+        }
+        else
+        {
+            FILE_LOG( logINFO ) << "[WatchFolder] " << imagePath << " level=" << result.waterLevelAdjusted.y
+                                << " filtered=" << result.waterLevelFiltered;
+        }
+    }
+    else
+    {
+        FILE_LOG( logWARNING ) << "[WatchFolder] Could not find the line in " << imagePath;
+    }
+
+    GC_STATUS retSink;
+    if ( csvSink.IsOpen() && !csvRow.empty() )
+    {
+        retSink = csvSink.WriteRow( csvRow );
+        if ( GC_OK == retSink )
+            retSink = csvSink.Flush();
+        if ( GC_OK != retSink )
+            retVal = retSink;
+    }
+    // an image that could not be read or timestamped is not stored or counted toward a block
+    if ( resultStore.IsOpen() && result.hasTimestamp() )
+    {
+        retSink = resultStore.Append( result );
+        if ( GC_OK == retSink )
+            ++storeRowsPending;
+        else
+            retVal = retSink;
+    }
+    if ( journal.IsOpen() )
+    {
+        retSink = journal.Add( imagePath, retVal, csvRow );
+        if ( GC_OK == retSink )
+            retSink = CommitJournal( journal, csvSink, true );
+        if ( GC_OK != retSink )
+            retVal = retSink;
+    }
+
+    return retVal;
+}
+// Each worker thread owns its own VisApp (and therefore its own FindLine and FindCalibGrid
+// search state). The workers share one calibration cache, so the calibration is loaded once
+// here and each worker copies it from the cache. Workers take images
+// in filename order, but may finish out of order, so their csv rows are parked in per-image
+// slots and the calling thread writes them to the csv file strictly in filename order. The
+// csv file is then identical to the one created by a single threaded run. Workers are not
+// allowed to get more than a few images per thread ahead of the writer to bound the number
+// of rows held in memory. The images are read and decoded ahead of the workers by an
+// ImageLoader, each worker copies the image it takes out of the loader ring.
+GC_STATUS RunFolderParallel( const vector< string > &images, const FindLineParams &paramsIn,
+                             const string resultFolder, const int threadCount, ResultSink &csvSink,
+                             ResultStoreWriter &resultStore, std::shared_ptr< KalmanStations > kalmanStations,
+                             RunJournal &journal )
+{
+    GC_STATUS retVal = GC_OK;
+    try
+    {
+        const size_t maxAhead = static_cast< size_t >( threadCount ) * 4;
+
+        // the loader hands out images in list order, so a worker takes its index and its image
+        // under one lock to keep the two in step
+        ImageLoader loader;
+        mutex mtxLoad;
+
+        std::shared_ptr< CalibCache > calibCache = std::make_shared< CalibCache >();
+        std::shared_ptr< const Calib > calib;
+        retVal = calibCache->Get( paramsIn.calibFilepath, calib );
+        if ( GC_OK != retVal )
+        {
+            FILE_LOG( logERROR ) << "[RunFolderParallel] Could not load calibration: " << paramsIn.calibFilepath;
+        }
+        else
+        {
+            retVal = loader.Start( images, cv::IMREAD_GRAYSCALE, IMAGE_LOADER_DEFAULT_DEPTH + static_cast< size_t >( threadCount ),
+                                   std::max( IMAGE_LOADER_DEFAULT_THREADS, threadCount / 2 ) );
+            if ( GC_OK != retVal )
+            {
+                FILE_LOG( logERROR ) << "[RunFolderParallel] Could not start reading the images";
+            }
+        }
+        if ( GC_OK == retVal )
+        {
+            vector< GC_STATUS > status( images.size(), GC_OK );
+            vector< string > csvRows( images.size() );
+            vector< ResultStoreRow > storeRows( resultStore.IsOpen() ? images.size() : 0 );
+            vector< bool > hasStoreRow( images.size(), false );
+            vector< FindLineResult > levelResults( nullptr != kalmanStations ? images.size() : 0 );
+            vector< bool > isDone( images.size(), false );
+            size_t nextToTake = 0;
+            size_t nextToWrite = 0;
+
+            mutex mtx;
+            condition_variable cvTake;
+            condition_variable cvDone;
+
+            auto worker = [ & ]()
+            {
                 VisApp visApp;
-                string resultJson;
+                visApp.SetCalibCache( calibCache );
+
+                FindLineParams params = paramsIn;
                 FindLineResult result;
+                string csvRow;
+                size_t idx;
+                size_t loadIdx;
+                bool isTaken;
+                bool isLoadMismatch;
+                cv::Mat imgSlot;
+                cv::Mat img;
+                GC_STATUS retLoad;
+                GC_STATUS retWorker;
+                ResultStoreRow storeRow;
+                bool isStoreRow;
+
+                for ( ;; )
+                {
+                    {
+                        lock_guard< mutex > lockLoad( mtxLoad );
+                        {
+                            unique_lock< mutex > lock( mtx );
+                            cvTake.wait( lock, [ & ]{ return nextToTake >= images.size() || nextToTake < nextToWrite + maxAhead; } );
+                            isTaken = nextToTake < images.size();
+                            if ( isTaken )
+                                idx = nextToTake++;
+                        }
+                        // an image that could not be read is left empty and fails like any other bad image
+                        if ( isTaken )
+                        {
+                            retLoad = loader.Next( loadIdx, imgSlot );
+
+                            // the loader hands the images out in list order, any other image is not the one taken
+                            isLoadMismatch = ( GC_OK == retLoad || GC_ERR == retLoad ) && loadIdx != idx;
+                            if ( isLoadMismatch )
+                            {
+                                FILE_LOG( logERROR ) << "[RunFolderParallel] " << images[ idx ] << ": Image loader returned image "
+                                                     << loadIdx << " for image " << idx;
+                                retLoad = GC_ERR;
+                            }
+                            try
+                            {
+                                if ( GC_OK == retLoad )
+                                    imgSlot.copyTo( img );
+                                else
+                                    img.release();
+                            }
+                            catch( std::exception &e )
+                            {
+                                FILE_LOG( logERROR ) << "[RunFolderParallel] " << images[ idx ] << ": " << e.what();
+                                retLoad = GC_EXCEPT;
+                            }
+                        }
+                    }
+                    if ( !isTaken )
+                        break;
+
+                    params.imagePath = images[ idx ];
+                    if ( resultFolder.empty() )
+                        params.resultImagePath.clear();
+                    else
+                        params.resultImagePath = resultFolder + fs::path( images[ idx ] ).stem().string() + "_result.png";
+
+                    try
+                    {
+                        if ( isLoadMismatch )
+                        {
+                            retWorker = GC_ERR;
+                            csvRow.clear();
+                            result.clear();
+                        }
+                        else if ( GC_OK != retLoad && GC_ERR != retLoad )
+                        {
+                            // the loader was stopped by a writer that stopped early, or it threw
+                            retWorker = retLoad;
+                            csvRow.clear();
+                            result.clear();
+                        }
+                        else
+                        {
+                            retWorker = visApp.CalcLineDeferCSV( img, params, result, csvRow );
+                        }
+                    }
+                    catch( std::exception &e )
+                    {
+                        FILE_LOG( logERROR ) << "[RunFolderParallel] " << images[ idx ] << ": " << e.what();
+                        retWorker = GC_EXCEPT;
+                        csvRow.clear();
+                        result.timestamp.clear();
+                    }
+                    // with the Kalman stage the store row is made by the writer once the level is filtered
+                    isStoreRow = nullptr == kalmanStations && resultStore.IsOpen() && result.hasTimestamp() && GC_OK == storeRow.Set( result );
 
-                params.resultImagePath.clear();
+                    {
+                        lock_guard< mutex > lock( mtx );
+                        status[ idx ] = retWorker;
+                        csvRows[ idx ] = csvRow;
+                        if ( isStoreRow )
+                        {
+                            storeRows[ idx ] = storeRow;
+                            hasStoreRow[ idx ] = true;
+                        }
+                        if ( nullptr != kalmanStations )
+                            levelResults[ idx ] = std::move( result );
+                        isDone[ idx ] = true;
+                    }
+                    cvDone.notify_one();
+                }
+            };
+
+            vector< thread > workers;
+            try
+            {
+                for ( int i = 0; i < threadCount; ++i )
+                    workers.push_back( thread( worker ) );
+
+                // the levels are filtered here, in filename order, not by the workers, and the csv and store
+                // rows are made again from the result so they hold the filtered level column
+                string csvRow;
+                ResultStoreRow storeRow;
+                FindLineResult levelResult;
+                bool isStoreRow;
                 for ( size_t i = 0; i < images.size(); ++i )
                 {
-                    if ( !result_folder.empty() )
                     {
-                        params.resultImagePath = result_folder +
-                                fs::path( images[ i ] ).stem().string() + "_result.png";
+                        unique_lock< mutex > lock( mtx );
+                        cvDone.wait( lock, [ & ]{ return isDone[ i ]; } );
+                        retVal = status[ i ];
+                        csvRow.swap( csvRows[ i ] );
+                        isStoreRow = hasStoreRow[ i ];
+                        if ( isStoreRow )
+                            storeRow = storeRows[ i ];
+                        if ( nullptr != kalmanStations )
+                            levelResult = std::move( levelResults[ i ] );
+                        nextToWrite = i + 1;
+                    }
+                    cvTake.notify_all();
+
+                    if ( nullptr != kalmanStations )
+                    {
+                        // a level that could not be filtered still gets the filtered level column
+                        kalmanStations->Update( paramsIn.calibFilepath, levelResult );
+                        if ( !csvRow.empty() )
+                        {
+                            GC_STATUS retCSV = VisApp::FindlineResultToCSVRow( images[ i ], levelResult, csvRow, true );
+                            if ( GC_OK != retCSV )
+                                retVal = retCSV;
+                        }
+                        isStoreRow = resultStore.IsOpen() && levelResult.hasTimestamp() && GC_OK == storeRow.Set( levelResult );
+                    }
+                    if ( csvSink.IsOpen() && !csvRow.empty() )
+                    {
+                        GC_STATUS retCSV = csvSink.WriteRow( csvRow );
+                        if ( GC_OK != retCSV )
+                            retVal = retCSV;
+                    }
+                    if ( journal.IsOpen() )
+                    {
+                        GC_STATUS retJournal = journal.Add( images[ i ], retVal, csvRow );
+                        if ( GC_OK == retJournal )
+                            retJournal = CommitJournal( journal, csvSink, false );
+                        if ( GC_OK != retJournal )
+                            retVal = retJournal;
+                    }
+                    csvRow.clear();
+                    if ( isStoreRow )
+                    {
+                        GC_STATUS retStore = resultStore.Append( storeRow );
+                        if ( GC_OK != retStore )
+                            retVal = retStore;
                     }
-                    params.imagePath = images[ i ];
-                    retVal = visApp.CalcLine( params, result );
                 }
             }
+            catch( std::exception &e )
+            {
+                FILE_LOG( logERROR ) << "[RunFolderParallel] " << e.what();
+                retVal = GC_EXCEPT;
+            }
+
+            // no images are left to take, so a worker waiting for the writer to catch up is released
+            // when the loop above stopped early, and one waiting for an image is released by the loader
+            {
+                lock_guard< mutex > lock( mtx );
+                nextToTake = images.size();
+            }
+            cvTake.notify_all();
+            loader.Stop();
+
+            for ( size_t i = 0; i < workers.size(); ++i )
+                workers[ i ].join();
+
+            CalibCacheStats stats = calibCache->Stats();
+            FILE_LOG( logINFO ) << "[RunFolderParallel] Calibration cache hits=" << stats.hits << " misses=" << stats.misses
+                                << " evictions=" << stats.evictions;
+        }
+    }
+    catch( std::exception &e )
+    {
+        FILE_LOG( logERROR ) << "[RunFolderParallel] " << e.what();
+        retVal = GC_EXCEPT;
+    }
+
+    return retVal;
+}
+// Images the journal has as done are taken out of the list. The csv file is cut back to its size at
+// the last journal commit, rows written after the commit belong to images that are done again.
+GC_STATUS ResumeFromJournal( const RunJournal &journal, const string csvPath, vector< string > &images )
+{
+    GC_STATUS retVal = GC_OK;
+    try
+    {
+        if ( !csvPath.empty() && 0 <= journal.CommittedCSVBytes() && fs::exists( csvPath ) )
+        {
+            uintmax_t committedBytes = static_cast< uintmax_t >( journal.CommittedCSVBytes() );
+            uintmax_t csvBytes = fs::file_size( csvPath );
+            if ( csvBytes > committedBytes )
+            {
+                FILE_LOG( logWARNING ) << "[ResumeFromJournal] Removing " << csvBytes - committedBytes
+                                       << " bytes of uncommitted rows from " << csvPath;
+                fs::resize_file( csvPath, committedBytes );
+            }
+            else if ( csvBytes < committedBytes )
+            {
+                FILE_LOG( logWARNING ) << "[ResumeFromJournal] " << csvPath << " is shorter than when the journal was committed";
+            }
+        }
+
+        size_t doneCount = 0;
+        vector< string > remaining;
+        for ( size_t i = 0; i < images.size(); ++i )
+        {
+            if ( journal.IsDone( images[ i ] ) )
+                ++doneCount;
+            else
+                remaining.push_back( images[ i ] );
         }
+        images.swap( remaining );
+        FILE_LOG( logINFO ) << "[ResumeFromJournal] Skipping " << doneCount << " images already done, "
+                            << images.size() << " images to process";
     }
     catch( const boost::exception &e )
     {
-        FILE_LOG( logERROR ) << diagnostic_information( e );
+        FILE_LOG( logERROR ) << "[ResumeFromJournal] " << diagnostic_information( e );
         retVal = GC_EXCEPT;
     }
 
     return retVal;
 }
+// The csv rows of the images added to the journal are flushed and synced before the journal
+// records them, so a committed image always has its row in the csv file. A journal with no csv
+// size yet is committed as soon as the csv file is open, so a run that stops before its first
+// full commit still has a size to cut the csv file back to.
+GC_STATUS CommitJournal( RunJournal &journal, ResultSink &csvSink, const bool isFinal )
+{
+    GC_STATUS retVal = GC_OK;
+    bool isFirstCommit = csvSink.IsOpen() && 0 > journal.CommittedCSVBytes();
+    if ( journal.IsOpen() && ( isFirstCommit || ( 0 < journal.PendingCount() &&
+         ( isFinal || RUN_JOURNAL_DEFAULT_COMMIT_ROWS <= journal.PendingCount() ) ) ) )
+    {
+        try
+        {
+            long long csvBytes = -1;
+            if ( csvSink.IsOpen() )
+            {
+                retVal = csvSink.Flush( true );
+                if ( GC_OK == retVal )
+                    csvBytes = static_cast< long long >( fs::file_size( csvSink.Filepath() ) );
+            }
+            if ( GC_OK == retVal )
+                retVal = journal.Commit( csvBytes );
+        }
+        catch( const boost::exception &e )
+        {
+            FILE_LOG( logERROR ) << "[CommitJournal] " << diagnostic_information( e );
+            retVal = GC_EXCEPT;
+        }
+    }
+
+    return retVal;
+}
 GC_STATUS FindWaterLevel( const Grime2CLIParams cliParams )
 {
     FindLineParams params;
@@ -193,10 +885,40 @@ GC_STATUS FindWaterLevel( const Grime2CLIParams cliParams )
     VisApp visApp;
     string resultJson;
     FindLineResult result;
-    GC_STATUS retVal = visApp.CalcLine( params, result, resultJson );
+    std::shared_ptr< KalmanStations > kalmanStations;
+    GC_STATUS retVal = OpenKalmanStations( cliParams.kalman_statePath, kalmanStations );
+    if ( GC_OK == retVal )
+    {
+        visApp.SetKalmanStations( kalmanStations );
+        retVal = visApp.CalcLine( params, result, resultJson );
+        if ( GC_OK == retVal && nullptr != kalmanStations )
+        {
+            retVal = kalmanStations->Save( cliParams.kalman_statePath );
+        }
+    }
     cout << ( GC_OK == retVal ? resultJson : "ERROR" ) << endl;
     return retVal;
 }
+// Creates the Kalman filter stage when a checkpoint path is given and loads the checkpoint
+// if it exists, so each run carries on from the filter states left by the last one
+GC_STATUS OpenKalmanStations( const string statePath, std::shared_ptr< KalmanStations > &kalmanStations )
+{
+    GC_STATUS retVal = GC_OK;
+    kalmanStations.reset();
+    if ( !statePath.empty() )
+    {
+        kalmanStations = std::make_shared< KalmanStations >();
+        if ( fs::exists( statePath ) )
+        {
+            retVal = kalmanStations->Load( statePath );
+            if ( GC_OK != retVal )
+            {
+                FILE_LOG( logERROR ) << "Could not load Kalman filter checkpoint " << statePath << endl;
+            }
+        }
+    }
+    return retVal;
+}
 
 void ShowVersion()
 {
@@ -0,0 +1,14 @@
+TEMPLATE = app
+include( ../tests.pri )
+
+SOURCES += \
+        ../../algorithms/findcalibgrid.cpp \
+        ../../algorithms/templatematchdft.cpp \
+        main.cpp
+
+HEADERS += \
+    ../elapsedtime.h \
+    ../../algorithms/findcalibgrid.h \
+    ../../algorithms/gc_types.h \
+    ../../algorithms/log.h \
+    ../../algorithms/templatematchdft.h
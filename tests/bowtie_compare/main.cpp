@@ -0,0 +1,194 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+   Copyright 2021 Kenneth W. Chapman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/** \file main.cpp
+ * @brief Compares the pyramid bowtie search with the full resolution search on sample images
+ *
+ * Every image of a folder is searched for the eight calibration bowties and for the two move
+ * bowties, once with the coarse to fine pyramid search and once with the full resolution
+ * search. The check fails when the pyramid search fails where the full resolution search
+ * succeeds, or when a found bowtie moves by more than the tolerance.
+ *
+ * bowtie_compare <image folder> <calib json> [tolerance in pixels, default 0.5]
+ *
+ * e.g. bowtie_compare gcgui/config/2012_demo gcgui/config/calib.json
+ *
+ * \author Kenneth W. Chapman
+ * \copyright Copyright (C) 2010-2021, Kenneth W. Chapman <coffeesig@gmail.com>, all rights reserved.\n
+ * This project is released under the Apache License, Version 2.0.
+ * \bug No known bugs.
+ */
+
+#include "log.h"
+#include "findcalibgrid.h"
+#include "elapsedtime.h"
+#include <string>
+#include <vector>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <opencv2/imgcodecs.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+using namespace cv;
+using namespace std;
+using namespace gc;
+namespace fs = boost::filesystem;
+namespace pt = boost::property_tree;
+
+class SearchResult
+{
+public:
+    SearchResult() : calibStatus( GC_ERR ), moveStatus( GC_ERR ), calibMsecs( 0.0 ), moveMsecs( 0.0 ) {}
+
+    GC_STATUS calibStatus;
+    GC_STATUS moveStatus;
+    double calibMsecs;
+    double moveMsecs;
+    vector< Point2d > calibPts;
+    Point2d moveLeft;
+    Point2d moveRight;
+};
+
+static Rect ReadRect( const pt::ptree &node )
+{
+    return Rect( node.get< int >( "x" ), node.get< int >( "y" ), node.get< int >( "width" ), node.get< int >( "height" ) );
+}
+static GC_STATUS Search( const Mat &img, const bool usePyramid, const Rect rectLeft, const Rect rectRight, SearchResult &result )
+{
+    FindCalibGrid findGrid;
+    findGrid.SetPyramidSearch( usePyramid );
+    GC_STATUS retVal = findGrid.InitBowtieTemplate( GC_BOWTIE_TEMPLATE_DIM, img.size() );
+    if ( GC_OK == retVal )
+        retVal = findGrid.SetMoveTargetROI( img, rectLeft, true );
+    if ( GC_OK == retVal )
+        retVal = findGrid.SetMoveTargetROI( img, rectRight, false );
+    if ( GC_OK == retVal )
+    {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        result.calibStatus = findGrid.FindTargets( img, MIN_BOWTIE_FIND_SCORE );
+        result.calibMsecs = MsecsSince( start );
+        if ( GC_OK == result.calibStatus )
+        {
+            vector< vector< Point2d > > pts;
+            result.calibStatus = findGrid.GetFoundPoints( pts );
+            for ( size_t i = 0; i < pts.size(); ++i )
+                result.calibPts.insert( result.calibPts.end(), pts[ i ].begin(), pts[ i ].end() );
+        }
+
+        start = chrono::steady_clock::now();
+        result.moveStatus = findGrid.FindMoveTargets( img, result.moveLeft, result.moveRight );
+        result.moveMsecs = MsecsSince( start );
+    }
+    return retVal;
+}
+
+int main( int argc, char *argv[] )
+{
+    Output2FILE::Stream() = stderr;
+    if ( 3 > argc )
+    {
+        cout << "Usage: bowtie_compare <image folder> <calib json> [tolerance in pixels]" << endl;
+        return -1;
+    }
+
+    int ret = 0;
+    try
+    {
+        double tolerance = 3 < argc ? stod( argv[ 3 ] ) : 0.5;
+
+        pt::ptree calibTree;
+        pt::read_json( argv[ 2 ], calibTree );
+        Rect rectLeft = ReadRect( calibTree.get_child( "MoveSearchRegions.Left" ) );
+        Rect rectRight = ReadRect( calibTree.get_child( "MoveSearchRegions.Right" ) );
+
+        vector< string > images;
+        for ( fs::recursive_directory_iterator iter( argv[ 1 ] ), end; iter != end; ++iter )
+        {
+            string ext = iter->path().extension().string();
+            transform( ext.begin(), ext.end(), ext.begin(), ::tolower );
+            if ( fs::is_regular_file( iter->path() ) && ( ".jpg" == ext || ".png" == ext ) )
+                images.push_back( iter->path().string() );
+        }
+        sort( images.begin(), images.end() );
+
+        int regressions = 0, calibFound = 0, moveFound = 0;
+        double calibMsecs[ 2 ] = { 0.0, 0.0 }, moveMsecs[ 2 ] = { 0.0, 0.0 };
+        cout << fixed << setprecision( 3 );
+        cout << "image, full calib, pyramid calib, calib max dist, full move, pyramid move, move max dist" << endl;
+        for ( size_t i = 0; i < images.size(); ++i )
+        {
+            Mat img = imread( images[ i ], IMREAD_GRAYSCALE );
+            SearchResult full, pyramid;
+            if ( img.empty() || GC_OK != Search( img, false, rectLeft, rectRight, full ) ||
+                 GC_OK != Search( img, true, rectLeft, rectRight, pyramid ) )
+            {
+                cout << images[ i ] << ", could not be searched" << endl;
+                ++regressions;
+                continue;
+            }
+            calibMsecs[ 0 ] += full.calibMsecs;
+            calibMsecs[ 1 ] += pyramid.calibMsecs;
+            moveMsecs[ 0 ] += full.moveMsecs;
+            moveMsecs[ 1 ] += pyramid.moveMsecs;
+
+            double calibDist = -1.0;
+            if ( GC_OK == full.calibStatus )
+            {
+                ++calibFound;
+                if ( GC_OK == pyramid.calibStatus && full.calibPts.size() == pyramid.calibPts.size() )
+                {
+                    calibDist = 0.0;
+                    for ( size_t j = 0; j < full.calibPts.size(); ++j )
+                        calibDist = std::max( calibDist, norm( full.calibPts[ j ] - pyramid.calibPts[ j ] ) );
+                }
+                if ( 0.0 > calibDist || tolerance < calibDist )
+                    ++regressions;
+            }
+            double moveDist = -1.0;
+            if ( GC_OK == full.moveStatus )
+            {
+                ++moveFound;
+                if ( GC_OK == pyramid.moveStatus )
+                    moveDist = std::max( norm( full.moveLeft - pyramid.moveLeft ), norm( full.moveRight - pyramid.moveRight ) );
+                if ( 0.0 > moveDist || tolerance < moveDist )
+                    ++regressions;
+            }
+
+            cout << images[ i ] << ", " << ( GC_OK == full.calibStatus ? "found" : "not found" ) << ", "
+                 << ( GC_OK == pyramid.calibStatus ? "found" : "not found" ) << ", " << calibDist << ", "
+                 << ( GC_OK == full.moveStatus ? "found" : "not found" ) << ", "
+                 << ( GC_OK == pyramid.moveStatus ? "found" : "not found" ) << ", " << moveDist << endl;
+        }
+
+        double count = static_cast< double >( std::max( static_cast< size_t >( 1 ), images.size() ) );
+        cout << "images=" << images.size() << " calib found (full)=" << calibFound << " move found (full)=" << moveFound << endl;
+        cout << "mean calib msecs full=" << calibMsecs[ 0 ] / count << " pyramid=" << calibMsecs[ 1 ] / count << endl;
+        cout << "mean move msecs full=" << moveMsecs[ 0 ] / count << " pyramid=" << moveMsecs[ 1 ] / count << endl;
+        cout << ( 0 == regressions ? "PASS" : "FAIL" ) << " regressions=" << regressions << " tolerance=" << tolerance << endl;
+        ret = 0 == regressions ? 0 : 1;
+    }
+    catch( const std::exception &e )
+    {
+        cout << "bowtie_compare failed: " << e.what() << endl;
+        ret = -1;
+    }
+
+    return ret;
+}
@@ -0,0 +1,12 @@
+TEMPLATE = app
+include( ../tests.pri )
+
+SOURCES += \
+        ../../algorithms/csvreader.cpp \
+        main.cpp
+
+HEADERS += \
+    ../elapsedtime.h \
+    ../../algorithms/csvreader.h \
+    ../../algorithms/gc_types.h \
+    ../../algorithms/log.h
@@ -0,0 +1,207 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+   Copyright 2021 Kenneth W. Chapman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/** \file main.cpp
+ * @brief Checks the memory mapped csv reader against the line by line reader
+ *
+ * A csv file with comment lines, empty lines, lines that end in "\r\n", short rows, empty
+ * fields and a block of generated numeric rows is written to the temp folder. The rows from
+ * CSVReader::forEachRow() and from CSVReader::getRow() must equal the rows from
+ * CSVReader::getData() (apart from the '\r' getData() keeps at the end of a line), and
+ * CSVField::toDouble()/toInt() must agree with stod()/stoll().
+ *
+ * csvreader_check [generated row count, default 100000]
+ *
+ * \author Kenneth W. Chapman
+ * \copyright Copyright (C) 2010-2021, Kenneth W. Chapman <coffeesig@gmail.com>, all rights reserved.\n
+ * This project is released under the Apache License, Version 2.0.
+ * \bug No known bugs.
+ */
+
+#include "log.h"
+#include "csvreader.h"
+#include "elapsedtime.h"
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <boost/filesystem.hpp>
+
+using namespace std;
+using namespace gc;
+namespace fs = boost::filesystem;
+
+typedef vector< vector< string > > StringRows;
+
+static void WriteCheckFile( const string filepath, const int generatedRows )
+{
+    ofstream file( filepath, ios::out | ios::binary );
+    file << "# comment line, it is skipped\n";
+    file << "timestamp,level,count,note\n";
+    file << "\n";
+    file << "2012-06-30T10:45:00,1.25,12,first\r\n";
+    file << "2012-06-30T11:00:00, -3.5e2 ,7,\r\n";
+    file << "2012-06-30T11:15:00,,0x10,1.5x\n";
+    file << "2012-06-30T11:30:00,nan,+4\n";
+    file << "short\n";
+    file << "# another comment\n";
+    file << ",,,\n";
+
+    mt19937 gen( 42 );
+    uniform_real_distribution< double > level( -1000.0, 1000.0 );
+    uniform_int_distribution< long long > count( -1000000, 1000000 );
+    file << setprecision( 17 );
+    for ( int i = 0; i < generatedRows; ++i )
+    {
+        file << "2013-01-01T00:00:" << i << "," << level( gen ) << "," << count( gen ) << ",row " << i << "\n";
+    }
+    file << "last line without a newline,2";
+}
+static bool SameRow( const vector< string > &expected, const CSVRow &row )
+{
+    if ( expected.size() != row.size() )
+        return false;
+    for ( size_t i = 0; i < row.size(); ++i )
+    {
+        string field = expected[ i ];
+        if ( i + 1 == row.size() && !field.empty() && '\r' == field[ field.size() - 1 ] )
+            field.erase( field.size() - 1 );
+        if ( row[ i ] != field )
+            return false;
+    }
+    return true;
+}
+// stod() and stoll() accept a number followed by other text, a field must be a number throughout
+static bool ExpectedDouble( const string &text, double &value )
+{
+    try
+    {
+        size_t used;
+        value = stod( text, &used );
+        return text.find_first_not_of( " \t", used ) == string::npos;
+    }
+    catch( const std::exception & )
+    {
+        return false;
+    }
+}
+static bool ExpectedInt( const string &text, long long &value )
+{
+    try
+    {
+        size_t used;
+        value = stoll( text, &used );
+        return text.find_first_not_of( " \t", used ) == string::npos;
+    }
+    catch( const std::exception & )
+    {
+        return false;
+    }
+}
+
+int main( int argc, char *argv[] )
+{
+    int generatedRows = 1 < argc ? atoi( argv[ 1 ] ) : 100000;
+    string filepath = ( fs::temp_directory_path() / "csvreader_check.csv" ).string();
+    WriteCheckFile( filepath, generatedRows );
+
+    int mismatches = 0;
+    CSVReader reader( filepath );
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    StringRows expected = reader.getData();
+    double getDataMsecs = MsecsSince( start );
+
+    size_t rowCount = 0;
+    start = chrono::steady_clock::now();
+    GC_STATUS retVal = reader.forEachRow( [ & ]( const size_t, const CSVRow & ) { ++rowCount; return true; } );
+    double forEachMsecs = MsecsSince( start );
+    if ( GC_OK != retVal || expected.size() != rowCount )
+    {
+        cout << "forEachRow read " << rowCount << " of " << expected.size() << " rows" << endl;
+        ++mismatches;
+    }
+
+    rowCount = 0;
+    retVal = reader.forEachRow( [ & ]( const size_t rowIndex, const CSVRow &row )
+    {
+        if ( expected.size() <= rowIndex || !SameRow( expected[ rowIndex ], row ) )
+        {
+            cout << "forEachRow mismatch at row " << rowIndex << endl;
+            ++mismatches;
+        }
+        else
+        {
+            for ( size_t i = 0; i < row.size(); ++i )
+            {
+                double value = 0.0, expectedValue = 0.0;
+                long long intValue = 0, expectedIntValue = 0;
+                bool isDouble = row[ i ].toDouble( value );
+                bool isInt = row[ i ].toInt( intValue );
+                bool expectDouble = ExpectedDouble( row[ i ].str(), expectedValue );
+                bool expectInt = ExpectedInt( row[ i ].str(), expectedIntValue );
+                if ( isDouble != expectDouble || ( isDouble && !( value == expectedValue || ( value != value && expectedValue != expectedValue ) ) ) ||
+                     isInt != expectInt || ( isInt && intValue != expectedIntValue ) )
+                {
+                    cout << "number mismatch at row " << rowIndex << " field \"" << row[ i ].str() << "\"" << endl;
+                    ++mismatches;
+                }
+            }
+        }
+        ++rowCount;
+        return true;
+    } );
+    if ( GC_OK != retVal || expected.size() != rowCount )
+    {
+        cout << "forEachRow checked " << rowCount << " of " << expected.size() << " rows" << endl;
+        ++mismatches;
+    }
+
+    retVal = reader.indexRows();
+    if ( GC_OK != retVal || expected.size() != reader.rowCount() )
+    {
+        cout << "indexRows found " << reader.rowCount() << " of " << expected.size() << " rows" << endl;
+        ++mismatches;
+    }
+    else
+    {
+        CSVRow row;
+        for ( size_t i = 0; i < reader.rowCount(); ++i )
+        {
+            if ( !reader.getRow( i, row ) || !SameRow( expected[ i ], row ) )
+            {
+                cout << "getRow mismatch at row " << i << endl;
+                ++mismatches;
+            }
+        }
+        if ( reader.getRow( reader.rowCount(), row ) )
+        {
+            cout << "getRow read past the last row" << endl;
+            ++mismatches;
+        }
+    }
+    reader.close();
+    fs::remove( filepath );
+
+    cout << fixed << setprecision( 1 ) << "rows=" << expected.size() << " getData msecs=" << getDataMsecs
+         << " forEachRow msecs=" << forEachMsecs << endl;
+    cout << ( 0 == mismatches ? "PASS" : "FAIL" ) << " mismatches=" << mismatches << endl;
+
+    return 0 == mismatches ? 0 : -1;
+}
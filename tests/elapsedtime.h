@@ -0,0 +1,51 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+   Copyright 2021 Kenneth W. Chapman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/** \file elapsedtime.h
+ * @brief Elapsed time helpers shared by the check and benchmark apps
+ *
+ * \author Kenneth W. Chapman
+ * \copyright Copyright (C) 2010-2021, Kenneth W. Chapman <coffeesig@gmail.com>, all rights reserved.\n
+ * This project is released under the Apache License, Version 2.0.
+ * \bug No known bugs.
+ */
+
+#ifndef ELAPSEDTIME_H
+#define ELAPSEDTIME_H
+
+#include <chrono>
+
+/**
+ * @brief Get the milliseconds elapsed since a start time
+ * @param start Start time
+ * @return Elapsed milliseconds
+ */
+inline double MsecsSince( const std::chrono::steady_clock::time_point start )
+{
+    return std::chrono::duration< double, std::milli >( std::chrono::steady_clock::now() - start ).count();
+}
+
+/**
+ * @brief Get the microseconds elapsed since a start time
+ * @param start Start time
+ * @return Elapsed microseconds
+ */
+inline double UsecsSince( const std::chrono::steady_clock::time_point start )
+{
+    return std::chrono::duration< double, std::micro >( std::chrono::steady_clock::now() - start ).count();
+}
+
+#endif // ELAPSEDTIME_H
@@ -0,0 +1,12 @@
+TEMPLATE = app
+include( ../tests.pri )
+
+SOURCES += \
+        ../../algorithms/entropymap.cpp \
+        main.cpp
+
+HEADERS += \
+    ../elapsedtime.h \
+    ../../algorithms/entropymap.h \
+    ../../algorithms/gc_types.h \
+    ../../algorithms/log.h
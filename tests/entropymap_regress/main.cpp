@@ -0,0 +1,162 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+   Copyright 2021 Kenneth W. Chapman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/** \file main.cpp
+ * @brief Checks the sliding histogram entropy map against the per kernel reference map
+ *
+ * EntropyMap::CalcMap() with its default stride must give exactly the map of
+ * EntropyMap::CalcMapReference() for full and elliptical kernels of even and odd sizes. The
+ * maps are compared on noise and gradient images whose sizes are not multiples of the stride
+ * and, when a folder is given, on every jpg and png image below it.
+ *
+ * entropymap_regress [image folder]
+ *
+ * e.g. entropymap_regress gcgui/config/2012_demo
+ *
+ * \author Kenneth W. Chapman
+ * \copyright Copyright (C) 2010-2021, Kenneth W. Chapman <coffeesig@gmail.com>, all rights reserved.\n
+ * This project is released under the Apache License, Version 2.0.
+ * \bug No known bugs.
+ */
+
+#include "log.h"
+#include "entropymap.h"
+#include "elapsedtime.h"
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <boost/filesystem.hpp>
+
+using namespace cv;
+using namespace std;
+using namespace gc;
+namespace fs = boost::filesystem;
+
+static const int KERNEL_SIZES[] = { 3, DEFAULT_ENTROPY_KERN_SIZE, 9, 16 };
+
+class TestImage
+{
+public:
+    TestImage( const string imgName, const Mat &image ) : name( imgName ), img( image ) {}
+
+    string name;
+    Mat img;
+};
+
+static void AddSyntheticImages( vector< TestImage > &images )
+{
+    mt19937 gen( 42 );
+    uniform_int_distribution< int > level( 0, 255 );
+    Mat noise( 131, 257, CV_8UC1 );
+    for ( int row = 0; row < noise.rows; ++row )
+    {
+        for ( int col = 0; col < noise.cols; ++col )
+            noise.at< uchar >( row, col ) = static_cast< uchar >( level( gen ) );
+    }
+    images.push_back( TestImage( "noise_257x131", noise ) );
+
+    Mat gradient( 203, 322, CV_8UC1 );
+    for ( int row = 0; row < gradient.rows; ++row )
+    {
+        for ( int col = 0; col < gradient.cols; ++col )
+            gradient.at< uchar >( row, col ) = saturate_cast< uchar >( ( row + col ) * 255 / ( gradient.rows + gradient.cols ) );
+    }
+    images.push_back( TestImage( "gradient_322x203", gradient ) );
+
+    // a flat image with a few bright spots, most kernels hold a single bin
+    Mat spots = Mat::zeros( 97, 113, CV_8UC1 );
+    uniform_int_distribution< int > radius( 1, 5 );
+    for ( int i = 0; i < 20; ++i )
+    {
+        Point center( uniform_int_distribution< int >( 0, spots.cols - 1 )( gen ), uniform_int_distribution< int >( 0, spots.rows - 1 )( gen ) );
+        circle( spots, center, radius( gen ), Scalar( level( gen ) ), FILLED );
+    }
+    images.push_back( TestImage( "spots_113x97", spots ) );
+}
+static void AddFolderImages( const string folder, vector< TestImage > &images )
+{
+    vector< string > filepaths;
+    for ( fs::recursive_directory_iterator it( folder ), end; it != end; ++it )
+    {
+        string ext = it->path().extension().string();
+        if ( fs::is_regular_file( it->path() ) && ( ".jpg" == ext || ".png" == ext ) )
+            filepaths.push_back( it->path().string() );
+    }
+    sort( filepaths.begin(), filepaths.end() );
+    for ( size_t i = 0; i < filepaths.size(); ++i )
+    {
+        Mat img = imread( filepaths[ i ], IMREAD_GRAYSCALE );
+        if ( img.empty() )
+            cout << "Could not read " << filepaths[ i ] << endl;
+        else
+            images.push_back( TestImage( fs::path( filepaths[ i ] ).filename().string(), img ) );
+    }
+}
+
+int main( int argc, char *argv[] )
+{
+    vector< TestImage > images;
+    AddSyntheticImages( images );
+    if ( 1 < argc )
+        AddFolderImages( argv[ 1 ], images );
+
+    int failures = 0;
+    double slidingMsecs = 0.0;
+    double referenceMsecs = 0.0;
+    EntropyMap entropy;
+    Mat mapSliding, mapReference;
+
+    cout << "image,kernel,ellipse,max_diff,sliding_msecs,reference_msecs" << endl;
+    for ( size_t i = 0; i < images.size(); ++i )
+    {
+        for ( size_t k = 0; k < sizeof( KERNEL_SIZES ) / sizeof( KERNEL_SIZES[ 0 ] ); ++k )
+        {
+            for ( int useEllipse = 1; useEllipse >= 0; --useEllipse )
+            {
+                chrono::steady_clock::time_point start = chrono::steady_clock::now();
+                GC_STATUS retSliding = entropy.CalcMap( images[ i ].img, mapSliding, KERNEL_SIZES[ k ], 1 == useEllipse );
+                double msecsSliding = MsecsSince( start );
+
+                start = chrono::steady_clock::now();
+                GC_STATUS retReference = entropy.CalcMapReference( images[ i ].img, mapReference, KERNEL_SIZES[ k ], 1 == useEllipse );
+                double msecsReference = MsecsSince( start );
+
+                double maxDiff = -1.0;
+                if ( GC_OK == retSliding && GC_OK == retReference && mapSliding.size() == mapReference.size() )
+                    maxDiff = norm( mapSliding, mapReference, NORM_INF );
+                if ( 0.0 != maxDiff )
+                    ++failures;
+                slidingMsecs += msecsSliding;
+                referenceMsecs += msecsReference;
+
+                cout << images[ i ].name << "," << KERNEL_SIZES[ k ] << "," << useEllipse << "," << maxDiff << ","
+                     << fixed << setprecision( 2 ) << msecsSliding << "," << msecsReference << endl;
+                cout.unsetf( ios::fixed );
+            }
+        }
+    }
+
+    cout << fixed << setprecision( 1 ) << "total sliding msecs=" << slidingMsecs << " reference msecs=" << referenceMsecs << endl;
+    cout << ( 0 == failures ? "PASS" : "FAIL" ) << " failures=" << failures << endl;
+
+    return 0 == failures ? 0 : -1;
+}
@@ -0,0 +1,42 @@
+TEMPLATE = app
+include( ../tests.pri )
+
+# qmake CONFIG+=debug_find_line times the line find with its diagnostic images written to /var/tmp/water/
+debug_find_line {
+    DEFINES += DEBUG_FIND_LINE
+}
+
+SOURCES += \
+        ../../algorithms/animate.cpp \
+        ../../algorithms/calib.cpp \
+        ../../algorithms/calibcache.cpp \
+        ../../algorithms/csvreader.cpp \
+        ../../algorithms/findcalibgrid.cpp \
+        ../../algorithms/findline.cpp \
+        ../../algorithms/imageloader.cpp \
+        ../../algorithms/kalman.cpp \
+        ../../algorithms/metadata.cpp \
+        ../../algorithms/resultsink.cpp \
+        ../../algorithms/templatematchdft.cpp \
+        ../../algorithms/visapp.cpp \
+        main.cpp
+
+HEADERS += \
+    ../elapsedtime.h \
+    ../../algorithms/animate.h \
+    ../../algorithms/bresenham.h \
+    ../../algorithms/calib.h \
+    ../../algorithms/calibcache.h \
+    ../../algorithms/csvreader.h \
+    ../../algorithms/findcalibgrid.h \
+    ../../algorithms/findline.h \
+    ../../algorithms/imageloader.h \
+    ../../algorithms/kalman.h \
+    ../../algorithms/gc_types.h \
+    ../../algorithms/log.h \
+    ../../algorithms/metadata.h \
+    ../../algorithms/resultsink.h \
+    ../../algorithms/templatematchdft.h \
+    ../../algorithms/timestampconvert.h \
+    ../../algorithms/visapp.h \
+    ../../algorithms/wincmd.h
@@ -0,0 +1,126 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+   Copyright 2021 Kenneth W. Chapman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/** \file main.cpp
+ * @brief Times the line find of every image of a folder
+ *
+ * VisApp::CalcLine() is run on every jpg and png image below a folder, the first image is run
+ * once more beforehand so the calibration load is not timed. The mean and median
+ * milliseconds per image are printed. Build it once as is and once with
+ * qmake CONFIG+=debug_find_line to compare the line find with and without the
+ * DEBUG_FIND_LINE diagnostic images. The image timestamps are taken from the filenames of
+ * the 2012_demo images (yy-mm-dd-HH-MM at position 10).
+ *
+ * findline_bench <image folder> <calib json> [repeats, default 3]
+ *
+ * e.g. findline_bench gcgui/config/2012_demo gcgui/config/calib.json
+ *
+ * \author Kenneth W. Chapman
+ * \copyright Copyright (C) 2010-2021, Kenneth W. Chapman <coffeesig@gmail.com>, all rights reserved.\n
+ * This project is released under the Apache License, Version 2.0.
+ * \bug No known bugs.
+ */
+
+#include "log.h"
+#include "visapp.h"
+#include "elapsedtime.h"
+#include <string>
+#include <vector>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <boost/filesystem.hpp>
+
+using namespace std;
+using namespace gc;
+namespace fs = boost::filesystem;
+
+static const int DEMO_TIMESTAMP_START_POS = 10;
+static const string DEMO_TIMESTAMP_FORMAT = "yy-mm-dd-HH-MM";
+
+
+int main( int argc, char *argv[] )
+{
+    if ( 3 > argc )
+    {
+        cout << "Usage: findline_bench <image folder> <calib json> [repeats, default 3]" << endl;
+        return -1;
+    }
+    int repeats = 3 < argc ? std::max( 1, atoi( argv[ 3 ] ) ) : 3;
+
+    vector< string > images;
+    for ( fs::recursive_directory_iterator it( argv[ 1 ] ), end; it != end; ++it )
+    {
+        string ext = it->path().extension().string();
+        if ( fs::is_regular_file( it->path() ) && ( ".jpg" == ext || ".png" == ext ) )
+            images.push_back( it->path().string() );
+    }
+    sort( images.begin(), images.end() );
+    if ( images.empty() )
+    {
+        cout << "No images found in " << argv[ 1 ] << endl;
+        return -1;
+    }
+
+    FindLineParams params;
+    params.calibFilepath = argv[ 2 ];
+    params.timeStampType = FROM_FILENAME;
+    params.timeStampStartPos = DEMO_TIMESTAMP_START_POS;
+    params.timeStampFormat = DEMO_TIMESTAMP_FORMAT;
+
+    VisApp visApp;
+    FindLineResult result;
+    params.imagePath = images[ 0 ];
+    visApp.CalcLine( params, result );
+
+    int failures = 0;
+    vector< double > msecs;
+    for ( int rep = 0; rep < repeats; ++rep )
+    {
+        for ( size_t i = 0; i < images.size(); ++i )
+        {
+            params.imagePath = images[ i ];
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            GC_STATUS retVal = visApp.CalcLine( params, result );
+            msecs.push_back( MsecsSince( start ) );
+            if ( GC_OK != retVal )
+            {
+                if ( 0 == rep )
+                    cout << "Line find failed: " << images[ i ] << endl;
+                ++failures;
+            }
+        }
+    }
+
+    double total = 0.0;
+    for ( size_t i = 0; i < msecs.size(); ++i )
+        total += msecs[ i ];
+    sort( msecs.begin(), msecs.end() );
+
+#ifdef DEBUG_FIND_LINE
+    cout << "DEBUG_FIND_LINE=on" << endl;
+#else
+    cout << "DEBUG_FIND_LINE=off" << endl;
+#endif
+    cout << fixed << setprecision( 2 ) << "images=" << images.size() << " repeats=" << repeats
+         << " mean msecs=" << total / static_cast< double >( msecs.size() )
+         << " median msecs=" << msecs[ msecs.size() / 2 ]
+         << " max msecs=" << msecs.back() << endl;
+    cout << ( 0 == failures ? "PASS" : "FAIL" ) << " failures=" << failures << endl;
+
+    return 0 == failures ? 0 : -1;
+}
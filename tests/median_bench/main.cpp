@@ -0,0 +1,152 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+   Copyright 2021 Kenneth W. Chapman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/** \file main.cpp
+ * @brief Compares the sliding window row sum median filter with the nth_element filter it replaced
+ *
+ * FindLine::MedianFilter() and a copy of the median filter it replaced, which refilled a
+ * vector and ran nth_element for every sample, are run on the same random walk row sum
+ * profiles of 500 to 4000 samples. The outputs must be identical, the microseconds per
+ * profile of both filters are printed.
+ *
+ * median_bench [runs per profile length, default 1000]
+ *
+ * \author Kenneth W. Chapman
+ * \copyright Copyright (C) 2010-2021, Kenneth W. Chapman <coffeesig@gmail.com>, all rights reserved.\n
+ * This project is released under the Apache License, Version 2.0.
+ * \bug No known bugs.
+ */
+
+#include "log.h"
+#include "findline.h"
+#include "elapsedtime.h"
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+using namespace std;
+using namespace gc;
+
+static const size_t PROFILE_LENGTHS[] = { 500, 1000, 2000, 4000 };
+static const size_t KERNEL_SIZES[] = { 9, 15, 21 };
+
+// the median filter FindLine used before the sliding window, the values are taken by value as they were
+static GC_STATUS NthElementMedianFilter( const size_t kernSize, const vector< uint > values, vector< uint > &valuesOut )
+{
+    GC_STATUS retVal = values.empty() || 3 > kernSize || kernSize * 2 > values.size() ? GC_ERR : GC_OK;
+    if ( GC_OK == retVal )
+    {
+        valuesOut.clear();
+        vector< uint > sortVec;
+        size_t halfVec, kernHalf = kernSize >> 1;
+        for ( size_t i = 0; i < kernHalf; ++i )
+        {
+            sortVec.clear();
+            for ( size_t j = 0; j < kernHalf + i; j++ )
+                sortVec.push_back( values[ j ] );
+            halfVec = sortVec.size() / 2;
+            nth_element( sortVec.begin(), sortVec.begin() + static_cast< int >( halfVec ), sortVec.end() );
+            if ( 0 == sortVec.size() % 2 )
+                valuesOut.push_back( ( sortVec[ halfVec ] + sortVec[ halfVec + 1 ] ) / 2 );
+            else
+                valuesOut.push_back( sortVec[ halfVec ] );
+        }
+        for ( int i = static_cast< int >( kernHalf ); i < static_cast< int >( values.size() - kernHalf ); ++i )
+        {
+            sortVec.clear();
+            for ( int j = -static_cast< int >( kernHalf ); j < static_cast< int >( kernHalf ); j++ )
+                sortVec.push_back( values[ static_cast< size_t >( i + j ) ] );
+            nth_element( sortVec.begin(), sortVec.begin() + static_cast< int >( kernHalf ), sortVec.end() );
+            valuesOut.push_back( sortVec[ kernHalf ] );
+        }
+        for ( size_t i = values.size() - kernHalf; i < values.size(); ++i )
+        {
+            sortVec.clear();
+            for ( size_t j = i - kernHalf; j < values.size(); j++ )
+                sortVec.push_back( values[ j ] );
+            halfVec = sortVec.size() / 2;
+            nth_element( sortVec.begin(), sortVec.begin() + static_cast< int >( halfVec ), sortVec.end() );
+            if ( 0 == sortVec.size() % 2 )
+                valuesOut.push_back( ( sortVec[ halfVec ] + sortVec[ halfVec + 1 ] ) / 2 );
+            else
+                valuesOut.push_back( sortVec[ halfVec ] );
+        }
+    }
+    return retVal;
+}
+// row sums of a 100 pixel wide swath, a random walk with noise
+static void MakeProfile( mt19937 &gen, const size_t length, vector< uint > &profile )
+{
+    normal_distribution< double > step( 0.0, 150.0 );
+    normal_distribution< double > noise( 0.0, 400.0 );
+    double level = 12800.0;
+    profile.resize( length );
+    for ( size_t i = 0; i < length; ++i )
+    {
+        level = std::min( 25500.0, std::max( 0.0, level + step( gen ) ) );
+        profile[ i ] = static_cast< uint >( std::min( 25500.0, std::max( 0.0, level + noise( gen ) ) ) );
+    }
+}
+
+int main( int argc, char *argv[] )
+{
+    int runs = 1 < argc ? std::max( 1, atoi( argv[ 1 ] ) ) : 1000;
+
+    int mismatches = 0;
+    mt19937 gen( 42 );
+    vector< vector< uint > > profiles( static_cast< size_t >( runs ) );
+    vector< uint > outOld, outNew, sortBuf, window;
+
+    cout << "length,kernel,nth_element_usecs,sliding_usecs,speedup" << endl;
+    for ( size_t l = 0; l < sizeof( PROFILE_LENGTHS ) / sizeof( PROFILE_LENGTHS[ 0 ] ); ++l )
+    {
+        for ( size_t i = 0; i < profiles.size(); ++i )
+            MakeProfile( gen, PROFILE_LENGTHS[ l ], profiles[ i ] );
+
+        for ( size_t k = 0; k < sizeof( KERNEL_SIZES ) / sizeof( KERNEL_SIZES[ 0 ] ); ++k )
+        {
+            for ( size_t i = 0; i < profiles.size(); ++i )
+            {
+                GC_STATUS retOld = NthElementMedianFilter( KERNEL_SIZES[ k ], profiles[ i ], outOld );
+                GC_STATUS retNew = FindLine::MedianFilter( KERNEL_SIZES[ k ], profiles[ i ], outNew, sortBuf, window );
+                if ( GC_OK != retOld || GC_OK != retNew || outOld != outNew )
+                    ++mismatches;
+            }
+
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            for ( size_t i = 0; i < profiles.size(); ++i )
+                NthElementMedianFilter( KERNEL_SIZES[ k ], profiles[ i ], outOld );
+            double usecsOld = UsecsSince( start ) / static_cast< double >( runs );
+
+            start = chrono::steady_clock::now();
+            for ( size_t i = 0; i < profiles.size(); ++i )
+                FindLine::MedianFilter( KERNEL_SIZES[ k ], profiles[ i ], outNew, sortBuf, window );
+            double usecsNew = UsecsSince( start ) / static_cast< double >( runs );
+
+            cout << PROFILE_LENGTHS[ l ] << "," << KERNEL_SIZES[ k ] << "," << fixed << setprecision( 2 )
+                 << usecsOld << "," << usecsNew << "," << usecsOld / usecsNew << endl;
+            cout.unsetf( ios::fixed );
+        }
+    }
+
+    cout << ( 0 == mismatches ? "PASS" : "FAIL" ) << " mismatches=" << mismatches << endl;
+
+    return 0 == mismatches ? 0 : -1;
+}
@@ -0,0 +1,17 @@
+TEMPLATE = app
+include( ../tests.pri )
+
+SOURCES += \
+        ../../algorithms/findcalibgrid.cpp \
+        ../../algorithms/findline.cpp \
+        ../../algorithms/templatematchdft.cpp \
+        main.cpp
+
+HEADERS += \
+    ../elapsedtime.h \
+    ../../algorithms/bresenham.h \
+    ../../algorithms/findcalibgrid.h \
+    ../../algorithms/findline.h \
+    ../../algorithms/gc_types.h \
+    ../../algorithms/log.h \
+    ../../algorithms/templatematchdft.h
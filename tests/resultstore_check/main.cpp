@@ -0,0 +1,243 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+   Copyright 2021 Kenneth W. Chapman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/** \file main.cpp
+ * @brief Checks that the rows appended to a result store are read back by its reader
+ *
+ * Rows are appended to a store in the temp folder across several blocks and the store is
+ * closed. A further block is appended, then cut in half as if its write had been interrupted,
+ * and bytes that no index entry accounts for are added after it. Reopening the writer must
+ * drop both, and the rows appended after the reopen must follow the complete blocks. Query()
+ * must return one span per block for the whole time range, the rows of a range that crosses
+ * a block boundary, and no spans outside the stored times. Every column of every row read
+ * back must equal the row appended, with nan where the filtered level was not set and in the
+ * found point slots a row did not fill.
+ *
+ * resultstore_check
+ *
+ * \author Kenneth W. Chapman
+ * \copyright Copyright (C) 2010-2021, Kenneth W. Chapman <coffeesig@gmail.com>, all rights reserved.\n
+ * This project is released under the Apache License, Version 2.0.
+ * \bug No known bugs.
+ */
+
+#include "log.h"
+#include "resultstore.h"
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <boost/filesystem.hpp>
+
+using namespace cv;
+using namespace std;
+using namespace gc;
+namespace fs = boost::filesystem;
+
+static const size_t POINTS_PER_ROW = 4;                     // fewer than some rows find, so points are dropped
+static const int64_t FIRST_TIME = 1341053100;               // 2012-06-30T10:45:00
+static const int64_t TIME_STEP = 60;
+
+static ResultStoreRow MakeRow( const size_t index )
+{
+    ResultStoreRow row;
+    double level = static_cast< double >( index ) * 0.01;
+    row.timestamp = FIRST_TIME + static_cast< int64_t >( index ) * TIME_STEP;
+    row.findSuccess = 0 != index % 7;
+    row.waterLevel = level;
+    row.waterLevelAdjusted = level - 0.5;
+    row.waterLevelFiltered = 0 == index % 3 ? numeric_limits< double >::quiet_NaN() : level - 0.25;
+    row.moveOffset = Point2d( static_cast< double >( index % 5 ), -static_cast< double >( index % 11 ) );
+    row.moveOffsetWorld = row.moveOffset * 0.1;
+    for ( size_t i = 0; i < index % ( POINTS_PER_ROW + 3 ); ++i )
+        row.foundPoints.push_back( Point2d( static_cast< double >( i ), level + static_cast< double >( i ) ) );
+    return row;
+}
+static GC_STATUS AppendRows( ResultStoreWriter &writer, const size_t first, const size_t count, vector< ResultStoreRow > &rows )
+{
+    GC_STATUS retVal = GC_OK;
+    for ( size_t i = first; GC_OK == retVal && i < first + count; ++i )
+    {
+        ResultStoreRow row = MakeRow( i );
+        retVal = writer.Append( row );
+        rows.push_back( row );
+    }
+    return retVal;
+}
+static bool SameValue( const double a, const double b )
+{
+    return a == b || ( std::isnan( a ) && std::isnan( b ) );
+}
+static bool SameRow( const ResultStoreRow &row, const ResultStoreSpan &span, const size_t i )
+{
+    size_t pointCount = std::min( row.foundPoints.size(), span.pointsPerRow );
+    bool isSame = row.timestamp == span.timestamps[ i ] &&
+                  ( row.findSuccess ? 1 : 0 ) == span.findSuccess[ i ] &&
+                  SameValue( row.waterLevel, span.waterLevel[ i ] ) &&
+                  SameValue( row.waterLevelAdjusted, span.waterLevelAdjusted[ i ] ) &&
+                  SameValue( row.waterLevelFiltered, span.waterLevelFiltered[ i ] ) &&
+                  SameValue( row.moveOffset.x, span.moveOffsetX[ i ] ) &&
+                  SameValue( row.moveOffset.y, span.moveOffsetY[ i ] ) &&
+                  SameValue( row.moveOffsetWorld.x, span.moveOffsetWorldX[ i ] ) &&
+                  SameValue( row.moveOffsetWorld.y, span.moveOffsetWorldY[ i ] ) &&
+                  pointCount == span.foundPointCount[ i ];
+
+    // slots beyond the points of the row are nan
+    const double *points = span.foundPoints + i * 2 * span.pointsPerRow;
+    for ( size_t j = 0; isSame && j < span.pointsPerRow; ++j )
+    {
+        double x = j < pointCount ? row.foundPoints[ j ].x : numeric_limits< double >::quiet_NaN();
+        double y = j < pointCount ? row.foundPoints[ j ].y : numeric_limits< double >::quiet_NaN();
+        isSame = SameValue( x, points[ 2 * j ] ) && SameValue( y, points[ 2 * j + 1 ] );
+    }
+    return isSame;
+}
+// queries the times of the rows made with indices first to last, rows holds the stored rows in time order
+static int CheckQuery( const ResultStoreReader &reader, const string name, const vector< ResultStoreRow > &rows,
+                       const size_t first, const size_t last, const vector< size_t > &spanRows )
+{
+    int failures = 0;
+    int64_t startTime = FIRST_TIME + static_cast< int64_t >( first ) * TIME_STEP;
+    int64_t endTime = FIRST_TIME + static_cast< int64_t >( last ) * TIME_STEP;
+    vector< ResultStoreSpan > spans;
+    GC_STATUS retVal = reader.Query( startTime, endTime, spans );
+    if ( GC_OK != retVal || spanRows.size() != spans.size() )
+    {
+        cout << name << ": " << spans.size() << " spans, expected " << spanRows.size() << endl;
+        ++failures;
+    }
+    else
+    {
+        size_t rowIdx = 0;
+        while ( rowIdx < rows.size() && rows[ rowIdx ].timestamp < startTime )
+            ++rowIdx;
+        for ( size_t i = 0; i < spans.size(); ++i )
+        {
+            if ( spanRows[ i ] != spans[ i ].rowCount || POINTS_PER_ROW != spans[ i ].pointsPerRow )
+            {
+                cout << name << ": span " << i << " has " << spans[ i ].rowCount << " rows, expected " << spanRows[ i ] << endl;
+                ++failures;
+                break;
+            }
+            for ( size_t j = 0; j < spans[ i ].rowCount; ++j, ++rowIdx )
+            {
+                if ( rows.size() <= rowIdx || !SameRow( rows[ rowIdx ], spans[ i ], j ) )
+                {
+                    cout << name << ": row " << rowIdx << " does not match the row appended" << endl;
+                    ++failures;
+                }
+            }
+        }
+    }
+    cout << name << ": spans=" << spans.size() << ( 0 == failures ? " ok" : " FAILED" ) << endl;
+    return failures;
+}
+
+int main()
+{
+    Output2FILE::Stream() = stderr;
+
+    int failures = 0;
+    string storePath = ( fs::temp_directory_path() / "resultstore_check.gcrs" ).string();
+    string indexPath = storePath + RESULT_STORE_INDEX_EXTENSION;
+    fs::remove( storePath );
+    fs::remove( indexPath );
+
+    // two full blocks written by Append() and a partial one written by Close()
+    const size_t firstCount = 2 * RESULT_STORE_BLOCK_ROWS + 100;
+    vector< ResultStoreRow > rows;
+    ResultStoreWriter writer;
+    GC_STATUS retVal = writer.Open( storePath, POINTS_PER_ROW );
+    if ( GC_OK == retVal )
+        retVal = AppendRows( writer, 0, firstCount, rows );
+    if ( GC_OK == retVal )
+        retVal = writer.Close();
+    uintmax_t completeSize = GC_OK == retVal ? fs::file_size( storePath ) : 0;
+
+    // a fourth block whose write is cut short, followed by bytes no index entry accounts for
+    vector< ResultStoreRow > lostRows;
+    if ( GC_OK == retVal )
+        retVal = writer.Open( storePath );
+    if ( GC_OK == retVal )
+        retVal = AppendRows( writer, firstCount, 50, lostRows );
+    if ( GC_OK == retVal )
+        retVal = writer.Close();
+    if ( GC_OK == retVal )
+    {
+        uintmax_t fullSize = fs::file_size( storePath );
+        fs::resize_file( storePath, completeSize + ( fullSize - completeSize ) / 2 );
+        ofstream junk( storePath, ios::out | ios::binary | ios::app );
+        junk << "interrupted write";
+    }
+
+    // the reopened writer keeps the three complete blocks and appends after them
+    const size_t secondCount = 200;
+    if ( GC_OK == retVal )
+        retVal = writer.Open( storePath );
+    if ( GC_OK == retVal && completeSize != fs::file_size( storePath ) )
+    {
+        cout << "reopen kept " << fs::file_size( storePath ) << " bytes, expected " << completeSize << endl;
+        ++failures;
+    }
+    if ( GC_OK == retVal )
+        retVal = AppendRows( writer, firstCount + lostRows.size(), secondCount, rows );
+    if ( GC_OK == retVal )
+        retVal = writer.Close();
+    if ( GC_OK != retVal )
+    {
+        cout << "Could not write result store " << storePath << endl;
+        ++failures;
+    }
+
+    ResultStoreReader reader;
+    if ( GC_OK == retVal )
+    {
+        retVal = reader.Open( storePath );
+        if ( GC_OK != retVal || rows.size() != reader.RowCount() || POINTS_PER_ROW != reader.PointsPerRow() )
+        {
+            cout << "reader found " << reader.RowCount() << " rows, expected " << rows.size() << endl;
+            ++failures;
+        }
+        else
+        {
+            // the rows of the cut block were made but are not in the store
+            size_t lastRow = firstCount + lostRows.size() + secondCount - 1;
+
+            vector< size_t > spanRows = { RESULT_STORE_BLOCK_ROWS, RESULT_STORE_BLOCK_ROWS, 100, secondCount };
+            failures += CheckQuery( reader, "all", rows, 0, lastRow, spanRows );
+
+            spanRows = { 96, 105 };
+            failures += CheckQuery( reader, "block boundary", rows, RESULT_STORE_BLOCK_ROWS - 96,
+                                    RESULT_STORE_BLOCK_ROWS + 104, spanRows );
+
+            spanRows = { 1 };
+            failures += CheckQuery( reader, "last row", rows, lastRow, lastRow, spanRows );
+
+            spanRows.clear();
+            failures += CheckQuery( reader, "after last row", rows, lastRow + 1, lastRow + 1000, spanRows );
+            failures += CheckQuery( reader, "cut block", rows, firstCount, firstCount + lostRows.size() - 1, spanRows );
+        }
+        reader.Close();
+    }
+    fs::remove( storePath );
+    fs::remove( indexPath );
+
+    cout << ( 0 == failures ? "PASS" : "FAIL" ) << " failures=" << failures << endl;
+
+    return 0 == failures ? 0 : -1;
+}
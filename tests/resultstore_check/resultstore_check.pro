@@ -0,0 +1,12 @@
+TEMPLATE = app
+include( ../tests.pri )
+
+SOURCES += \
+        ../../algorithms/resultstore.cpp \
+        main.cpp
+
+HEADERS += \
+    ../../algorithms/gc_types.h \
+    ../../algorithms/log.h \
+    ../../algorithms/resultstore.h \
+    ../../algorithms/timestampconvert.h
@@ -0,0 +1,388 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+   Copyright 2021 Kenneth W. Chapman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/** \file main.cpp
+ * @brief Compares the DFT template match engine with cv::matchTemplate()
+ *
+ * Two sets of rotated templates are cut from each image the way the searches use them: 31
+ * anchor models from -7.5 to +7.5 degrees matched against the whole image, and 21 bowtie
+ * sized templates from -10 to +10 degrees matched in a region half a template larger than
+ * the template. Every match space of TemplateMatchDFT must be within the tolerance of the
+ * cv::matchTemplate() match space at every position. Both match spaces are also compared with
+ * scores summed directly in double precision at the best match and at random positions, so a
+ * difference can be traced to the engine that rounds. The bowtie calibration target search
+ * of FindCalibGrid is also run with both engines and must find the same targets, and the anchor
+ * search of FindAnchor must find the same angle and offset in a rotated and shifted copy of each
+ * image with both engines, and the same angle and offset as the serial search of the rotated
+ * models it replaced.
+ *
+ * templatematch_compare [image folder] [tolerance, default 1e-4]
+ *
+ * e.g. templatematch_compare gcgui/config/2012_demo
+ *
+ * \author Kenneth W. Chapman
+ * \copyright Copyright (C) 2010-2021, Kenneth W. Chapman <coffeesig@gmail.com>, all rights reserved.\n
+ * This project is released under the Apache License, Version 2.0.
+ * \bug No known bugs.
+ */
+
+#include "log.h"
+#include "findanchor.h"
+#include "findcalibgrid.h"
+#include "templatematchdft.h"
+#include "elapsedtime.h"
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <boost/filesystem.hpp>
+
+using namespace cv;
+using namespace std;
+using namespace gc;
+namespace fs = boost::filesystem;
+
+static const int EXACT_SAMPLE_COUNT = 64;           // random positions per template scored in double precision
+static const double ANCHOR_MOVE_ANGLE = 2.0;        // rotation of the image searched for the anchor
+static const Point ANCHOR_MOVE_SHIFT( 9, -6 );      // shift of the image searched for the anchor
+
+class TestImage
+{
+public:
+    TestImage( const string imgName, const Mat &image ) : name( imgName ), img( image ) {}
+
+    string name;
+    Mat img;
+};
+
+class CompareResult
+{
+public:
+    CompareResult() : maxDiff( -1.0 ), spatialErr( 0.0 ), dftErr( 0.0 ), spatialMsecs( 0.0 ), dftMsecs( 0.0 ) {}
+
+    double maxDiff;
+    double spatialErr;
+    double dftErr;
+    double spatialMsecs;
+    double dftMsecs;
+};
+
+static void AddSyntheticImages( vector< TestImage > &images )
+{
+    // smoothed noise so the windows have the texture of a real scene
+    mt19937 gen( 42 );
+    uniform_int_distribution< int > level( 0, 255 );
+    Mat noise( 301, 417, CV_8UC1 );
+    for ( int row = 0; row < noise.rows; ++row )
+    {
+        for ( int col = 0; col < noise.cols; ++col )
+            noise.at< uchar >( row, col ) = static_cast< uchar >( level( gen ) );
+    }
+    GaussianBlur( noise, noise, Size( 7, 7 ), 2.0 );
+    images.push_back( TestImage( "noise_417x301", noise ) );
+}
+static void AddFolderImages( const string folder, vector< TestImage > &images )
+{
+    vector< string > filepaths;
+    for ( fs::recursive_directory_iterator it( folder ), end; it != end; ++it )
+    {
+        string ext = it->path().extension().string();
+        if ( fs::is_regular_file( it->path() ) && ( ".jpg" == ext || ".png" == ext ) )
+            filepaths.push_back( it->path().string() );
+    }
+    sort( filepaths.begin(), filepaths.end() );
+    for ( size_t i = 0; i < filepaths.size(); ++i )
+    {
+        Mat img = imread( filepaths[ i ], IMREAD_GRAYSCALE );
+        if ( img.empty() )
+            cout << "Could not read " << filepaths[ i ] << endl;
+        else
+            images.push_back( TestImage( fs::path( filepaths[ i ] ).filename().string(), img ) );
+    }
+}
+static void MakeRotatedTemplates( const Mat &img, const Rect rect, const int count, const double angleInc, vector< Mat > &templates )
+{
+    Mat rotated;
+    Point2d ptCenter( static_cast< double >( rect.x ) + static_cast< double >( rect.width ) / 2.0,
+                      static_cast< double >( rect.y ) + static_cast< double >( rect.height ) / 2.0 );
+    templates.clear();
+    for ( int i = 0; i < count; ++i )
+    {
+        double angle = static_cast< double >( i - count / 2 ) * angleInc;
+        warpAffine( img, rotated, getRotationMatrix2D( ptCenter, angle, 1.0 ), img.size(), INTER_CUBIC );
+        templates.push_back( rotated( rect ).clone() );
+    }
+}
+// score of one position summed directly in double precision, zero where cv::matchTemplate() has no defined score
+static double ExactScore( const Mat &img, const Mat &templ, const Point pos, const int method )
+{
+    double area = static_cast< double >( templ.total() );
+    Mat wnd = img( Rect( pos, templ.size() ) );
+    double templMean = TM_CCOEFF_NORMED == method ? cv::sum( templ )[ 0 ] / area : 0.0;
+    double wndMean = TM_CCOEFF_NORMED == method ? cv::sum( wnd )[ 0 ] / area : 0.0;
+    double num = 0.0, templSq = 0.0, wndSq = 0.0;
+    for ( int row = 0; row < templ.rows; ++row )
+    {
+        const uchar *pTempl = templ.ptr< uchar >( row );
+        const uchar *pWnd = wnd.ptr< uchar >( row );
+        for ( int col = 0; col < templ.cols; ++col )
+        {
+            double t = static_cast< double >( pTempl[ col ] ) - templMean;
+            double w = static_cast< double >( pWnd[ col ] ) - wndMean;
+            num += t * w;
+            templSq += t * t;
+            wndSq += w * w;
+        }
+    }
+    return 0.0 < templSq * wndSq ? num / sqrt( templSq * wndSq ) : 0.0;
+}
+static void ExactErrors( const Mat &img, const Mat &templ, const Mat &space, const Mat &spaceDFT, const int method,
+                         mt19937 &gen, CompareResult &result )
+{
+    Point ptMax;
+    minMaxLoc( space, nullptr, nullptr, nullptr, &ptMax );
+    uniform_int_distribution< int > col( 0, space.cols - 1 ), row( 0, space.rows - 1 );
+    for ( int i = 0; i <= EXACT_SAMPLE_COUNT; ++i )
+    {
+        Point pos = 0 == i ? ptMax : Point( col( gen ), row( gen ) );
+        double exact = ExactScore( img, templ, pos, method );
+        result.spatialErr = std::max( result.spatialErr, fabs( static_cast< double >( space.at< float >( pos ) ) - exact ) );
+        result.dftErr = std::max( result.dftErr, fabs( static_cast< double >( spaceDFT.at< float >( pos ) ) - exact ) );
+    }
+}
+static GC_STATUS Compare( const Mat &img, const vector< Mat > &templates, const int method, CompareResult &result )
+{
+    TemplateMatchDFT matchDFT;
+    GC_STATUS retVal = matchDFT.SetTemplates( templates );
+    if ( GC_OK == retVal )
+    {
+        // the template spectra are calculated by the first search of an image size, the time
+        // of a search with the spectra already cached is the one measured
+        DFTSearchImage searchDFT;
+        retVal = matchDFT.SetImage( img, searchDFT );
+
+        vector< Mat > spaces( templates.size() );
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        for ( size_t i = 0; i < templates.size(); ++i )
+            matchTemplate( img, templates[ i ], spaces[ i ], method );
+        result.spatialMsecs = MsecsSince( start );
+
+        vector< Mat > spacesDFT( templates.size() );
+        start = chrono::steady_clock::now();
+        if ( GC_OK == retVal )
+            retVal = matchDFT.SetImage( img, searchDFT );
+        for ( size_t i = 0; GC_OK == retVal && i < templates.size(); ++i )
+            retVal = matchDFT.Match( searchDFT, i, method, spacesDFT[ i ] );
+        result.dftMsecs = MsecsSince( start );
+
+        mt19937 gen( 7 );
+        result.maxDiff = 0.0;
+        for ( size_t i = 0; GC_OK == retVal && i < templates.size(); ++i )
+        {
+            if ( spaces[ i ].size() != spacesDFT[ i ].size() )
+            {
+                retVal = GC_ERR;
+            }
+            else
+            {
+                result.maxDiff = std::max( result.maxDiff, norm( spaces[ i ], spacesDFT[ i ], NORM_INF ) );
+                ExactErrors( img, templates[ i ], spaces[ i ], spacesDFT[ i ], method, gen, result );
+            }
+        }
+    }
+    return retVal;
+}
+static GC_STATUS FindTargets( const Mat &img, const GC_MATCH_ENGINE engine, vector< Point2d > &pts )
+{
+    FindCalibGrid findGrid;
+    findGrid.SetMatchEngine( engine );
+    pts.clear();
+    GC_STATUS retVal = findGrid.InitBowtieTemplate( GC_BOWTIE_TEMPLATE_DIM, img.size() );
+    if ( GC_OK == retVal )
+        retVal = findGrid.FindTargets( img, MIN_BOWTIE_FIND_SCORE );
+    if ( GC_OK == retVal )
+    {
+        vector< vector< Point2d > > rows;
+        retVal = findGrid.GetFoundPoints( rows );
+        for ( size_t i = 0; i < rows.size(); ++i )
+            pts.insert( pts.end(), rows[ i ].begin(), rows[ i ].end() );
+    }
+    return retVal;
+}
+// the anchor is set from a file, as the applications set it
+static GC_STATUS FindAnchorModel( const string refFilepath, const Rect rect, const Mat &img, const GC_MATCH_ENGINE engine,
+                                  double &angle, Point &offset )
+{
+    FindAnchor anchor;
+    GC_STATUS retVal = anchor.SetMatchEngine( engine );
+    if ( GC_OK == retVal )
+        retVal = anchor.SetRef( refFilepath, rect );
+    if ( GC_OK == retVal )
+        retVal = anchor.Find( img, angle, offset );
+    return retVal;
+}
+// the serial search the anchor search replaced, models made as FindAnchor::SetRef makes them
+static void FindAnchorSerial( const Mat &imgRef, const Rect rect, const Mat &img, double &angle, Point &offset )
+{
+    Mat scratch, rotScratch( imgRef.size() * 2, CV_8UC1 ), matProbSpace;
+    GaussianBlur( imgRef, scratch, Size( 5, 5 ), 3.0 );
+    Point2d ptCenter( static_cast< double >( scratch.cols ) / 2.0, static_cast< double >( scratch.rows ) / 2.0 );
+
+    double maxScore = -9999999.0, score;
+    Point ptMax;
+    angle = -99999.0;
+    offset = Point( -1, -1 );
+    for ( int i = -15; i <= 15; ++i )
+    {
+        warpAffine( scratch, rotScratch, getRotationMatrix2D( ptCenter, static_cast< double >( i ) / 2.0, 1.0 ),
+                    rotScratch.size(), INTER_CUBIC );
+        matchTemplate( img, rotScratch( rect ), matProbSpace, TM_CCORR_NORMED );
+        minMaxLoc( matProbSpace, nullptr, &score, nullptr, &ptMax );
+        if ( score > maxScore )
+        {
+            angle = static_cast< double >( i ) / 2.0;
+            offset = ptMax - Point( rect.x, rect.y );
+            maxScore = score;
+        }
+    }
+}
+static void MoveImage( const Mat &img, Mat &moved )
+{
+    Point2d ptCenter( static_cast< double >( img.cols ) / 2.0, static_cast< double >( img.rows ) / 2.0 );
+    Mat matMove = getRotationMatrix2D( ptCenter, ANCHOR_MOVE_ANGLE, 1.0 );
+    matMove.at< double >( 0, 2 ) += static_cast< double >( ANCHOR_MOVE_SHIFT.x );
+    matMove.at< double >( 1, 2 ) += static_cast< double >( ANCHOR_MOVE_SHIFT.y );
+    warpAffine( img, moved, matMove, img.size(), INTER_CUBIC, BORDER_REPLICATE );
+}
+
+int main( int argc, char *argv[] )
+{
+    Output2FILE::Stream() = stderr;
+
+    vector< TestImage > images;
+    AddSyntheticImages( images );
+    if ( 1 < argc )
+        AddFolderImages( argv[ 1 ], images );
+    double tolerance = 2 < argc ? atof( argv[ 2 ] ) : 1e-4;
+
+    int failures = 0;
+    double spatialMsecs[ 2 ] = { 0.0, 0.0 }, dftMsecs[ 2 ] = { 0.0, 0.0 };
+    cout << "image,set,method,max_diff,spatial_exact_err,dft_exact_err,spatial_msecs,dft_msecs" << endl;
+    for ( size_t i = 0; i < images.size(); ++i )
+    {
+        const Mat &img = images[ i ].img;
+
+        // anchor models are cut from the image center and searched for in the whole image
+        vector< Mat > anchors;
+        Rect rectAnchor( img.cols / 2 - 80, img.rows / 2 - 50, 160, 100 );
+        MakeRotatedTemplates( img, rectAnchor, 31, 0.5, anchors );
+
+        // bowtie sized templates are searched for in a region half a template larger than the template
+        vector< Mat > bowties;
+        Rect rectBowtie( img.cols / 3, img.rows / 3, GC_BOWTIE_TEMPLATE_DIM, GC_BOWTIE_TEMPLATE_DIM );
+        MakeRotatedTemplates( img, rectBowtie, TEMPLATE_COUNT, 1.0, bowties );
+        Rect rectRefine( rectBowtie.x - ( rectBowtie.width >> 2 ), rectBowtie.y - ( rectBowtie.height >> 2 ),
+                         rectBowtie.width + ( rectBowtie.width >> 1 ), rectBowtie.height + ( rectBowtie.height >> 1 ) );
+
+        const int methods[ 2 ] = { TM_CCORR_NORMED, TM_CCOEFF_NORMED };
+        for ( size_t m = 0; m < 2; ++m )
+        {
+            for ( size_t set = 0; set < 2; ++set )
+            {
+                CompareResult result;
+                GC_STATUS retVal = 0 == set ? Compare( img, anchors, methods[ m ], result ) :
+                                              Compare( img( rectRefine ), bowties, methods[ m ], result );
+                if ( GC_OK != retVal || 0.0 > result.maxDiff || tolerance < result.maxDiff )
+                    ++failures;
+                spatialMsecs[ set ] += result.spatialMsecs;
+                dftMsecs[ set ] += result.dftMsecs;
+
+                cout << images[ i ].name << "," << ( 0 == set ? "anchor" : "bowtie" ) << ","
+                     << ( TM_CCORR_NORMED == methods[ m ] ? "ccorr_normed" : "ccoeff_normed" ) << ","
+                     << scientific << setprecision( 2 ) << result.maxDiff << "," << result.spatialErr << "," << result.dftErr << ","
+                     << fixed << result.spatialMsecs << "," << result.dftMsecs << endl;
+                cout.unsetf( ios::fixed | ios::scientific );
+            }
+        }
+    }
+
+    // the calibration target search must find the same targets with either engine
+    double maxTargetDist = 0.0;
+    cout << "image,spatial_targets,dft_targets,max_dist" << endl;
+    for ( size_t i = 1; i < images.size(); ++i )
+    {
+        vector< Point2d > ptsSpatial, ptsDFT;
+        GC_STATUS retSpatial = FindTargets( images[ i ].img, MATCH_ENGINE_SPATIAL, ptsSpatial );
+        GC_STATUS retDFT = FindTargets( images[ i ].img, MATCH_ENGINE_DFT, ptsDFT );
+        double dist = -1.0;
+        if ( retSpatial == retDFT && ptsSpatial.size() == ptsDFT.size() )
+        {
+            dist = 0.0;
+            for ( size_t j = 0; j < ptsSpatial.size(); ++j )
+                dist = std::max( dist, norm( ptsSpatial[ j ] - ptsDFT[ j ] ) );
+            maxTargetDist = std::max( maxTargetDist, dist );
+        }
+        else
+        {
+            ++failures;
+        }
+        cout << images[ i ].name << "," << ( GC_OK == retSpatial ? "found" : "not found" ) << ","
+             << ( GC_OK == retDFT ? "found" : "not found" ) << "," << fixed << setprecision( 4 ) << dist << endl;
+        cout.unsetf( ios::fixed );
+    }
+
+    // the anchor search must find the same angle and offset with either engine and as the serial search
+    fs::path refFilepath = fs::temp_directory_path() / fs::unique_path( "anchor_ref_%%%%%%%%.png" );
+    cout << "image,serial_angle,serial_x,serial_y,spatial_angle,spatial_x,spatial_y,dft_angle,dft_x,dft_y" << endl;
+    for ( size_t i = 0; i < images.size(); ++i )
+    {
+        const Mat &img = images[ i ].img;
+        Rect rectAnchor( img.cols / 2 - 80, img.rows / 2 - 50, 160, 100 );
+        Mat moved;
+        MoveImage( img, moved );
+
+        double angleSpatial = -99999.0, angleDFT = -99999.0;
+        Point offsetSpatial( -1, -1 ), offsetDFT( -1, -1 );
+        GC_STATUS retSpatial = imwrite( refFilepath.string(), img ) ? GC_OK : GC_ERR;
+        GC_STATUS retDFT = retSpatial;
+        if ( GC_OK == retSpatial )
+        {
+            retSpatial = FindAnchorModel( refFilepath.string(), rectAnchor, moved, MATCH_ENGINE_SPATIAL, angleSpatial, offsetSpatial );
+            retDFT = FindAnchorModel( refFilepath.string(), rectAnchor, moved, MATCH_ENGINE_DFT, angleDFT, offsetDFT );
+        }
+        double angleSerial;
+        Point offsetSerial;
+        FindAnchorSerial( img, rectAnchor, moved, angleSerial, offsetSerial );
+        if ( GC_OK != retSpatial || GC_OK != retDFT || angleSpatial != angleDFT || offsetSpatial != offsetDFT ||
+             angleSerial != angleSpatial || offsetSerial != offsetSpatial )
+            ++failures;
+        cout << images[ i ].name << "," << angleSerial << "," << offsetSerial.x << "," << offsetSerial.y << "," << angleSpatial << "," << offsetSpatial.x << "," << offsetSpatial.y << ","
+             << angleDFT << "," << offsetDFT.x << "," << offsetDFT.y << endl;
+    }
+    fs::remove( refFilepath );
+
+    cout << fixed << setprecision( 1 ) << "total anchor msecs spatial=" << spatialMsecs[ 0 ] << " dft=" << dftMsecs[ 0 ]
+         << " bowtie msecs spatial=" << spatialMsecs[ 1 ] << " dft=" << dftMsecs[ 1 ] << endl;
+    cout << setprecision( 4 ) << "max target distance=" << maxTargetDist << endl;
+    cout << ( 0 == failures ? "PASS" : "FAIL" ) << " failures=" << failures << " tolerance=" << scientific << tolerance << endl;
+
+    return 0 == failures ? 0 : -1;
+}
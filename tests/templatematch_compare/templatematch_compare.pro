@@ -0,0 +1,16 @@
+TEMPLATE = app
+include( ../tests.pri )
+
+SOURCES += \
+        ../../algorithms/findanchor.cpp \
+        ../../algorithms/findcalibgrid.cpp \
+        ../../algorithms/templatematchdft.cpp \
+        main.cpp
+
+HEADERS += \
+    ../elapsedtime.h \
+    ../../algorithms/findanchor.h \
+    ../../algorithms/findcalibgrid.h \
+    ../../algorithms/gc_types.h \
+    ../../algorithms/log.h \
+    ../../algorithms/templatematchdft.h
@@ -0,0 +1,72 @@
+# Settings shared by the check and benchmark apps
+CONFIG += console c++11 thread
+CONFIG -= app_bundle
+CONFIG -= qt
+
+DEFINES += BOOST_ALL_NO_LIB BOOST_BIND_GLOBAL_PLACEHOLDERS
+
+INCLUDEPATH += $$PWD $$PWD/../algorithms
+
+win32 {
+    DEFINES += NOMINMAX
+    DEFINES += WIN32_LEAN_AND_MEAN
+    DEFINES += _WIN32_WINNT=0x0501
+    OPENCV_INCLUDES = c:/opencv/opencv_451/include
+    OPENCV_LIBS = C:/opencv/opencv_451/x64/lib/vc19
+    BOOST_INCLUDES = C:/local/boost_1_74_0
+    BOOST_LIBS = C:/local/boost_1_74_0/stage/lib
+}
+
+unix:!macx {
+    INCLUDEPATH +=  /usr/local/include \
+                    /usr/local/include/opencv4
+
+    LIBS += -L/usr/local/lib \
+            -lopencv_core \
+            -lopencv_imgproc \
+            -lopencv_imgcodecs \
+            -lopencv_videoio \
+            -lopencv_video \
+            -lopencv_calib3d \
+            -lboost_date_time \
+            -lboost_system \
+            -lboost_filesystem \
+            -lboost_chrono
+}
+else {
+    INCLUDEPATH += $$BOOST_INCLUDES \
+                   $$OPENCV_INCLUDES
+    DEPENDPATH += $$BOOST_INCLUDES \
+                  $$BOOST_LIBS \
+                  $$OPENCV_INCLUDES \
+                  $$OPENCV_LIBS
+
+    LIBS += -L$$BOOST_LIBS \
+            -L$$OPENCV_LIBS
+
+    CONFIG(debug, debug|release) {
+        LIBS += -lopencv_core451d \
+                -lopencv_imgproc451d \
+                -lopencv_imgcodecs451d \
+                -lopencv_videoio451d \
+                -lopencv_video451d \
+                -lopencv_calib3d451d \
+                -llibboost_filesystem-vc142-mt-gd-x64-1_74 \
+                -llibboost_date_time-vc142-mt-gd-x64-1_74 \
+                -llibboost_system-vc142-mt-gd-x64-1_74 \
+                -llibboost_chrono-vc142-mt-gd-x64-1_74 \
+                -ladvapi32
+    } else {
+        LIBS += -lopencv_core451 \
+                -lopencv_imgproc451 \
+                -lopencv_imgcodecs451 \
+                -lopencv_videoio451 \
+                -lopencv_video451 \
+                -lopencv_calib3d451 \
+                -llibboost_filesystem-vc142-mt-x64-1_74 \
+                -llibboost_date_time-vc142-mt-x64-1_74 \
+                -llibboost_system-vc142-mt-x64-1_74 \
+                -llibboost_chrono-vc142-mt-x64-1_74 \
+                -ladvapi32
+    }
+}
@@ -0,0 +1,12 @@
+# Checks and benchmarks of the algorithms library, the image checks run against the sample
+# images in gcgui/config/2012_demo. Each one is a console app that prints its results and
+# exits nonzero when a check fails.
+TEMPLATE = subdirs
+SUBDIRS = bowtie_compare \
+          csvreader_check \
+          entropymap_regress \
+          findline_bench \
+          median_bench \
+          resultstore_check \
+          templatematch_compare \
+          variancemap_regress
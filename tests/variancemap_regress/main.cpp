@@ -0,0 +1,197 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+   Copyright 2021 Kenneth W. Chapman
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/** \file main.cpp
+ * @brief Checks the integral image variance map against a box filter variance map
+ *
+ * VarianceMap::CreateMap() must give the map of a reference that box filters the image and
+ * its square in double precision, with the same kernel placement, zero border, mask, and
+ * scaling, to within the tolerance. The maps are compared for even and odd kernel sizes with
+ * and without a mask on noise and gradient images, on an image large enough for CreateMap()
+ * to use 64-bit integral sums and, when a folder is given, on every jpg and png image below it.
+ *
+ * variancemap_regress [image folder] [tolerance in scaled gray levels, default 1e-3]
+ *
+ * e.g. variancemap_regress gcgui/config/2012_demo
+ *
+ * \author Kenneth W. Chapman
+ * \copyright Copyright (C) 2010-2021, Kenneth W. Chapman <coffeesig@gmail.com>, all rights reserved.\n
+ * This project is released under the Apache License, Version 2.0.
+ * \bug No known bugs.
+ */
+
+#include "log.h"
+#include "variancemap.h"
+#include "elapsedtime.h"
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <climits>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <boost/filesystem.hpp>
+
+using namespace cv;
+using namespace std;
+using namespace gc;
+namespace fs = boost::filesystem;
+
+static const int KERNEL_SIZES[] = { 3, 8, 9, 15 };
+
+class TestImage
+{
+public:
+    TestImage( const string imgName, const Mat &image ) : name( imgName ), img( image ) {}
+
+    string name;
+    Mat img;
+};
+
+static Mat NoiseImage( mt19937 &gen, const int cols, const int rows )
+{
+    uniform_int_distribution< int > level( 0, 255 );
+    Mat noise( rows, cols, CV_8UC1 );
+    for ( int row = 0; row < noise.rows; ++row )
+    {
+        for ( int col = 0; col < noise.cols; ++col )
+            noise.at< uchar >( row, col ) = static_cast< uchar >( level( gen ) );
+    }
+    return noise;
+}
+static void AddSyntheticImages( vector< TestImage > &images )
+{
+    mt19937 gen( 42 );
+    images.push_back( TestImage( "noise_257x131", NoiseImage( gen, 257, 131 ) ) );
+
+    Mat gradient( 203, 322, CV_8UC1 );
+    for ( int row = 0; row < gradient.rows; ++row )
+    {
+        for ( int col = 0; col < gradient.cols; ++col )
+            gradient.at< uchar >( row, col ) = saturate_cast< uchar >( ( row + col ) * 255 / ( gradient.rows + gradient.cols ) );
+    }
+    images.push_back( TestImage( "gradient_322x203", gradient ) );
+
+    // 255 times the pixel count is more than INT_MAX, so CreateMap() uses 64-bit integral sums
+    images.push_back( TestImage( "noise_3001x2901", NoiseImage( gen, 3001, 2901 ) ) );
+}
+static void AddFolderImages( const string folder, vector< TestImage > &images )
+{
+    vector< string > filepaths;
+    for ( fs::recursive_directory_iterator it( folder ), end; it != end; ++it )
+    {
+        string ext = it->path().extension().string();
+        if ( fs::is_regular_file( it->path() ) && ( ".jpg" == ext || ".png" == ext ) )
+            filepaths.push_back( it->path().string() );
+    }
+    sort( filepaths.begin(), filepaths.end() );
+    for ( size_t i = 0; i < filepaths.size(); ++i )
+    {
+        Mat img = imread( filepaths[ i ], IMREAD_GRAYSCALE );
+        if ( img.empty() )
+            cout << "Could not read " << filepaths[ i ] << endl;
+        else
+            images.push_back( TestImage( fs::path( filepaths[ i ] ).filename().string(), img ) );
+    }
+}
+// variance of every kernel that fits in the image from box filters of the image and its square,
+// the kernel of a pixel starts kernSize / 2 pixels above and left of it as in CreateMap()
+static void BoxFilterVarianceMap( const Mat &src, Mat &dst, const int kernSize, const Mat &mask )
+{
+    int kernHalf = kernSize >> 1;
+    Mat img64, mean, sqMean;
+    src.convertTo( img64, CV_64F );
+    boxFilter( img64, mean, CV_64F, Size( kernSize, kernSize ), Point( kernHalf, kernHalf ), true, BORDER_CONSTANT );
+    boxFilter( img64.mul( img64 ), sqMean, CV_64F, Size( kernSize, kernSize ), Point( kernHalf, kernHalf ), true, BORDER_CONSTANT );
+
+    Mat variance = Mat::zeros( src.size(), CV_32F );
+    Rect inner( kernHalf, kernHalf, src.cols - 2 * kernHalf, src.rows - 2 * kernHalf );
+    Mat innerVariance = sqMean( inner ) - mean( inner ).mul( mean( inner ) );
+    innerVariance.convertTo( variance( inner ), CV_32F );
+    if ( !mask.empty() )
+        variance.setTo( 0.0, 0 == mask );
+
+    double dMin, dMax;
+    minMaxIdx( variance, &dMin, &dMax );
+    variance.convertTo( dst, CV_32F, 255.0 / dMax );
+}
+
+int main( int argc, char *argv[] )
+{
+    Output2FILE::Stream() = stderr;
+
+    vector< TestImage > images;
+    AddSyntheticImages( images );
+    if ( 1 < argc )
+        AddFolderImages( argv[ 1 ], images );
+    double tolerance = 2 < argc ? atof( argv[ 2 ] ) : 1e-3;
+
+    int failures = 0;
+    double integralMsecs = 0.0;
+    double boxMsecs = 0.0;
+    VarianceMap variance;
+    Mat mapIntegral, mapBox;
+
+    cout << "image,kernel,mask,sum_bits,max_diff,integral_msecs,box_msecs" << endl;
+    for ( size_t i = 0; i < images.size(); ++i )
+    {
+        const Mat &img = images[ i ].img;
+        int sumBits = 255.0 * static_cast< double >( img.total() ) > static_cast< double >( INT_MAX ) ? 64 : 32;
+
+        // an elliptical mask in the middle of the image
+        Mat mask = Mat::zeros( img.size(), CV_8UC1 );
+        ellipse( mask, Point( img.cols / 2, img.rows / 2 ), Size( img.cols / 3, img.rows / 3 ), 0.0, 0.0, 360.0, Scalar( 255 ), FILLED );
+
+        for ( size_t k = 0; k < sizeof( KERNEL_SIZES ) / sizeof( KERNEL_SIZES[ 0 ] ); ++k )
+        {
+            for ( int useMask = 0; useMask < 2; ++useMask )
+            {
+                const Mat &kernMask = 1 == useMask ? mask : Mat();
+
+                // CreateMap() scales into the type of dst, a float map keeps the full precision
+                mapIntegral.create( img.size(), CV_32F );
+                chrono::steady_clock::time_point start = chrono::steady_clock::now();
+                GC_STATUS retIntegral = variance.CreateMap( img, mapIntegral, KERNEL_SIZES[ k ], kernMask );
+                double msecsIntegral = MsecsSince( start );
+
+                start = chrono::steady_clock::now();
+                BoxFilterVarianceMap( img, mapBox, KERNEL_SIZES[ k ], kernMask );
+                double msecsBox = MsecsSince( start );
+
+                double maxDiff = -1.0;
+                if ( GC_OK == retIntegral && mapIntegral.size() == mapBox.size() && mapIntegral.type() == mapBox.type() )
+                    maxDiff = norm( mapIntegral, mapBox, NORM_INF );
+                if ( 0.0 > maxDiff || tolerance < maxDiff )
+                    ++failures;
+                integralMsecs += msecsIntegral;
+                boxMsecs += msecsBox;
+
+                cout << images[ i ].name << "," << KERNEL_SIZES[ k ] << "," << useMask << "," << sumBits << ","
+                     << scientific << setprecision( 2 ) << maxDiff << ","
+                     << fixed << msecsIntegral << "," << msecsBox << endl;
+                cout.unsetf( ios::fixed | ios::scientific );
+            }
+        }
+    }
+
+    cout << fixed << setprecision( 1 ) << "total integral msecs=" << integralMsecs << " box filter msecs=" << boxMsecs << endl;
+    cout << ( 0 == failures ? "PASS" : "FAIL" ) << " failures=" << failures << " tolerance=" << scientific << tolerance << endl;
+
+    return 0 == failures ? 0 : -1;
+}